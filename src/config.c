@@ -4,13 +4,10 @@
 #include <stdlib.h>
 #include <string.h>
 
-// Global configuration variable.
-struct CupidConfig g_userConfig;
-
 // Mapping of module names to their functions.
 struct module {
     char *s;
-    void (*m)();
+    cf_module_fn m;
 };
 struct module string_to_module[] = {
     {"hostname", get_hostname},
@@ -39,6 +36,12 @@ struct module string_to_module[] = {
     {"memory", get_available_memory},
     {"storage", get_available_storage},
     {"cpu", get_cpu},
+    {"pressure", get_pressure},
+    {"psi", get_pressure},
+    {"cgroup", get_cgroup},
+    {"top", get_top},
+    {"sensors", get_sensors},
+    {"gpu_usage", get_gpu_usage},
 };
 
 static bool eq_icase(const char *a, const char *b) {
@@ -75,7 +78,7 @@ static bool parse_bool_value(const char *value, bool fallback) {
     return fallback;
 }
 
-void init_g_config() {
+void init_config(struct CupidConfig *config) {
     // Set up the default configuration.
     struct CupidConfig cfg_ = {
         .modules = { get_hostname, get_username, get_distro, get_linux_kernel,
@@ -87,42 +90,84 @@ void init_g_config() {
                      NULL },
         .memory_unit = "MB",
         .memory_unit_size = 1000000,
+        .memory_detailed = false,
         .storage_unit = "GB",
         .storage_unit_size = 1000000000,
         .network_show_full_public_ip = false,
+        .cgroup_aware = true,
+        .top_count = 5,
+        .io_uring = false,
     };
-    g_userConfig = cfg_;
+    *config = cfg_;
+}
+
+// Builds "<config dir>/cupidfetch/<name>", where the config dir is
+// $XDG_CONFIG_HOME, %APPDATA% on Windows, or ~/.config. Returns false, with
+// `out` empty, when there is no config dir and no home directory.
+bool get_config_file_path(const char *name, char *out, size_t out_size) {
+    const char *config_dir = getenv("XDG_CONFIG_HOME");
+#ifdef _WIN32
+    if (!config_dir || !config_dir[0]) {
+        config_dir = getenv("APPDATA");
+    }
+#endif
+    if (config_dir) {
+        snprintf(out, out_size, "%s/cupidfetch/%s", config_dir, name);
+        return true;
+    }
+
+    // A throwaway context: the same $HOME-then-passwd lookup the modules
+    // use, with the result in a buffer this call owns.
+    struct cf_context ctx;
+    cf_context_init(&ctx, NULL, NULL);
+    const char *home = cf_ctx_home(&ctx);
+    if (!home) {
+        if (out_size > 0) out[0] = '\0';
+        return false;
+    }
+    snprintf(out, out_size, "%s/.config/cupidfetch/%s", home, name);
+    return true;
+}
+
+bool config_set_modules(struct CupidConfig *config, const char *names) {
+    char buffer[1024];
+    strncpy(buffer, names, sizeof(buffer));
+    buffer[sizeof(buffer)-1] = '\0';
+
+    bool all_known = true;
+    char *save = NULL;
+    char *token = strtok_r(buffer, " ", &save);
+    size_t mi = 0;
+    while (token) {
+        bool known = false;
+        for (size_t i = 0; i < sizeof(string_to_module)/sizeof(string_to_module[0]); i++) {
+            if (strcmp(token, string_to_module[i].s) == 0) {
+                if (mi < MAX_NUM_MODULES) {
+                    config->modules[mi] = string_to_module[i].m;
+                    mi++;
+                }
+                known = true;
+                break;
+            }
+        }
+        if (!known) all_known = false;
+        token = strtok_r(NULL, " ", &save);
+    }
+    config->modules[mi] = NULL;
+    return all_known;
 }
 
-void load_config_file(const char* config_path, struct CupidConfig *config) {
+bool load_config_file(const char* config_path, struct CupidConfig *config) {
     cupidconf_t *conf = cupidconf_load(config_path);
     if (!conf) {
         cupid_log(LogType_WARNING, "Failed to load config file: %s", config_path);
-        return;
+        return false;
     }
 
     /* --- Load the list of modules --- */
     const char* modules_str = cupidconf_get(conf, "modules");
     if (modules_str) {
-        char buffer[1024];
-        strncpy(buffer, modules_str, sizeof(buffer));
-        buffer[sizeof(buffer)-1] = '\0';
-
-        char *token = strtok(buffer, " ");
-        size_t mi = 0;
-        while (token) {
-            for (size_t i = 0; i < sizeof(string_to_module)/sizeof(string_to_module[0]); i++) {
-                if (strcmp(token, string_to_module[i].s) == 0) {
-                    if (mi < MAX_NUM_MODULES) {
-                        config->modules[mi] = string_to_module[i].m;
-                        mi++;
-                    }
-                    break;
-                }
-            }
-            token = strtok(NULL, " ");
-        }
-        config->modules[mi] = NULL;
+        config_set_modules(config, modules_str);
     }
 
     /* --- Load memory settings --- */
@@ -135,6 +180,8 @@ void load_config_file(const char* config_path, struct CupidConfig *config) {
     if (mem_unit_size_str) {
         config->memory_unit_size = atol(mem_unit_size_str);
     }
+    const char *mem_detailed = cupidconf_get(conf, "memory.detailed");
+    config->memory_detailed = parse_bool_value(mem_detailed, config->memory_detailed);
 
     /* --- Load storage settings --- */
     const char *stor_unit = cupidconf_get(conf, "storage.unit-str");
@@ -154,5 +201,23 @@ void load_config_file(const char* config_path, struct CupidConfig *config) {
         config->network_show_full_public_ip
     );
 
+    /* --- Load cgroup settings --- */
+    const char *cgroup_aware = cupidconf_get(conf, "cgroup.aware");
+    config->cgroup_aware = parse_bool_value(cgroup_aware, config->cgroup_aware);
+
+    /* --- Load top settings --- */
+    const char *top_count_str = cupidconf_get(conf, "top.count");
+    if (top_count_str) {
+        long top_count = atol(top_count_str);
+        if (top_count < 0) top_count = 0;
+        if (top_count > MAX_TOP_COUNT) top_count = MAX_TOP_COUNT;
+        config->top_count = (unsigned int)top_count;
+    }
+
+    /* --- Load I/O settings --- */
+    const char *io_uring = cupidconf_get(conf, "io.uring");
+    config->io_uring = parse_bool_value(io_uring, config->io_uring);
+
     cupidconf_free(conf);
+    return true;
 }
@@ -0,0 +1,191 @@
+// File: context.c
+// -----------------------
+#include "cupidfetch.h"
+#include "modules/common/module_helpers.h"
+
+#define CTX_USERNAME 0x01u
+#define CTX_HOSTNAME 0x02u
+#define CTX_HOME 0x04u
+#define CTX_SHELL 0x08u
+#define CTX_KERNEL 0x10u
+#define CTX_BOOT_ID 0x20u
+#define CTX_TERMINAL 0x40u
+#define CTX_PASSWD 0x80u
+
+// `state` may be NULL: modules then report rates since boot instead of
+// since the previous fetch.
+void cf_context_init(struct cf_context *ctx, const struct CupidConfig *config, struct cf_state *state) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->config = config;
+    ctx->state = state;
+}
+
+void cf_state_release(struct cf_state *state) {
+    if (!state) return;
+    gpu_usage_state_free(state->gpu_usage);
+    cf_read_ring_free(state->read_ring);
+    memset(state, 0, sizeof(*state));
+}
+
+static void copy_value(char *dest, size_t dest_size, const char *value) {
+    snprintf(dest, dest_size, "%s", value ? value : "");
+}
+
+static const char *nonempty(const char *value) {
+    return value && value[0] ? value : NULL;
+}
+
+static const char *getenv_nonempty(const char *name) {
+    return nonempty(getenv(name));
+}
+
+#ifndef _WIN32
+// One getpwuid_r() per fetch: on LDAP/SSSD hosts every lookup is an NSS
+// round trip.
+static void load_passwd(struct cf_context *ctx) {
+    if (ctx->loaded & CTX_PASSWD) return;
+    ctx->loaded |= CTX_PASSWD;
+
+    long suggested = sysconf(_SC_GETPW_R_SIZE_MAX);
+    size_t size = suggested > 0 ? (size_t)suggested : 4096;
+    for (int attempt = 0; attempt < 4; attempt++, size *= 4) {
+        char *buffer = malloc(size);
+        if (!buffer) return;
+
+        struct passwd pw;
+        struct passwd *found = NULL;
+        int rc = getpwuid_r(geteuid(), &pw, buffer, size, &found);
+        if (rc == 0 && found) {
+            copy_value(ctx->pw_name, sizeof(ctx->pw_name), found->pw_name);
+            copy_value(ctx->pw_dir, sizeof(ctx->pw_dir), found->pw_dir);
+            copy_value(ctx->pw_shell, sizeof(ctx->pw_shell), found->pw_shell);
+        }
+        free(buffer);
+        if (rc != ERANGE) return;
+    }
+}
+#endif
+
+const char *cf_ctx_username(struct cf_context *ctx) {
+    if (!(ctx->loaded & CTX_USERNAME)) {
+        ctx->loaded |= CTX_USERNAME;
+        const char *username = getenv_nonempty("USER");
+#ifdef _WIN32
+        if (!username) username = getenv_nonempty("USERNAME");
+#else
+        // getlogin() shares one static buffer between threads.
+        char login[sizeof(ctx->username)];
+        if (!username && getlogin_r(login, sizeof(login)) == 0) username = nonempty(login);
+        if (!username) {
+            load_passwd(ctx);
+            username = nonempty(ctx->pw_name);
+        }
+#endif
+        copy_value(ctx->username, sizeof(ctx->username), username);
+    }
+    return nonempty(ctx->username);
+}
+
+const char *cf_ctx_hostname(struct cf_context *ctx) {
+    if (!(ctx->loaded & CTX_HOSTNAME)) {
+        ctx->loaded |= CTX_HOSTNAME;
+#ifdef _WIN32
+        copy_value(ctx->hostname, sizeof(ctx->hostname), getenv("COMPUTERNAME"));
+#else
+        if (gethostname(ctx->hostname, sizeof(ctx->hostname)) != 0) ctx->hostname[0] = '\0';
+        ctx->hostname[sizeof(ctx->hostname) - 1] = '\0';
+#endif
+    }
+    return nonempty(ctx->hostname);
+}
+
+const char *cf_ctx_home(struct cf_context *ctx) {
+    if (!(ctx->loaded & CTX_HOME)) {
+        ctx->loaded |= CTX_HOME;
+#ifdef _WIN32
+        const char *home = getenv_nonempty("USERPROFILE");
+        if (!home) home = getenv_nonempty("HOME");
+#else
+        const char *home = getenv_nonempty("HOME");
+        if (!home) {
+            load_passwd(ctx);
+            home = nonempty(ctx->pw_dir);
+        }
+#endif
+        copy_value(ctx->home, sizeof(ctx->home), home);
+    }
+    return nonempty(ctx->home);
+}
+
+const char *cf_ctx_shell(struct cf_context *ctx) {
+    if (!(ctx->loaded & CTX_SHELL)) {
+        ctx->loaded |= CTX_SHELL;
+#ifdef _WIN32
+        const char *shell = getenv_nonempty("ComSpec");
+        if (!shell) shell = "cmd.exe";
+#else
+        const char *shell = getenv_nonempty("SHELL");
+        if (!shell) {
+            load_passwd(ctx);
+            shell = nonempty(ctx->pw_shell);
+        }
+#endif
+        copy_value(ctx->shell, sizeof(ctx->shell), shell);
+    }
+    return nonempty(ctx->shell);
+}
+
+const char *cf_ctx_kernel_release(struct cf_context *ctx) {
+#ifdef _WIN32
+    (void)ctx;
+    return NULL;
+#else
+    if (!(ctx->loaded & CTX_KERNEL)) {
+        ctx->loaded |= CTX_KERNEL;
+        struct utsname uname_data;
+        if (uname(&uname_data) == 0) copy_value(ctx->kernel_release, sizeof(ctx->kernel_release), uname_data.release);
+    }
+    return nonempty(ctx->kernel_release);
+#endif
+}
+
+const char *cf_ctx_boot_id(struct cf_context *ctx) {
+#ifdef _WIN32
+    (void)ctx;
+    return NULL;
+#else
+    if (!(ctx->loaded & CTX_BOOT_ID)) {
+        ctx->loaded |= CTX_BOOT_ID;
+        if (!cf_read_first_line("/proc/sys/kernel/random/boot_id", ctx->boot_id, sizeof(ctx->boot_id))) {
+            ctx->boot_id[0] = '\0';
+        }
+    }
+    return nonempty(ctx->boot_id);
+#endif
+}
+
+// NULL under --force-distro, so the distro name and logo follow the forced
+// distro instead of the host.
+const struct cf_os_release *cf_ctx_os_release(struct cf_context *ctx) {
+    if (ctx->forced_distro[0] != '\0') return NULL;
+    return get_os_release();
+}
+
+// 0 for a dimension the terminal doesn't report (not a tty, say).
+void cf_ctx_terminal_size(struct cf_context *ctx, int *cols_out, int *rows_out) {
+    if (!(ctx->loaded & CTX_TERMINAL)) {
+        ctx->loaded |= CTX_TERMINAL;
+        get_terminal_size(&ctx->terminal_cols, &ctx->terminal_rows);
+    }
+    if (cols_out) *cols_out = ctx->terminal_cols;
+    if (rows_out) *rows_out = ctx->terminal_rows;
+}
+
+// Lives in `state` so watch mode and repeated collects set the ring up
+// once; NULL (plain reads) unless io.uring is on and there is a state to
+// keep it in.
+struct cf_read_ring *cf_ctx_read_ring(struct cf_context *ctx) {
+    if (!ctx->state || !ctx->config || !ctx->config->io_uring) return NULL;
+    if (!ctx->state->read_ring) ctx->state->read_ring = cf_read_ring_new();
+    return ctx->state->read_ring;
+}
@@ -50,6 +50,9 @@
     #ifndef strncasecmp
         #define strncasecmp _strnicmp
     #endif
+    #ifndef strtok_r
+        #define strtok_r strtok_s
+    #endif
 #else
     #include <arpa/inet.h>
     #include <ifaddrs.h>
@@ -64,14 +67,70 @@
 #define CONFIG_PATH_SIZE 256
 #define LINUX_PROC_LINE_SZ 128
 #define MEMORY_UNIT_LEN 128
+#define MAX_TOP_COUNT 20
+
+struct cf_cpu_sample {
+    bool valid;
+    unsigned long long idle;
+    unsigned long long total;
+};
+
+struct gpu_usage_state;
+struct cf_read_ring;
+
+// Samples a module keeps from one fetch to the next so it can report a
+// rate (CPU and GPU busy percentages in watch mode), and the io_uring the
+// batched readers reuse. Owned by the caller, zero-initialised, and used
+// by one fetch at a time.
+struct cf_state {
+    struct cf_cpu_sample cpu;
+    struct gpu_usage_state *gpu_usage;
+    struct cf_read_ring *read_ring;
+};
+
+// Facts several modules and the panel need, each looked up on first use
+// and then shared for the rest of one fetch. Every fetch starts from a
+// fresh cf_context_init(), so watch mode sees a renamed host or a resized
+// terminal on its next redraw.
+struct cf_context {
+    unsigned int loaded;
+    const struct CupidConfig *config;
+    struct cf_state *state;
+    // Non-empty under --force-distro: the host's os-release is then ignored.
+    char forced_distro[128];
+    char distro[256];
+    char username[256];
+    char hostname[256];
+    char home[512];
+    char shell[256];
+    char kernel_release[128];
+    char boot_id[64];
+    int terminal_cols;
+    int terminal_rows;
+    char pw_name[256];
+    char pw_dir[512];
+    char pw_shell[256];
+};
+
+// Where modules report their lines; see print.c.
+struct cf_sink;
+
+// A module reads through `ctx` and reports through print_info(sink, ...).
+// Neither is shared with another fetch, so modules of different fetches
+// may run on different threads.
+typedef void (*cf_module_fn)(struct cf_context *ctx, struct cf_sink *sink);
 
 struct CupidConfig {
-    void (*modules[MAX_NUM_MODULES + 1])(void);
+    cf_module_fn modules[MAX_NUM_MODULES + 1];
     char memory_unit[MEMORY_UNIT_LEN];
     unsigned long memory_unit_size;
+    bool memory_detailed;
     char storage_unit[MEMORY_UNIT_LEN];
     unsigned long storage_unit_size;
     bool network_show_full_public_ip;
+    bool cgroup_aware;
+    unsigned int top_count;
+    bool io_uring;
 };
 
 typedef enum {
@@ -82,49 +141,104 @@ typedef enum {
 } LogType;
 
 // print.c
+void get_terminal_size(int *cols_out, int *rows_out);
 int get_terminal_width();
-void print_info(const char *key, const char *format, int align_key, int align_value, ...);
+// A NULL sink prints the line straight to stdout.
+void print_info(struct cf_sink *sink, const char *key, const char *format, int align_key, int align_value, ...);
 void print_cat(const char* distro);
-void begin_info_capture(void);
-void end_info_capture(void);
-void render_fetch_panel(const char *distro, const char *user_host);
-void render_json_output(const char *user_host);
+
+// Typed results: cf_emit_line() starts a line and the cf_emit_*() calls
+// after it append values to it. A named value becomes a JSON field in its
+// own type; a NULL name only adds panel text (" / ", "busy", ...).
+enum cf_value_type { CF_VALUE_STR, CF_VALUE_U64, CF_VALUE_PERCENT, CF_VALUE_BYTES };
+// Which configured unit (memory.unit-* or storage.unit-*) the panel uses.
+enum cf_byte_unit { CF_BYTES_MEMORY, CF_BYTES_STORAGE };
+// Strings point into the sink and last until its next reset.
+struct cf_value {
+    enum cf_value_type type;
+    const char *name;
+    unsigned long long u64;  // CF_VALUE_U64, CF_VALUE_BYTES
+    const char *unit;        // CF_VALUE_U64, e.g. "MHz"; "" otherwise
+    double percent;
+    int decimals;
+    const char *text;        // CF_VALUE_STR; "" otherwise
+};
+void cf_emit_line(struct cf_sink *sink, const char *label);
+void cf_emit_str(struct cf_sink *sink, const char *name, const char *text);
+void cf_emit_u64(struct cf_sink *sink, const char *name, unsigned long long value, const char *unit);
+void cf_emit_percent(struct cf_sink *sink, const char *name, double percent, int decimals);
+void cf_emit_bytes(struct cf_sink *sink, const char *name, unsigned long long bytes, enum cf_byte_unit unit);
+
+// `config` supplies the units bytes are shown in; it must outlive the sink.
+struct cf_sink *cf_sink_new(const struct CupidConfig *config);
+void cf_sink_reset(struct cf_sink *sink);
+void cf_sink_free(struct cf_sink *sink);
+size_t cf_sink_count(const struct cf_sink *sink);
+// Entry `index` as its JSON key (unique within the sink), panel label and value.
+void cf_sink_entry(const struct cf_sink *sink, size_t index, const char **key, const char **label, const char **text);
+// The named values of entry `index`, in emit order.
+const struct cf_value *cf_sink_values(const struct cf_sink *sink, size_t index, size_t *count_out);
+void render_fetch_panel(FILE *out, struct cf_context *ctx, const struct cf_sink *sink, const char *distro, const char *user_host);
+void render_json_output(FILE *out, const struct cf_sink *sink, const char *user_host);
 
 // modules.c
-void get_hostname();
-void get_username();
-void get_linux_kernel();
-void get_uptime();
-void get_distro();
-void get_package_count();
-void get_shell();
-void get_terminal();
-void get_desktop_environment();
-void get_window_manager();
-void get_theme();
-void get_icons();
-void get_display_server();
-void get_net();
-void get_local_ip();
-void get_battery();
-void get_gpu();
-void get_available_memory();
-void get_cpu();
-void get_available_storage();
-const char* get_home_directory();
+void get_hostname(struct cf_context *ctx, struct cf_sink *sink);
+void get_username(struct cf_context *ctx, struct cf_sink *sink);
+void get_linux_kernel(struct cf_context *ctx, struct cf_sink *sink);
+void get_uptime(struct cf_context *ctx, struct cf_sink *sink);
+void get_distro(struct cf_context *ctx, struct cf_sink *sink);
+void get_package_count(struct cf_context *ctx, struct cf_sink *sink);
+void get_shell(struct cf_context *ctx, struct cf_sink *sink);
+void get_terminal(struct cf_context *ctx, struct cf_sink *sink);
+void get_desktop_environment(struct cf_context *ctx, struct cf_sink *sink);
+void get_window_manager(struct cf_context *ctx, struct cf_sink *sink);
+void get_theme(struct cf_context *ctx, struct cf_sink *sink);
+void get_icons(struct cf_context *ctx, struct cf_sink *sink);
+void get_display_server(struct cf_context *ctx, struct cf_sink *sink);
+void get_net(struct cf_context *ctx, struct cf_sink *sink);
+void get_local_ip(struct cf_context *ctx, struct cf_sink *sink);
+void get_battery(struct cf_context *ctx, struct cf_sink *sink);
+void get_gpu(struct cf_context *ctx, struct cf_sink *sink);
+void get_available_memory(struct cf_context *ctx, struct cf_sink *sink);
+void get_cpu(struct cf_context *ctx, struct cf_sink *sink);
+void get_available_storage(struct cf_context *ctx, struct cf_sink *sink);
+void get_pressure(struct cf_context *ctx, struct cf_sink *sink);
+void get_cgroup(struct cf_context *ctx, struct cf_sink *sink);
+void get_top(struct cf_context *ctx, struct cf_sink *sink);
+void get_sensors(struct cf_context *ctx, struct cf_sink *sink);
+void get_gpu_usage(struct cf_context *ctx, struct cf_sink *sink);
+void gpu_usage_state_free(struct gpu_usage_state *state);
 
 // config.c
-extern struct CupidConfig g_userConfig;
-void init_g_config();
+void init_config(struct CupidConfig *config);
+bool get_config_file_path(const char *name, char *out, size_t out_size);
+// Space-separated module names, as in the config file. Unknown names are
+// skipped; returns false if there were any.
+bool config_set_modules(struct CupidConfig *config, const char *names);
 // New function to load configuration using cupidconf:
-void load_config_file(const char* config_path, struct CupidConfig *config);
+bool load_config_file(const char* config_path, struct CupidConfig *config);
 
 // log.c
-void cupid_log(LogType ltp, const char *format, ...);
-
-// main.c
 extern FILE *g_log;
-const char* detect_linux_distro();
+void cupid_log(LogType ltp, const char *format, ...);
 void epitaph();
 
+// context.c
+struct cf_os_release;
+void cf_context_init(struct cf_context *ctx, const struct CupidConfig *config, struct cf_state *state);
+void cf_state_release(struct cf_state *state);
+const char *cf_ctx_username(struct cf_context *ctx);
+const char *cf_ctx_hostname(struct cf_context *ctx);
+const char *cf_ctx_home(struct cf_context *ctx);
+const char *cf_ctx_shell(struct cf_context *ctx);
+const char *cf_ctx_kernel_release(struct cf_context *ctx);
+const char *cf_ctx_boot_id(struct cf_context *ctx);
+const struct cf_os_release *cf_ctx_os_release(struct cf_context *ctx);
+void cf_ctx_terminal_size(struct cf_context *ctx, int *cols_out, int *rows_out);
+struct cf_read_ring *cf_ctx_read_ring(struct cf_context *ctx);
+
+// distro_detect.c
+const char* detect_linux_distro(struct cf_context *ctx);
+const struct cf_os_release *get_os_release(void);
+
 #endif // CUPIDFETCH_H
@@ -0,0 +1,226 @@
+// File: distro_detect.c
+// -----------------------
+#include <limits.h>
+#include "cupidfetch.h"
+#include "distro_table.h"
+#include "modules/common/module_helpers.h"
+
+// Process-wide one-time loads, shared by every fetch.
+static cf_mutex g_distro_lock = CF_MUTEX_INIT;
+static bool g_distros_loaded = false;
+static bool g_auto_list_loaded = false;
+static cf_mutex g_os_release_lock = CF_MUTEX_INIT;
+
+#ifdef _WIN32
+typedef LONG(WINAPI *rtl_get_version_fn)(PRTL_OSVERSIONINFOW);
+
+static const char *detect_windows_distro_name(void) {
+    OSVERSIONINFOEXW osv;
+    memset(&osv, 0, sizeof(osv));
+    osv.dwOSVersionInfoSize = sizeof(osv);
+
+    HMODULE ntdll = GetModuleHandleA("ntdll.dll");
+    if (ntdll) {
+        rtl_get_version_fn rtl_get_version = (rtl_get_version_fn)GetProcAddress(ntdll, "RtlGetVersion");
+        if (rtl_get_version && rtl_get_version((PRTL_OSVERSIONINFOW)&osv) == 0) {
+            if (osv.dwMajorVersion == 10 && osv.dwBuildNumber >= 22000) return "Windows 11";
+            if (osv.dwMajorVersion == 10) return "Windows 10";
+            if (osv.dwMajorVersion == 6 && osv.dwMinorVersion >= 2) return "Windows 8";
+            return "Windows";
+        }
+    }
+
+    return "Windows";
+}
+
+#endif
+
+static char *path_dirname(char *path) {
+    if (!path || !path[0]) return path;
+    char *slash = strrchr(path, '/');
+#ifdef _WIN32
+    char *backslash = strrchr(path, '\\');
+    if (!slash || (backslash && backslash > slash)) slash = backslash;
+#endif
+    if (!slash) return path;
+    *slash = '\0';
+    return path;
+}
+
+// Unknown distros are appended to a list in the cache dir rather than to
+// data/distros.def, which may be read-only and shared by many processes.
+static bool get_auto_added_file_path(char *out, size_t size, char *dir_out, size_t dir_size) {
+    if (!cf_get_cache_dir(dir_out, dir_size)) return false;
+#ifdef _WIN32
+    return snprintf(out, size, "%s\\distros.auto", dir_out) < (int)size;
+#else
+    return snprintf(out, size, "%s/distros.auto", dir_out) < (int)size;
+#endif
+}
+
+// Resolved once per process; NULL when the executable can't be located.
+static const char *get_executable_path(void) {
+    static char exePath[PATH_MAX];
+    static bool resolved = false;
+    if (resolved) return exePath[0] ? exePath : NULL;
+    resolved = true;
+
+#ifdef _WIN32
+    DWORD len = GetModuleFileNameA(NULL, exePath, (DWORD)(sizeof(exePath) - 1));
+    if (len == 0 || len >= sizeof(exePath) - 1) len = 0;
+#else
+    ssize_t len = readlink("/proc/self/exe", exePath, sizeof(exePath) - 1);
+    if (len < 0) len = 0;
+#endif
+    exePath[len] = '\0';
+    return exePath[0] ? exePath : NULL;
+}
+
+// <executable dir>/data/distros.def, resolved once and without touching
+// the data directory itself.
+static const char *get_definitions_file_path(void) {
+    static char defPath[PATH_MAX] = "";
+    if (defPath[0]) return defPath;
+
+#ifdef _WIN32
+    const char *fallback = "data\\distros.def";
+    const char *suffix = "\\data\\distros.def";
+#else
+    const char *fallback = "data/distros.def";
+    const char *suffix = "/data/distros.def";
+#endif
+    const char *exePath = get_executable_path();
+    if (!exePath) {
+#ifndef _WIN32
+        fprintf(stderr, "Failed to read /proc/self/exe\n");
+#endif
+        snprintf(defPath, sizeof(defPath), "%s", fallback);
+        return defPath;
+    }
+
+    // e.g. "/home/frank/cupidfetch/cupidfetch" -> "/home/frank/cupidfetch/data/distros.def"
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s", exePath);
+    path_dirname(dir);
+    if (snprintf(defPath, sizeof(defPath), "%s%s", dir, suffix) >= (int)sizeof(defPath)) {
+        snprintf(defPath, sizeof(defPath), "%s", fallback);
+    }
+    return defPath;
+}
+
+// The built-in table is compiled from data/distros.def; the file itself is
+// only read when it was edited after the binary was built. Called with
+// g_distro_lock held.
+static void load_distro_overlay(void) {
+    g_distros_loaded = true;
+
+    const char *exePath = get_executable_path();
+    if (!exePath) return;
+    const char *defPath = get_definitions_file_path();
+
+    struct stat def_st;
+    struct stat exe_st;
+    if (stat(defPath, &def_st) != 0 || stat(exePath, &exe_st) != 0) return;
+    if (def_st.st_mtime <= exe_st.st_mtime) return;
+    cf_distro_overlay_load(defPath);
+}
+
+// Parsed once per process. /usr/lib/os-release is the vendor copy that
+// /etc/os-release normally links to. NULL when neither can be read.
+const struct cf_os_release *get_os_release(void) {
+    static struct cf_os_release os;
+    static bool loaded = false;
+    static bool valid = false;
+
+    cf_mutex_lock(&g_os_release_lock);
+    if (!loaded) {
+        loaded = true;
+#ifndef _WIN32
+        static const char *const paths[] = {"/etc/os-release", "/usr/lib/os-release"};
+        char text[4096];
+        for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]) && !valid; i++) {
+            if (cf_read_file(paths[i], text, sizeof(text)) > 0) valid = cf_parse_os_release(text, &os);
+        }
+#endif
+    }
+    cf_mutex_unlock(&g_os_release_lock);
+    return valid ? &os : NULL;
+}
+
+// Resolved once per fetch into ctx->distro.
+const char* detect_linux_distro(struct cf_context *ctx)
+{
+    if (ctx->forced_distro[0] != '\0') {
+        return ctx->forced_distro;
+    }
+
+    if (ctx->distro[0] != '\0') {
+        return ctx->distro;
+    }
+
+    cf_mutex_lock(&g_distro_lock);
+    if (!g_distros_loaded) {
+        load_distro_overlay();
+    }
+    cf_mutex_unlock(&g_distro_lock);
+
+#ifdef _WIN32
+    snprintf(ctx->distro, sizeof(ctx->distro), "%s", detect_windows_distro_name());
+    return ctx->distro;
+#else
+    // 1) Read /etc/os-release
+    const struct cf_os_release *os = cf_ctx_os_release(ctx);
+    if (!os) {
+        // Callers embedding the library can't have it exit under them.
+        cupid_log(LogType_ERROR, "couldn't read /etc/os-release");
+        snprintf(ctx->distro, sizeof(ctx->distro), "Linux");
+        return ctx->distro;
+    }
+    const char *distroId = os->id;
+
+    // 2) Check if it's a known distro
+    const struct cf_distro_def *known = cf_distro_by_id(distroId);
+    if (known) {
+        // Found it => return the "long name"
+        snprintf(ctx->distro, sizeof(ctx->distro), "%s", known->name);
+        return ctx->distro;
+    }
+
+    // 3) Previously auto-added IDs are only looked at once the built-in
+    //    table has missed, and read once per process.
+    char autoDir[PATH_MAX];
+    char autoPath[PATH_MAX];
+    bool haveAutoPath = get_auto_added_file_path(autoPath, sizeof(autoPath), autoDir, sizeof(autoDir));
+    cf_mutex_lock(&g_distro_lock);
+    if (haveAutoPath && !g_auto_list_loaded) {
+        g_auto_list_loaded = true;
+        cf_distro_overlay_append(autoPath);
+    }
+    cf_mutex_unlock(&g_distro_lock);
+    if ((known = cf_distro_by_id(distroId)) != NULL) {
+        snprintf(ctx->distro, sizeof(ctx->distro), "%s", known->name);
+        return ctx->distro;
+    }
+
+    // Not found => unknown
+    fprintf(stderr, "Warning: Unknown distribution '%s'\n", distroId);
+
+    // CHANGED: Create a separate capitalized name
+    char capitalized[128];
+    strncpy(capitalized, distroId, sizeof(capitalized)-1);
+    capitalized[sizeof(capitalized)-1] = '\0';
+
+    if (capitalized[0]) {
+        capitalized[0] = (char)toupper((unsigned char)capitalized[0]);
+    }
+
+    // 4) Auto-add it: the lower distroId as shortname, capitalized as longname
+    if (haveAutoPath && cf_make_dirs(autoDir) && cf_distro_auto_add(autoPath, distroId, capitalized)) {
+        fprintf(stderr, "Auto-updated %s with a new entry for '%s'\n", autoPath, distroId);
+    }
+
+    // CHANGED: Return the capitalized version as "Distro"
+    snprintf(ctx->distro, sizeof(ctx->distro), "%s", capitalized);
+    return ctx->distro;
+#endif
+}
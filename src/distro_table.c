@@ -0,0 +1,312 @@
+#include "cupidfetch.h"
+#include "distro_table.h"
+#include "modules/common/module_helpers.h"
+
+#include "distro_table_data.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#endif
+
+#define DISTRO_SLOT_COUNT(slots) (sizeof(slots) / sizeof((slots)[0]))
+
+struct overlay_entry {
+    char id[64];
+    char name[128];
+    char pkgcmd[128];
+    struct cf_distro_def def;
+};
+
+// Entries are allocated one by one so the definitions handed out stay put
+// while other threads add to the list. Only cf_distro_overlay_load() frees
+// them; it runs before any fetch starts.
+static cf_mutex g_overlay_lock = CF_MUTEX_INIT;
+static struct overlay_entry **g_overlay = NULL;
+static size_t g_overlay_count = 0;
+static size_t g_overlay_capacity = 0;
+
+static const struct cf_distro_def *builtin_lookup(
+    const char *key,
+    bool by_name,
+    const short *slots,
+    size_t slot_count,
+    uint32_t seed
+) {
+    short index = slots[cf_distro_hash(key, seed) & (slot_count - 1)];
+    if (index < 0) return NULL;
+
+    const struct cf_distro_def *def = &cf_builtin_distros[index];
+    return strcmp(by_name ? def->name : def->id, key) == 0 ? def : NULL;
+}
+
+static const struct cf_distro_def *overlay_lookup(const char *key, bool by_name) {
+    const struct cf_distro_def *found = NULL;
+    cf_mutex_lock(&g_overlay_lock);
+    for (size_t i = 0; i < g_overlay_count && !found; i++) {
+        if (strcmp(by_name ? g_overlay[i]->name : g_overlay[i]->id, key) == 0) found = &g_overlay[i]->def;
+    }
+    cf_mutex_unlock(&g_overlay_lock);
+    return found;
+}
+
+const struct cf_distro_def *cf_distro_by_id(const char *id) {
+    if (!id) return NULL;
+    const struct cf_distro_def *overlay = overlay_lookup(id, false);
+    if (overlay) return overlay;
+    return builtin_lookup(id, false, cf_distro_id_slots, DISTRO_SLOT_COUNT(cf_distro_id_slots), CF_DISTRO_ID_SEED);
+}
+
+const struct cf_distro_def *cf_distro_by_name(const char *name) {
+    if (!name) return NULL;
+    const struct cf_distro_def *overlay = overlay_lookup(name, true);
+    if (overlay) return overlay;
+    return builtin_lookup(name, true, cf_distro_name_slots, DISTRO_SLOT_COUNT(cf_distro_name_slots),
+                          CF_DISTRO_NAME_SEED);
+}
+
+size_t cf_distro_overlay_count(void) {
+    cf_mutex_lock(&g_overlay_lock);
+    size_t count = g_overlay_count;
+    cf_mutex_unlock(&g_overlay_lock);
+    return count;
+}
+
+// Called with g_overlay_lock held.
+static bool overlay_push(const struct overlay_entry *entry) {
+    if (g_overlay_count == g_overlay_capacity) {
+        size_t new_capacity = g_overlay_capacity ? g_overlay_capacity * 2 : 32;
+        struct overlay_entry **grown = realloc(g_overlay, new_capacity * sizeof(*grown));
+        if (!grown) return false;
+        g_overlay = grown;
+        g_overlay_capacity = new_capacity;
+    }
+
+    struct overlay_entry *copy = malloc(sizeof(*copy));
+    if (!copy) return false;
+    *copy = *entry;
+    copy->def.id = copy->id;
+    copy->def.name = copy->name;
+    copy->def.pkgcmd = copy->pkgcmd;
+    g_overlay[g_overlay_count++] = copy;
+    return true;
+}
+
+// Calls `fn` for each DISTRO() line of `text` until it returns false. With
+// `complete_lines_only`, a last line without its newline (an append cut
+// short by a crash) is skipped.
+static void for_each_def_line(
+    const char *text,
+    size_t len,
+    bool complete_lines_only,
+    bool (*fn)(const struct overlay_entry *entry, void *ctx),
+    void *ctx
+) {
+    size_t pos = 0;
+    while (pos < len) {
+        const char *start = text + pos;
+        const char *newline = memchr(start, '\n', len - pos);
+        size_t line_len = newline ? (size_t)(newline - start) : len - pos;
+        pos += line_len + 1;
+        if (!newline && complete_lines_only) break;
+
+        char line[512];
+        if (line_len >= sizeof(line)) continue;
+        memcpy(line, start, line_len);
+        line[line_len] = '\0';
+
+        struct overlay_entry entry;
+        if (!cf_parse_distro_def_line(line, entry.id, sizeof(entry.id), entry.name, sizeof(entry.name),
+                                      entry.pkgcmd, sizeof(entry.pkgcmd))) {
+            continue;
+        }
+        if (!fn(&entry, ctx)) break;
+    }
+}
+
+struct mapped_file {
+    char *data;
+    size_t len;
+};
+
+#ifdef _WIN32
+static bool map_file(const char *path, struct mapped_file *out) {
+    out->data = NULL;
+    out->len = 0;
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return false;
+
+    size_t cap = 0;
+    char chunk[4096];
+    size_t nread;
+    bool ok = true;
+    while (ok && (nread = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+        if (out->len + nread > cap) {
+            size_t new_cap = cap ? cap * 2 : 8192;
+            while (out->len + nread > new_cap) new_cap *= 2;
+            char *grown = realloc(out->data, new_cap);
+            if (!grown) {
+                ok = false;
+                break;
+            }
+            out->data = grown;
+            cap = new_cap;
+        }
+        memcpy(out->data + out->len, chunk, nread);
+        out->len += nread;
+    }
+    fclose(fp);
+    if (!ok) {
+        free(out->data);
+        out->data = NULL;
+        out->len = 0;
+    }
+    return ok;
+}
+
+static void unmap_file(struct mapped_file *file) {
+    free(file->data);
+}
+#else
+// The file only ever grows by whole appends, so a private read-only map
+// of the current size sees a consistent prefix.
+static bool map_fd(int fd, struct mapped_file *out) {
+    out->data = NULL;
+    out->len = 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    if (st.st_size == 0) return true;
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) return false;
+    out->data = data;
+    out->len = (size_t)st.st_size;
+    return true;
+}
+
+static bool map_file(const char *path, struct mapped_file *out) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool ok = map_fd(fd, out);
+    close(fd);
+    return ok;
+}
+
+static void unmap_file(struct mapped_file *file) {
+    if (file->data) munmap(file->data, file->len);
+}
+#endif
+
+static bool add_overlay_entry(const struct overlay_entry *entry, void *ctx) {
+    bool *ok = ctx;
+    *ok = overlay_push(entry);
+    return *ok;
+}
+
+static bool overlay_add_file(const char *path, bool complete_lines_only) {
+    struct mapped_file file;
+    if (!path || !map_file(path, &file)) return false;
+
+    bool ok = true;
+    cf_mutex_lock(&g_overlay_lock);
+    for_each_def_line(file.data, file.len, complete_lines_only, add_overlay_entry, &ok);
+    cf_mutex_unlock(&g_overlay_lock);
+    unmap_file(&file);
+    return ok;
+}
+
+// Replaces the overlay with the DISTRO() lines of `path`. Returns false when
+// the file can't be read, leaving only the built-in table.
+bool cf_distro_overlay_load(const char *path) {
+    cf_mutex_lock(&g_overlay_lock);
+    for (size_t i = 0; i < g_overlay_count; i++) free(g_overlay[i]);
+    free(g_overlay);
+    g_overlay = NULL;
+    g_overlay_count = 0;
+    g_overlay_capacity = 0;
+    cf_mutex_unlock(&g_overlay_lock);
+    return overlay_add_file(path, false);
+}
+
+bool cf_distro_overlay_append(const char *path) {
+    return overlay_add_file(path, true);
+}
+
+struct id_search {
+    const char *id;
+    bool found;
+};
+
+static bool match_id(const struct overlay_entry *entry, void *ctx) {
+    struct id_search *search = ctx;
+    search->found = strcmp(entry->id, search->id) == 0;
+    return !search->found;
+}
+
+bool cf_distro_auto_add(const char *path, const char *id, const char *name) {
+    if (!path || !id || !id[0] || !name || !name[0]) return false;
+    // Anything that would break the DISTRO("...") line stays out of the file.
+    if (strpbrk(id, "\"\\\r\n") || strpbrk(name, "\"\\\r\n")) return false;
+
+    char line[256];
+    int line_len = snprintf(line, sizeof(line) - 1, "DISTRO(\"%s\", \"%s\", \"\")\n", id, name);
+    if (line_len < 0 || (size_t)line_len >= sizeof(line) - 1) return false;
+
+    struct id_search search = {id, false};
+    bool appended = false;
+#ifdef _WIN32
+    struct mapped_file file;
+    bool needs_newline = false;
+    if (map_file(path, &file)) {
+        for_each_def_line(file.data, file.len, true, match_id, &search);
+        needs_newline = file.len > 0 && file.data[file.len - 1] != '\n';
+        unmap_file(&file);
+    }
+    if (!search.found) {
+        FILE *fp = fopen(path, "ab");
+        if (fp) {
+            if (needs_newline) fputc('\n', fp);
+            appended = fwrite(line, 1, (size_t)line_len, fp) == (size_t)line_len;
+            appended = fclose(fp) == 0 && appended;
+        }
+    }
+#else
+    // O_APPEND places every write at the end; the lock only makes the
+    // "already there?" check and the write one step across processes.
+    int fd = open(path, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    while (flock(fd, LOCK_EX) != 0) {
+        if (errno != EINTR) {
+            close(fd);
+            return false;
+        }
+    }
+
+    struct mapped_file file;
+    if (map_fd(fd, &file)) {
+        for_each_def_line(file.data, file.len, true, match_id, &search);
+        // Terminate a torn line first so it can't swallow this one.
+        if (!search.found && file.len > 0 && file.data[file.len - 1] != '\n') {
+            memmove(line + 1, line, (size_t)line_len + 1);
+            line[0] = '\n';
+            line_len++;
+        }
+        unmap_file(&file);
+        if (!search.found) appended = write(fd, line, (size_t)line_len) == (ssize_t)line_len;
+    }
+    close(fd);
+#endif
+
+    if (appended) {
+        struct overlay_entry entry;
+        snprintf(entry.id, sizeof(entry.id), "%s", id);
+        snprintf(entry.name, sizeof(entry.name), "%s", name);
+        entry.pkgcmd[0] = '\0';
+        cf_mutex_lock(&g_overlay_lock);
+        overlay_push(&entry);
+        cf_mutex_unlock(&g_overlay_lock);
+    }
+    return appended;
+}
@@ -0,0 +1,42 @@
+#ifndef DISTRO_TABLE_H
+#define DISTRO_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// One DISTRO("id", "Name", "package command") line of data/distros.def.
+struct cf_distro_def {
+    const char *id;
+    const char *name;
+    const char *pkgcmd;
+};
+
+// Shared by the table generator and the lookups: FNV-1a from a seeded
+// basis, then a final mix so the low bits used as the slot are spread.
+static inline uint32_t cf_distro_hash(const char *key, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (const unsigned char *p = (const unsigned char *)key; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+// Overlay entries (a distros.def newer than the binary) first, then the
+// table compiled in from data/distros.def.
+const struct cf_distro_def *cf_distro_by_id(const char *id);
+const struct cf_distro_def *cf_distro_by_name(const char *name);
+bool cf_distro_overlay_load(const char *path);
+// Adds the entries of an append-only file such as the auto-added list.
+bool cf_distro_overlay_append(const char *path);
+// Appends DISTRO("id", "name", "") to `path` under an exclusive flock()
+// unless the ID is already listed, and adds it to the overlay. Returns true
+// only when a line was written.
+bool cf_distro_auto_add(const char *path, const char *id, const char *name);
+size_t cf_distro_overlay_count(void);
+
+#endif // DISTRO_TABLE_H
@@ -0,0 +1,48 @@
+// Generated from data/distros.def by tools/gen_distro_table.c; do not edit.
+
+#define CF_DISTRO_ID_SEED 171u
+#define CF_DISTRO_NAME_SEED 190u
+
+static const struct cf_distro_def cf_builtin_distros[27] = {
+    {"ubuntu", "Ubuntu", "dpkg -l | tail -n+6 | wc -l"},
+    {"debian", "Debian", "dpkg -l | tail -n+6 | wc -l"},
+    {"elementary", "elementary OS", "dpkg -l | tail -n+6 | wc -l"},
+    {"zorin", "Zorin OS", "dpkg -l | tail -n+6 | wc -l"},
+    {"pop", "Pop!_OS", "dpkg -l | tail -n+6 | wc -l"},
+    {"mx", "MX Linux", "dpkg -l | tail -n+6 | wc -l"},
+    {"kali", "Kali Linux", "dpkg -l | tail -n+6 | wc -l"},
+    {"mint", "Linux Mint", "dpkg -l | tail -n+6 | wc -l"},
+    {"peppermint", "Peppermint OS", "dpkg -l | tail -n+6 | wc -l"},
+    {"manjaro", "Manjaro", "pacman -Q | wc -l"},
+    {"artix", "Artix Linux", "pacman -Q | wc -l"},
+    {"endeavouros", "EndeavourOS", "pacman -Q | wc -l"},
+    {"antergos", "Antergos", "pacman -Q | wc -l"},
+    {"centos", "CentOS", "rpm -qa | wc -l"},
+    {"fedora", "Fedora", "rpm -qa | wc -l"},
+    {"opensuse", "openSUSE", "rpm -qa | wc -l"},
+    {"mageia", "Mageia", "rpm -qa | wc -l"},
+    {"alma", "AlmaLinux", "rpm -qa | wc -l"},
+    {"gentoo", "Gentoo", "equery -q list '*' | wc -l"},
+    {"alpine", "Alpine Linux", "apk info | wc -l"},
+    {"void", "Void Linux", "xbps-query -l | wc -l"},
+    {"slackware", "Slackware", "ls /var/log/packages/ | wc -l"},
+    {"solus", "Solus", "eopkg list-installed | wc -l"},
+    {"windows11", "Windows 11", ""},
+    {"windows10", "Windows 10", ""},
+    {"windows", "Windows", ""},
+    {"arch", "Arch", "pacman -Q | wc -l"},
+};
+
+static const short cf_distro_id_slots[64] = {
+    -1, -1, -1, -1, 14, -1, -1, -1, -1, -1, 7, 6, -1, -1, -1, 0,
+    -1, 4, -1, 1, 15, 24, 12, 23, 17, -1, -1, -1, -1, 8, -1, -1,
+    25, -1, 3, -1, 20, 16, 21, -1, -1, 18, 11, 9, 5, -1, 26, -1,
+    -1, 13, -1, 19, 10, -1, -1, -1, -1, -1, -1, 22, -1, -1, 2, -1
+};
+
+static const short cf_distro_name_slots[64] = {
+    18, -1, 5, 25, -1, -1, -1, -1, 17, -1, -1, -1, -1, 9, -1, -1,
+    -1, -1, 6, -1, 11, -1, -1, 20, 24, -1, -1, -1, -1, 8, 16, 22,
+    -1, -1, 19, -1, -1, 1, 3, -1, 0, 4, 14, -1, 12, -1, 15, -1,
+    -1, 23, 21, 10, -1, -1, 26, -1, -1, -1, 2, -1, -1, -1, 7, 13
+};
@@ -0,0 +1,154 @@
+// File: libcupidfetch.c
+// -----------------------
+#include "libcupidfetch.h"
+#include "cupidfetch.h"
+#include "modules/common/module_helpers.h"
+
+struct cupidfetch {
+    struct CupidConfig config;
+    char forced_distro[128];
+    struct cf_state state;
+    struct cf_context ctx;
+    struct cf_sink *sink;
+    char user_host[512];
+    struct cupidfetch_item *items;
+    size_t items_cap;
+    struct cupidfetch_value *values;
+    size_t values_cap;
+    struct cupidfetch_result result;
+};
+
+cupidfetch *cupidfetch_new(void) {
+    cupidfetch *cf = calloc(1, sizeof(*cf));
+    if (!cf) return NULL;
+    init_config(&cf->config);
+    cf->sink = cf_sink_new(&cf->config);
+    if (!cf->sink) {
+        free(cf);
+        return NULL;
+    }
+    cf_context_init(&cf->ctx, &cf->config, &cf->state);
+    return cf;
+}
+
+void cupidfetch_free(cupidfetch *cf) {
+    if (!cf) return;
+    cf_state_release(&cf->state);
+    cf_sink_free(cf->sink);
+    free(cf->items);
+    free(cf->values);
+    free(cf);
+}
+
+bool cupidfetch_load_config(cupidfetch *cf, const char *path) {
+    return load_config_file(path, &cf->config);
+}
+
+bool cupidfetch_select_modules(cupidfetch *cf, const char *names) {
+    return config_set_modules(&cf->config, names ? names : "");
+}
+
+void cupidfetch_force_distro(cupidfetch *cf, const char *name) {
+    snprintf(cf->forced_distro, sizeof(cf->forced_distro), "%s", name ? name : "");
+}
+
+static enum cupidfetch_value_type public_type(enum cf_value_type type) {
+    switch (type) {
+    case CF_VALUE_U64: return CUPIDFETCH_VALUE_U64;
+    case CF_VALUE_PERCENT: return CUPIDFETCH_VALUE_PERCENT;
+    case CF_VALUE_BYTES: return CUPIDFETCH_VALUE_BYTES;
+    case CF_VALUE_STR: break;
+    }
+    return CUPIDFETCH_VALUE_STR;
+}
+
+static bool build_items(cupidfetch *cf) {
+    size_t count = cf_sink_count(cf->sink);
+    size_t total_values = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t n = 0;
+        cf_sink_values(cf->sink, i, &n);
+        total_values += n;
+    }
+    if (count > cf->items_cap) {
+        struct cupidfetch_item *grown = realloc(cf->items, count * sizeof(*grown));
+        if (!grown) return false;
+        cf->items = grown;
+        cf->items_cap = count;
+    }
+    if (total_values > cf->values_cap) {
+        struct cupidfetch_value *grown = realloc(cf->values, total_values * sizeof(*grown));
+        if (!grown) return false;
+        cf->values = grown;
+        cf->values_cap = total_values;
+    }
+
+    size_t next_value = 0;
+    for (size_t i = 0; i < count; i++) {
+        struct cupidfetch_item *item = &cf->items[i];
+        cf_sink_entry(cf->sink, i, &item->key, &item->label, &item->text);
+
+        size_t n = 0;
+        const struct cf_value *values = cf_sink_values(cf->sink, i, &n);
+        item->values = n > 0 ? &cf->values[next_value] : NULL;
+        item->value_count = n;
+        for (size_t j = 0; j < n; j++) {
+            struct cupidfetch_value *value = &cf->values[next_value++];
+            value->name = values[j].name;
+            value->type = public_type(values[j].type);
+            value->u64 = values[j].u64;
+            value->percent = values[j].percent;
+            value->unit = values[j].unit;
+            value->text = values[j].text;
+        }
+    }
+    cf->result.items = cf->items;
+    cf->result.count = count;
+    return true;
+}
+
+const struct cupidfetch_result *cupidfetch_collect(cupidfetch *cf) {
+    // A fresh context per collect: user, host and terminal size can change
+    // between watch-mode redraws.
+    cf_context_init(&cf->ctx, &cf->config, &cf->state);
+    memcpy(cf->ctx.forced_distro, cf->forced_distro, sizeof(cf->ctx.forced_distro));
+
+    const char *username = cf_ctx_username(&cf->ctx);
+    if (username == NULL) {
+        cupid_log(LogType_ERROR, "couldn't get username");
+        username = "unknown";
+    }
+
+    const char *hostname = cf_ctx_hostname(&cf->ctx);
+    if (hostname == NULL) {
+        cupid_log(LogType_ERROR, "couldn't get hostname");
+        hostname = "";
+    }
+
+    snprintf(cf->user_host, sizeof(cf->user_host), "%s@%s", username, hostname);
+    cf->result.user_host = cf->user_host;
+    cf->result.items = NULL;
+    cf->result.count = 0;
+
+    cf_sink_reset(cf->sink);
+    for (size_t i = 0; cf->config.modules[i]; i++) {
+        cf->config.modules[i](&cf->ctx, cf->sink);
+    }
+
+    if (!build_items(cf)) {
+        cupid_log(LogType_ERROR, "couldn't allocate the collected items");
+        return NULL;
+    }
+    return &cf->result;
+}
+
+bool cupidfetch_render_panel(cupidfetch *cf, FILE *out) {
+    const char *distro = detect_linux_distro(&cf->ctx);
+    render_fetch_panel(out, &cf->ctx, cf->sink, distro, cf->user_host);
+    return !ferror(out);
+}
+
+bool cupidfetch_render_json(cupidfetch *cf, FILE *out) {
+    render_json_output(out, cf->sink, cf->user_host);
+    return !ferror(out);
+}
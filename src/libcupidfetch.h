@@ -0,0 +1,93 @@
+#ifndef LIBCUPIDFETCH_H
+#define LIBCUPIDFETCH_H
+
+// Embedding API: collect the same facts as the cupidfetch binary without
+// running it. A handle keeps its own configuration, samples (for CPU and
+// GPU rates) and results; the caches behind the modules are shared by
+// every handle in the process. A handle must not be used by two threads at
+// once, but separate handles may collect concurrently.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The library is built with hidden visibility; only these functions are
+// exported.
+#if defined(_WIN32) && defined(CUPIDFETCH_BUILDING)
+#define CUPIDFETCH_API __declspec(dllexport)
+#elif defined(__GNUC__) && !defined(_WIN32)
+#define CUPIDFETCH_API __attribute__((visibility("default")))
+#else
+#define CUPIDFETCH_API
+#endif
+
+typedef struct cupidfetch cupidfetch;
+
+enum cupidfetch_value_type {
+    CUPIDFETCH_VALUE_STR,
+    CUPIDFETCH_VALUE_U64,
+    CUPIDFETCH_VALUE_PERCENT,
+    CUPIDFETCH_VALUE_BYTES
+};
+
+struct cupidfetch_value {
+    const char *name;         // JSON field, e.g. "used_bytes"
+    enum cupidfetch_value_type type;
+    unsigned long long u64;   // U64, and BYTES as a byte count
+    double percent;           // PERCENT, 0-100
+    const char *unit;         // U64 only, e.g. "MHz"; "" otherwise
+    const char *text;         // STR only; "" otherwise
+};
+
+struct cupidfetch_item {
+    const char *key;    // JSON key, e.g. "memory"; repeats become "memory_2"
+    const char *label;  // as shown in the panel; "" for a continuation line
+    const char *text;   // the value as shown in the panel
+    // The numbers behind `text` (e.g. used and total bytes); none for
+    // modules that only report text.
+    const struct cupidfetch_value *values;
+    size_t value_count;
+};
+
+struct cupidfetch_result {
+    const char *user_host;
+    const struct cupidfetch_item *items;
+    size_t count;
+};
+
+// Failures are reported through return values and never end the calling
+// process; details go to the cupidfetch log.
+
+// Starts from the built-in defaults (the default module list included).
+// NULL when out of memory.
+CUPIDFETCH_API cupidfetch *cupidfetch_new(void);
+CUPIDFETCH_API void cupidfetch_free(cupidfetch *cf);
+
+// Reads a cupidfetch.conf; returns false if it can't be opened.
+CUPIDFETCH_API bool cupidfetch_load_config(cupidfetch *cf, const char *path);
+// Space-separated names as in the config file's `modules` line. Unknown
+// names are skipped and make this return false.
+CUPIDFETCH_API bool cupidfetch_select_modules(cupidfetch *cf, const char *names);
+// Reports `name` as the distro instead of reading os-release; NULL clears.
+CUPIDFETCH_API void cupidfetch_force_distro(cupidfetch *cf, const char *name);
+
+// Runs the selected modules. The result and every string in it stay valid
+// until the next collect or cupidfetch_free(). NULL when the result could
+// not be allocated.
+CUPIDFETCH_API const struct cupidfetch_result *cupidfetch_collect(cupidfetch *cf);
+
+// Render the last collect: the logo panel (colored when `out` is a
+// terminal) or the JSON object `cupidfetch --json` prints. Return false
+// if writing to `out` failed.
+CUPIDFETCH_API bool cupidfetch_render_panel(cupidfetch *cf, FILE *out);
+CUPIDFETCH_API bool cupidfetch_render_json(cupidfetch *cf, FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBCUPIDFETCH_H
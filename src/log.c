@@ -1,22 +1,53 @@
 // File: log.c
 // -----------------------
 #include "cupidfetch.h"
+#include "modules/common/module_helpers.h"
 
+FILE *g_log = NULL;
 const char *log_types[] = {"INFO", "WARNING", "ERROR", "CRITICAL"};
 
+// Modules on different threads may log at once; one message at a time.
+static cf_mutex g_log_lock = CF_MUTEX_INIT;
+
+// The log file is opened (and truncated) by the first message of a run,
+// so runs that log nothing leave the previous log alone.
+static FILE *log_stream(void) {
+    if (g_log) return g_log;
+
+    if (!isatty(STDERR_FILENO)) {
+        g_log = stderr;
+        return g_log;
+    }
+
+    char log_path[CONFIG_PATH_SIZE];
+    g_log = get_config_file_path("log.txt", log_path, sizeof(log_path)) ? fopen(log_path, "w") : NULL;
+    if (g_log == NULL) {
+        g_log = stderr;
+        fprintf(g_log, "%s: <Couldn't open log file, logging to stderr> errno=<%s>\n",
+                log_types[LogType_ERROR], strerror(errno));
+    }
+    return g_log;
+}
+
 void cupid_log(LogType ltp, const char *format, ...) {
+    int saved_errno = errno;
+    cf_mutex_lock(&g_log_lock);
+    FILE *out = log_stream();
+
     va_list args;
     va_start(args, format);
 
-    fprintf(g_log, "%s: <", log_types[ltp]);
-    vfprintf(g_log, format, args);
-    fprintf(g_log, "> errno=<%s>\n", strerror(errno));
+    fprintf(out, "%s: <", log_types[ltp]);
+    vfprintf(out, format, args);
+    fprintf(out, "> errno=<%s>\n", strerror(saved_errno));
 
     va_end(args);
-
-    if (ltp == LogType_CRITICAL) {
-	epitaph();
-	exit(EXIT_FAILURE);
-    }
+    cf_mutex_unlock(&g_log_lock);
+    // No exit() here, CRITICAL included: the code may be running inside
+    // someone else's process through libcupidfetch.
 }
 
+void epitaph() {
+    if (g_log && g_log != stderr) fclose(g_log);
+    g_log = NULL;
+}
@@ -0,0 +1,111 @@
+#include "module_helpers.h"
+
+#define ARENA_ALIGN 16
+#define ARENA_DEFAULT_BLOCK 16384
+
+struct cf_arena_block {
+    struct cf_arena_block *next;
+    size_t size;
+    size_t used;
+    unsigned char *data;
+};
+
+static size_t align_up(size_t value) {
+    return (value + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static struct cf_arena_block *block_new(size_t size) {
+    // The header and its data share one malloc; data starts aligned.
+    size_t header = align_up(sizeof(struct cf_arena_block));
+    struct cf_arena_block *block = malloc(header + size);
+    if (!block) return NULL;
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    block->data = (unsigned char *)block + header;
+    return block;
+}
+
+void cf_arena_init(struct cf_arena *arena, size_t block_size) {
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->block_size = block_size > 0 ? block_size : ARENA_DEFAULT_BLOCK;
+}
+
+void *cf_arena_alloc(struct cf_arena *arena, size_t size) {
+    if (size == 0) size = 1;
+    size_t need = align_up(size);
+    if (need < size) return NULL;
+
+    struct cf_arena_block *block = arena->current;
+    if (block && block->size - block->used >= need) {
+        void *ptr = block->data + block->used;
+        block->used += need;
+        return ptr;
+    }
+
+    // After a reset the next block may be free for reuse; a request larger
+    // than it gets a block of its own, linked in ahead of it.
+    struct cf_arena_block *next = block ? block->next : arena->first;
+    if (!next || next->size < need) {
+        struct cf_arena_block *fresh = block_new(need > arena->block_size ? need : arena->block_size);
+        if (!fresh) return NULL;
+        fresh->next = next;
+        if (block) {
+            block->next = fresh;
+        } else {
+            arena->first = fresh;
+        }
+        next = fresh;
+    }
+
+    arena->current = next;
+    next->used = need;
+    return next->data;
+}
+
+void *cf_arena_grow(struct cf_arena *arena, void *ptr, size_t old_size, size_t new_size) {
+    if (!ptr) return cf_arena_alloc(arena, new_size);
+    if (new_size <= old_size) return ptr;
+
+    struct cf_arena_block *block = arena->current;
+    size_t old_need = align_up(old_size);
+    size_t new_need = align_up(new_size);
+    if (block && (unsigned char *)ptr + old_need == block->data + block->used &&
+        block->size - (block->used - old_need) >= new_need) {
+        block->used = block->used - old_need + new_need;
+        return ptr;
+    }
+
+    void *moved = cf_arena_alloc(arena, new_size);
+    if (moved) memcpy(moved, ptr, old_size);
+    return moved;
+}
+
+char *cf_arena_strndup(struct cf_arena *arena, const char *text, size_t len) {
+    char *copy = cf_arena_alloc(arena, len + 1);
+    if (!copy) return NULL;
+    memcpy(copy, text, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+char *cf_arena_strdup(struct cf_arena *arena, const char *text) {
+    return cf_arena_strndup(arena, text ? text : "", text ? strlen(text) : 0);
+}
+
+void cf_arena_reset(struct cf_arena *arena) {
+    for (struct cf_arena_block *block = arena->first; block; block = block->next) block->used = 0;
+    arena->current = arena->first;
+}
+
+void cf_arena_free(struct cf_arena *arena) {
+    struct cf_arena_block *block = arena->first;
+    while (block) {
+        struct cf_arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+}
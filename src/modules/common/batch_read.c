@@ -0,0 +1,322 @@
+#include "module_helpers.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define CF_HAVE_IO_URING 1
+#endif
+#endif
+
+#ifdef CF_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+// A chunk costs three io_uring_enter calls, so tiny batches stay synchronous.
+#define BATCH_MIN_URING_REQUESTS 4
+#define BATCH_MAX_CHUNK 128
+#define BATCH_CLOSE_TAG (1ULL << 32)
+
+struct uring {
+    int fd;
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+};
+
+// io_uring itself dates from 5.1, but openat, read and close only from 5.6,
+// which also brought the probe: a kernel that can't answer it can't run
+// the batch either.
+static bool uring_supports_file_ops(int fd) {
+    static const unsigned char needed[] = {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE};
+    size_t size = sizeof(struct io_uring_probe) + IORING_OP_LAST * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, size);
+    if (!probe) return false;
+
+    bool ok = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) >= 0;
+    for (size_t i = 0; ok && i < sizeof(needed); i++) {
+        ok = needed[i] <= probe->last_op && (probe->ops[needed[i]].flags & IO_URING_OP_SUPPORTED);
+    }
+    free(probe);
+    return ok;
+}
+
+static void uring_close(struct uring *ring) {
+    if (ring->sqes && ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring && ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sq_ring && ring->sq_ring != MAP_FAILED) munmap(ring->sq_ring, ring->sq_ring_size);
+    if (ring->fd >= 0) close(ring->fd);
+}
+
+// Raw syscalls rather than liburing: the project has no dependencies and
+// only needs open, read and close.
+static bool uring_open(struct uring *ring, unsigned entries) {
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) return false;
+    ring->fd = fd;
+    if (!uring_supports_file_ops(fd)) {
+        uring_close(ring);
+        return false;
+    }
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap && ring->cq_ring_size > ring->sq_ring_size) ring->sq_ring_size = ring->cq_ring_size;
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        ring->sq_ring = NULL;
+        uring_close(ring);
+        return false;
+    }
+
+    if (single_mmap) {
+        ring->cq_ring = ring->sq_ring;
+    } else {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) {
+            ring->cq_ring = NULL;
+            uring_close(ring);
+            return false;
+        }
+    }
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        uring_close(ring);
+        return false;
+    }
+
+    char *sq = ring->sq_ring;
+    char *cq = ring->cq_ring;
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return true;
+}
+
+static struct io_uring_sqe *uring_next_sqe(struct uring *ring, unsigned queued) {
+    unsigned tail = *ring->sq_tail + queued;
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    return sqe;
+}
+
+// Publishes `queued` entries, waits for as many completions and hands each
+// result to `results` by its user_data. Close completions are dropped.
+static bool uring_submit_and_wait(struct uring *ring, unsigned queued, int *results) {
+    __atomic_store_n(ring->sq_tail, *ring->sq_tail + queued, __ATOMIC_RELEASE);
+
+    unsigned submitted = 0;
+    unsigned completed = 0;
+    while (completed < queued) {
+        unsigned to_submit = queued - submitted;
+        int rc = (int)syscall(__NR_io_uring_enter, ring->fd, to_submit, queued - completed,
+                              IORING_ENTER_GETEVENTS, NULL, 0);
+        if (rc < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        submitted += (unsigned)rc;
+
+        unsigned head = *ring->cq_head;
+        unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            const struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+            if ((cqe->user_data & BATCH_CLOSE_TAG) == 0) results[cqe->user_data] = cqe->res;
+            completed++;
+        }
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+static unsigned ring_entries_for(size_t count) {
+    unsigned entries = 8;
+    while (entries < count * 2) entries <<= 1;
+    return entries;
+}
+
+// Three submissions per chunk instead of three syscalls per file: every
+// openat, then every read, then every close.
+static bool read_chunk_uring(struct uring *ring, struct cf_read_request *requests, size_t count) {
+    int fds[BATCH_MAX_CHUNK];
+    int results[BATCH_MAX_CHUNK];
+
+    for (size_t i = 0; i < count; i++) {
+        struct io_uring_sqe *sqe = uring_next_sqe(ring, (unsigned)i);
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = requests[i].dirfd;
+        sqe->addr = (uint64_t)(uintptr_t)requests[i].path;
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->user_data = i;
+        fds[i] = -1;
+    }
+    // An opcode the kernel rejects (EINVAL, EOPNOTSUPP), seccomp filters
+    // included, fails every open alike: leave the chunk to the plain reader.
+    bool opened = uring_submit_and_wait(ring, (unsigned)count, fds);
+    for (size_t i = 0; opened && i < count; i++) {
+        if (fds[i] == -EINVAL || fds[i] == -EOPNOTSUPP) opened = false;
+    }
+    if (!opened) {
+        for (size_t i = 0; i < count; i++) {
+            if (fds[i] >= 0) close(fds[i]);
+        }
+        return false;
+    }
+
+    unsigned queued = 0;
+    for (size_t i = 0; i < count; i++) {
+        results[i] = -1;
+        if (fds[i] < 0) continue;
+        struct io_uring_sqe *sqe = uring_next_sqe(ring, queued++);
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = fds[i];
+        sqe->addr = (uint64_t)(uintptr_t)requests[i].buffer;
+        sqe->len = (unsigned)(requests[i].size - 1);
+        sqe->off = 0;
+        sqe->user_data = i;
+    }
+    bool reads_done = queued == 0 || uring_submit_and_wait(ring, queued, results);
+
+    // Closes go out only once every read has completed: a read the kernel
+    // punted to a worker resolves its fd late and must not race a close.
+    queued = 0;
+    for (size_t i = 0; i < count && reads_done; i++) {
+        if (fds[i] < 0) continue;
+        struct io_uring_sqe *sqe = uring_next_sqe(ring, queued++);
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = fds[i];
+        sqe->user_data = BATCH_CLOSE_TAG | i;
+    }
+
+    if (!reads_done || (queued > 0 && !uring_submit_and_wait(ring, queued, results))) {
+        // The ring is unusable; fds may or may not have been closed by it.
+        for (size_t i = 0; i < count; i++) {
+            if (fds[i] >= 0) close(fds[i]);
+        }
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        requests[i].result = results[i] >= 0 ? (ssize_t)results[i] : -1;
+        if (requests[i].result >= 0) requests[i].buffer[requests[i].result] = '\0';
+    }
+    return true;
+}
+#endif
+
+struct cf_read_ring {
+#ifdef CF_HAVE_IO_URING
+    struct uring uring;
+#endif
+    bool opened;
+    bool unusable;  // set-up or a chunk failed; plain reads from then on
+};
+
+struct cf_read_ring *cf_read_ring_new(void) {
+    return calloc(1, sizeof(struct cf_read_ring));
+}
+
+void cf_read_ring_free(struct cf_read_ring *ring) {
+    if (!ring) return;
+#ifdef CF_HAVE_IO_URING
+    if (ring->opened) uring_close(&ring->uring);
+#endif
+    free(ring);
+}
+
+#ifdef CF_HAVE_IO_URING
+// Opened on the first batch big enough to use it, sized for a full chunk.
+static bool read_ring_ready(struct cf_read_ring *ring) {
+    if (ring->opened) return true;
+    if (ring->unusable) return false;
+    ring->opened = uring_open(&ring->uring, ring_entries_for(BATCH_MAX_CHUNK));
+    ring->unusable = !ring->opened;
+    return ring->opened;
+}
+#endif
+
+static ssize_t read_one(const struct cf_read_request *request) {
+    if (!request->path || !request->buffer || request->size == 0) return -1;
+#ifdef _WIN32
+    return cf_read_file(request->path, request->buffer, request->size);
+#else
+    return cf_read_file_at(request->dirfd, request->path, request->buffer, request->size);
+#endif
+}
+
+size_t cf_read_batch(struct cf_read_ring *ring, struct cf_read_request *requests, size_t count) {
+    if (!requests || count == 0) return 0;
+
+    for (size_t i = 0; i < count; i++) {
+        requests[i].result = -1;
+        if (requests[i].buffer && requests[i].size > 0) requests[i].buffer[0] = '\0';
+    }
+
+    size_t start = 0;
+#ifdef CF_HAVE_IO_URING
+    if (ring && count >= BATCH_MIN_URING_REQUESTS && read_ring_ready(ring)) {
+        while (start < count) {
+            size_t n = count - start < BATCH_MAX_CHUNK ? count - start : BATCH_MAX_CHUNK;
+            bool valid = true;
+            for (size_t i = start; i < start + n; i++) {
+                if (!requests[i].path || !requests[i].buffer || requests[i].size == 0) valid = false;
+            }
+            if (!valid) break;
+            if (!read_chunk_uring(&ring->uring, requests + start, n)) {
+                // Its queues may be out of step now: never reuse it.
+                uring_close(&ring->uring);
+                ring->opened = false;
+                ring->unusable = true;
+                break;
+            }
+            start += n;
+        }
+    }
+#endif
+
+    // No io_uring (old kernel, seccomp, non-Linux) or it failed part-way.
+    for (size_t i = start; i < count; i++) {
+        requests[i].result = read_one(&requests[i]);
+    }
+
+    size_t ok = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (requests[i].result >= 0) ok++;
+    }
+    return ok;
+}
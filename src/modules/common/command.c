@@ -0,0 +1,334 @@
+#include "module_helpers.h"
+
+// Keeps what fits in `output`, growing it first for `grow_output` commands.
+static void append_output(struct cf_command *command, const char *chunk, size_t len) {
+    if (command->grow_output && command->output_len + len + 1 > command->output_size) {
+        size_t cap = command->output_size ? command->output_size : 4096;
+        while (command->output_len + len + 1 > cap) cap *= 2;
+        char *grown = realloc(command->output, cap);
+        if (grown) {
+            command->output = grown;
+            command->output_size = cap;
+        }
+    }
+    if (!command->output || command->output_len + 1 >= command->output_size) return;
+
+    size_t room = command->output_size - 1 - command->output_len;
+    size_t copy = len < room ? len : room;
+    memcpy(command->output + command->output_len, chunk, copy);
+    command->output_len += copy;
+    command->output[command->output_len] = '\0';
+}
+
+#ifndef _WIN32
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <time.h>
+
+extern char **environ;
+
+#define COMMAND_MAX_ARGS 32
+#define COMMAND_LINE_MAX 1024
+#define COMMAND_MAX_PARALLEL 16
+#define COMMAND_READ_CHUNK 4096
+#define COMMAND_REDIRECT " 2>/dev/null"
+
+struct running_command {
+    struct cf_command *command;
+    pid_t pid;
+    int fd;
+    long long deadline_ms;
+    char last_byte;
+    bool stopped_early;
+};
+
+static long long monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Stderr always goes to /dev/null, so a trailing "2>/dev/null" asks for
+// nothing the runner doesn't already do.
+static size_t command_length(const char *command) {
+    size_t len = strlen(command);
+    size_t suffix = strlen(COMMAND_REDIRECT);
+    if (len > suffix && strcmp(command + len - suffix, COMMAND_REDIRECT) == 0) len -= suffix;
+    return len;
+}
+
+static bool split_argv(char *line, char **argv, size_t max_args) {
+    size_t argc = 0;
+    for (char *p = line; *p; ) {
+        while (*p == ' ' || *p == '\t') *p++ = '\0';
+        if (!*p) break;
+        if (argc + 1 >= max_args) return false;
+        argv[argc++] = p;
+        while (*p && *p != ' ' && *p != '\t') p++;
+    }
+    argv[argc] = NULL;
+    return argc > 0;
+}
+
+static bool set_cloexec(int fd) {
+    int flags = fcntl(fd, F_GETFD);
+    return flags >= 0 && fcntl(fd, F_SETFD, flags | FD_CLOEXEC) == 0;
+}
+
+// posix_spawn() (clone with CLONE_VFORK on glibc) rather than popen()'s
+// fork of a whole /bin/sh. Each child leads its own process group so a
+// deadline can kill whatever it started too.
+static pid_t spawn_command(const char *command, int *fd_out) {
+    char line[COMMAND_LINE_MAX];
+    size_t len = command_length(command);
+    bool use_shell = cf_command_needs_shell(command);
+    if (use_shell) len = strlen(command);
+    if (len >= sizeof(line)) return -1;
+    memcpy(line, command, len);
+    line[len] = '\0';
+
+    char *argv[COMMAND_MAX_ARGS];
+    char sh_name[] = "sh";
+    char sh_flag[] = "-c";
+    if (use_shell) {
+        argv[0] = sh_name;
+        argv[1] = sh_flag;
+        argv[2] = line;
+        argv[3] = NULL;
+    } else if (!split_argv(line, argv, COMMAND_MAX_ARGS)) {
+        return -1;
+    }
+
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+    if (!set_cloexec(fds[0]) || !set_cloexec(fds[1]) ||
+        fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK) != 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    sigset_t default_signals;
+    sigemptyset(&default_signals);
+    sigaddset(&default_signals, SIGPIPE);
+
+    pid_t pid = -1;
+    bool ready = posix_spawn_file_actions_init(&actions) == 0;
+    if (ready && posix_spawnattr_init(&attr) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        ready = false;
+    }
+    if (ready) {
+        int rc = posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+        if (rc == 0) rc = posix_spawn_file_actions_adddup2(&actions, fds[1], 1);
+        if (rc == 0) rc = posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+        if (rc == 0) rc = posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF);
+        if (rc == 0) rc = posix_spawnattr_setpgroup(&attr, 0);
+        if (rc == 0) rc = posix_spawnattr_setsigdefault(&attr, &default_signals);
+        if (rc == 0) {
+            rc = use_shell ? posix_spawn(&pid, "/bin/sh", &actions, &attr, argv, environ)
+                           : posix_spawnp(&pid, argv[0], &actions, &attr, argv, environ);
+        }
+        if (rc != 0) pid = -1;
+        posix_spawnattr_destroy(&attr);
+        posix_spawn_file_actions_destroy(&actions);
+    }
+
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        return -1;
+    }
+    *fd_out = fds[0];
+    return pid;
+}
+
+static void stop_command(struct running_command *run, bool kill_group) {
+    if (kill_group && run->pid > 0) kill(-run->pid, SIGKILL);
+    if (run->fd >= 0) close(run->fd);
+    run->fd = -1;
+}
+
+// Returns false once the pipe is finished with (EOF, error or, for
+// `first_line` commands, a complete first line).
+static bool drain_output(struct running_command *run) {
+    struct cf_command *command = run->command;
+    char chunk[COMMAND_READ_CHUNK];
+
+    for (;;) {
+        ssize_t nread = read(run->fd, chunk, sizeof(chunk));
+        if (nread < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        if (nread == 0) return false;
+
+        for (ssize_t i = 0; i < nread; i++) {
+            if (chunk[i] == '\n') command->lines++;
+        }
+        run->last_byte = chunk[nread - 1];
+
+        append_output(command, chunk, (size_t)nread);
+        if (command->first_line && command->lines > 0) {
+            run->stopped_early = true;
+            return false;
+        }
+    }
+}
+
+// Reaps the child, killing its group once the deadline has passed.
+static void reap_command(struct running_command *run) {
+    struct cf_command *command = run->command;
+    struct timespec pause_ts = {0, 1000000};
+    int status = 0;
+
+    for (;;) {
+        pid_t rc = waitpid(run->pid, &status, WNOHANG);
+        if (rc == run->pid) break;
+        if (rc < 0 && errno != EINTR) return;
+        if (rc == 0 && monotonic_ms() >= run->deadline_ms) {
+            command->timed_out = true;
+            kill(-run->pid, SIGKILL);
+            while (waitpid(run->pid, &status, 0) < 0 && errno == EINTR) {}
+            break;
+        }
+        if (rc == 0) nanosleep(&pause_ts, NULL);
+    }
+
+    // A `first_line` command killed after delivering its line succeeded.
+    if (run->stopped_early && !command->timed_out) {
+        command->exit_status = 0;
+    } else if (!command->timed_out && WIFEXITED(status)) {
+        command->exit_status = WEXITSTATUS(status);
+    }
+}
+
+static void run_wave(struct cf_command *commands, size_t count) {
+    struct running_command runs[COMMAND_MAX_PARALLEL];
+    struct pollfd pfds[COMMAND_MAX_PARALLEL];
+    long long start = monotonic_ms();
+
+    for (size_t i = 0; i < count; i++) {
+        int timeout = commands[i].timeout_ms > 0 ? commands[i].timeout_ms : CF_COMMAND_TIMEOUT_MS;
+        runs[i].command = &commands[i];
+        runs[i].deadline_ms = start + timeout;
+        runs[i].last_byte = '\n';
+        runs[i].stopped_early = false;
+        runs[i].fd = -1;
+        runs[i].pid = commands[i].command ? spawn_command(commands[i].command, &runs[i].fd) : -1;
+    }
+
+    for (;;) {
+        long long now = monotonic_ms();
+        long long wait_ms = -1;
+        nfds_t nfds = 0;
+        size_t owners[COMMAND_MAX_PARALLEL];
+
+        for (size_t i = 0; i < count; i++) {
+            if (runs[i].fd < 0) continue;
+            if (now >= runs[i].deadline_ms) {
+                runs[i].command->timed_out = true;
+                stop_command(&runs[i], true);
+                continue;
+            }
+            long long remaining = runs[i].deadline_ms - now;
+            if (wait_ms < 0 || remaining < wait_ms) wait_ms = remaining;
+            pfds[nfds].fd = runs[i].fd;
+            pfds[nfds].events = POLLIN;
+            pfds[nfds].revents = 0;
+            owners[nfds++] = i;
+        }
+        if (nfds == 0) break;
+
+        int ready = poll(pfds, nfds, (int)wait_ms);
+        if (ready < 0 && errno != EINTR) {
+            for (nfds_t j = 0; j < nfds; j++) stop_command(&runs[owners[j]], true);
+            break;
+        }
+        for (nfds_t j = 0; ready > 0 && j < nfds; j++) {
+            if (pfds[j].revents == 0) continue;
+            struct running_command *run = &runs[owners[j]];
+            if (!drain_output(run)) stop_command(run, run->stopped_early);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (runs[i].pid < 0) continue;
+        reap_command(&runs[i]);
+        // An unterminated last line still counts, as it would for fgets().
+        if (runs[i].last_byte != '\n') runs[i].command->lines++;
+    }
+}
+#endif
+
+bool cf_command_needs_shell(const char *command) {
+    if (!command || !command[0]) return true;
+#ifdef _WIN32
+    return true;
+#else
+    size_t len = command_length(command);
+    bool first_word = true;
+    for (size_t i = 0; i < len; i++) {
+        char c = command[i];
+        if (strchr("|;&><`$()'\"\\*?[]{}~#\n\r", c)) return true;
+        // "NAME=value cmd" is an assignment only the shell understands.
+        if (c == '=' && first_word) return true;
+        if (c == ' ' || c == '\t') first_word = false;
+    }
+    return false;
+#endif
+}
+
+size_t cf_run_commands(struct cf_command *commands, size_t count) {
+    if (!commands) return 0;
+
+    for (size_t i = 0; i < count; i++) {
+        commands[i].output_len = 0;
+        commands[i].lines = 0;
+        commands[i].exit_status = -1;
+        commands[i].timed_out = false;
+        if (commands[i].output && commands[i].output_size > 0) commands[i].output[0] = '\0';
+    }
+
+#ifdef _WIN32
+    // No deadlines here: _popen() offers no way to stop the command.
+    for (size_t i = 0; i < count; i++) {
+        struct cf_command *command = &commands[i];
+        if (!command->command || !command->command[0]) continue;
+        FILE *fp = popen(command->command, "r");
+        if (!fp) continue;
+
+        char chunk[4096];
+        size_t nread;
+        char last_byte = '\n';
+        while ((nread = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+            for (size_t j = 0; j < nread; j++) {
+                if (chunk[j] == '\n') command->lines++;
+            }
+            last_byte = chunk[nread - 1];
+            append_output(command, chunk, nread);
+        }
+        if (last_byte != '\n') command->lines++;
+        command->exit_status = pclose(fp);
+    }
+#else
+    for (size_t start = 0; start < count; start += COMMAND_MAX_PARALLEL) {
+        size_t n = count - start < COMMAND_MAX_PARALLEL ? count - start : COMMAND_MAX_PARALLEL;
+        run_wave(commands + start, n);
+    }
+#endif
+
+    size_t ok = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (commands[i].exit_status == 0) ok++;
+    }
+    return ok;
+}
+
+bool cf_run_command(struct cf_command *command) {
+    return cf_run_commands(command, 1) == 1;
+}
@@ -0,0 +1,116 @@
+// SO_PEERCRED and struct ucred are GNU extensions in glibc.
+#define _GNU_SOURCE
+
+#include "module_helpers.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+bool cf_unix_socket_peer_pid(const char *socket_path, long *pid_out) {
+#ifdef _WIN32
+    (void)socket_path;
+    (void)pid_out;
+    return false;
+#else
+    if (!socket_path || !socket_path[0] || !pid_out) return false;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    size_t path_len = strlen(socket_path);
+    if (path_len >= sizeof(addr.sun_path)) return false;
+    memcpy(addr.sun_path, socket_path, path_len + 1);
+
+    // Non-blocking so a server with a full backlog fails fast instead of
+    // stalling the fetch; a unix connect otherwise completes immediately.
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0) return false;
+
+    bool ok = false;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        struct ucred cred;
+        socklen_t len = sizeof(cred);
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && len == sizeof(cred) && cred.pid > 0) {
+            *pid_out = (long)cred.pid;
+            ok = true;
+        }
+    }
+
+    close(fd);
+    return ok;
+#endif
+}
+
+static bool x11_socket_from_display(const char *display, char *out, size_t out_size) {
+    // Local displays only: ":0", ":1.0" or "unix:0"; "host:0" is TCP.
+    const char *colon = strrchr(display, ':');
+    if (!colon) return false;
+    if (colon != display && strncmp(display, "unix:", 5) != 0) return false;
+
+    char *endptr = NULL;
+    long number = strtol(colon + 1, &endptr, 10);
+    if (endptr == colon + 1 || number < 0) return false;
+
+    return snprintf(out, out_size, "/tmp/.X11-unix/X%ld", number) < (int)out_size;
+}
+
+bool cf_display_socket_path(char *out, size_t out_size, bool *is_wayland_out) {
+    if (!out || out_size == 0) return false;
+    out[0] = '\0';
+
+    const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
+    const char *wayland_display = getenv("WAYLAND_DISPLAY");
+    const char *x_display = getenv("DISPLAY");
+
+    if (wayland_display && wayland_display[0]) {
+        bool ok = false;
+        if (wayland_display[0] == '/') {
+            ok = snprintf(out, out_size, "%s", wayland_display) < (int)out_size;
+        } else if (runtime_dir && runtime_dir[0]) {
+            ok = snprintf(out, out_size, "%s/%s", runtime_dir, wayland_display) < (int)out_size;
+        }
+        if (ok) {
+            if (is_wayland_out) *is_wayland_out = true;
+            return true;
+        }
+    }
+
+    if (x_display && x_display[0] && x11_socket_from_display(x_display, out, out_size)) {
+        if (is_wayland_out) *is_wayland_out = false;
+        return true;
+    }
+
+    // No display variables (e.g. run from a tty or ssh): try the defaults.
+    if ((!wayland_display || !wayland_display[0]) && (!x_display || !x_display[0])) {
+        if (runtime_dir && runtime_dir[0] &&
+            snprintf(out, out_size, "%s/wayland-0", runtime_dir) < (int)out_size && access(out, F_OK) == 0) {
+            if (is_wayland_out) *is_wayland_out = true;
+            return true;
+        }
+        if (snprintf(out, out_size, "/tmp/.X11-unix/X0") < (int)out_size && access(out, F_OK) == 0) {
+            if (is_wayland_out) *is_wayland_out = false;
+            return true;
+        }
+    }
+
+    out[0] = '\0';
+    return false;
+}
+
+bool cf_display_server_pid(long *pid_out, bool *is_wayland_out) {
+    char socket_path[512];
+    bool is_wayland = false;
+    if (!cf_display_socket_path(socket_path, sizeof(socket_path), &is_wayland)) return false;
+    if (!cf_unix_socket_peer_pid(socket_path, pid_out)) return false;
+
+    if (is_wayland_out) *is_wayland_out = is_wayland;
+    return true;
+}
+
+const char *cf_detect_display_server_label(const struct process_match *candidates, size_t num_candidates) {
+    long pid = 0;
+    if (!cf_display_server_pid(&pid, NULL)) return NULL;
+    return cf_process_label_for_pid(pid, candidates, num_candidates);
+}
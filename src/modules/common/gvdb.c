@@ -0,0 +1,252 @@
+#include "gvdb.h"
+#include "module_helpers.h"
+
+#include <limits.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+// Layout from GLib's gvdb-format.h: a 24-byte file header whose root pointer
+// names a hash table of [hash header][bloom words][buckets][24-byte items].
+#define GVDB_HEADER_SIZE 24
+#define GVDB_HASH_HEADER_SIZE 8
+#define GVDB_ITEM_SIZE 24
+#define GVDB_NO_PARENT 0xffffffffu
+#define GVDB_MAX_KEY_DEPTH 64
+
+struct gvdb_table {
+    const unsigned char *data;
+    size_t size;
+    bool byteswapped;
+    const unsigned char *bloom_words;
+    uint32_t n_bloom_words;
+    uint32_t bloom_shift;
+    const unsigned char *buckets;
+    uint32_t n_buckets;
+    const unsigned char *items;
+    uint32_t n_items;
+};
+
+static uint32_t read_u32(const unsigned char *p, bool byteswapped) {
+    if (byteswapped) {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+    }
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t read_u16(const unsigned char *p, bool byteswapped) {
+    if (byteswapped) return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+// djb2 over signed chars, matching gvdb_hash().
+static uint32_t gvdb_hash(const char *key) {
+    uint32_t hash = 5381;
+    for (; *key; key++) {
+        hash = hash * 33 + (uint32_t)(signed char)*key;
+    }
+    return hash;
+}
+
+static bool gvdb_table_open(struct gvdb_table *table, const void *data, size_t size) {
+    memset(table, 0, sizeof(*table));
+    if (!data || size < GVDB_HEADER_SIZE) return false;
+
+    const unsigned char *bytes = data;
+    if (memcmp(bytes, "GVariant", 8) == 0) {
+        table->byteswapped = false;
+    } else if (memcmp(bytes, "raVGtnai", 8) == 0) {
+        table->byteswapped = true;
+    } else {
+        return false;
+    }
+
+    uint32_t root_start = read_u32(bytes + 16, table->byteswapped);
+    uint32_t root_end = read_u32(bytes + 20, table->byteswapped);
+    if (root_start > root_end || root_end > size || (root_start & 3u) != 0 ||
+        root_end - root_start < GVDB_HASH_HEADER_SIZE) {
+        return false;
+    }
+
+    const unsigned char *hash = bytes + root_start;
+    uint32_t bloom_header = read_u32(hash, table->byteswapped);
+    uint64_t n_bloom_words = bloom_header & ((1u << 27) - 1);
+    uint64_t n_buckets = read_u32(hash + 4, table->byteswapped);
+    uint64_t fixed_size = GVDB_HASH_HEADER_SIZE + (n_bloom_words + n_buckets) * 4;
+    uint64_t table_size = root_end - root_start;
+    if (fixed_size > table_size) return false;
+
+    table->data = bytes;
+    table->size = size;
+    table->bloom_shift = bloom_header >> 27;
+    table->n_bloom_words = (uint32_t)n_bloom_words;
+    table->bloom_words = hash + GVDB_HASH_HEADER_SIZE;
+    table->n_buckets = (uint32_t)n_buckets;
+    table->buckets = table->bloom_words + n_bloom_words * 4;
+    table->items = table->buckets + n_buckets * 4;
+    table->n_items = (uint32_t)((table_size - fixed_size) / GVDB_ITEM_SIZE);
+    return true;
+}
+
+static bool gvdb_bloom_allows(const struct gvdb_table *table, uint32_t hash) {
+    if (table->n_bloom_words == 0) return true;
+
+    uint32_t word = (hash / 32) % table->n_bloom_words;
+    uint32_t mask = (1u << (hash & 31)) | (1u << ((hash >> table->bloom_shift) & 31));
+    return (read_u32(table->bloom_words + word * 4, table->byteswapped) & mask) == mask;
+}
+
+// Items store only their own key segment and link to the parent's, so the
+// full key is matched from its tail back towards the root.
+static bool gvdb_check_key(const struct gvdb_table *table, uint32_t index, const char *key, size_t key_len) {
+    for (int depth = 0; depth < GVDB_MAX_KEY_DEPTH; depth++) {
+        const unsigned char *item = table->items + (size_t)index * GVDB_ITEM_SIZE;
+        uint32_t key_start = read_u32(item + 8, table->byteswapped);
+        uint16_t key_size = read_u16(item + 12, table->byteswapped);
+
+        if ((uint64_t)key_start + key_size > table->size || key_len < key_size) return false;
+        key_len -= key_size;
+        if (memcmp(table->data + key_start, key + key_len, key_size) != 0) return false;
+
+        uint32_t parent = read_u32(item + 4, table->byteswapped);
+        if (parent == GVDB_NO_PARENT) return key_len == 0;
+        if (parent >= table->n_items) return false;
+        index = parent;
+    }
+    return false;
+}
+
+static const unsigned char *gvdb_lookup_item(const struct gvdb_table *table, const char *key, char type) {
+    if (table->n_buckets == 0 || table->n_items == 0) return NULL;
+
+    uint32_t hash = gvdb_hash(key);
+    if (!gvdb_bloom_allows(table, hash)) return NULL;
+
+    uint32_t bucket = hash % table->n_buckets;
+    uint32_t itemno = read_u32(table->buckets + (size_t)bucket * 4, table->byteswapped);
+    uint32_t lastno = table->n_items;
+    if (bucket + 1 < table->n_buckets) {
+        uint32_t next = read_u32(table->buckets + (size_t)(bucket + 1) * 4, table->byteswapped);
+        if (next <= table->n_items) lastno = next;
+    }
+
+    size_t key_len = strlen(key);
+    for (; itemno < lastno; itemno++) {
+        const unsigned char *item = table->items + (size_t)itemno * GVDB_ITEM_SIZE;
+        if (read_u32(item, table->byteswapped) != hash || (char)item[14] != type) continue;
+        if (gvdb_check_key(table, itemno, key, key_len)) return item;
+    }
+    return NULL;
+}
+
+bool cf_gvdb_lookup_string(const void *data, size_t size, const char *key, char *out, size_t out_size) {
+    if (!key || !out || out_size == 0) return false;
+
+    struct gvdb_table table;
+    if (!gvdb_table_open(&table, data, size)) return false;
+
+    // dconf stores values as serialised GVariant 'v' items.
+    const unsigned char *item = gvdb_lookup_item(&table, key, 'v');
+    if (!item) return false;
+
+    uint32_t start = read_u32(item + 16, table.byteswapped);
+    uint32_t end = read_u32(item + 20, table.byteswapped);
+    if (start >= end || end > size) return false;
+
+    // A variant is the child's bytes, a NUL separator, then its type string;
+    // a string child is itself NUL-terminated, so "value\0\0s".
+    const unsigned char *blob = table.data + start;
+    size_t len = end - start;
+    size_t sep = len;
+    while (sep > 0 && blob[sep - 1] != '\0') sep--;
+    if (sep < 2) return false;
+    sep--;
+
+    if (len - sep - 1 != 1 || blob[sep + 1] != 's' || blob[sep - 1] != '\0') return false;
+
+    size_t value_len = strlen((const char *)blob);
+    if (value_len >= out_size) value_len = out_size - 1;
+    memcpy(out, blob, value_len);
+    out[value_len] = '\0';
+    return out[0] != '\0';
+}
+
+#ifndef _WIN32
+static struct {
+    void *data;
+    size_t size;
+    dev_t dev;
+    ino_t ino;
+    time_t mtime;
+    bool mapped;
+} g_dconf_map;
+static cf_mutex g_dconf_lock = CF_MUTEX_INIT;
+
+static void dconf_unmap(void) {
+    if (g_dconf_map.mapped && g_dconf_map.data) munmap(g_dconf_map.data, g_dconf_map.size);
+    memset(&g_dconf_map, 0, sizeof(g_dconf_map));
+}
+
+static bool dconf_user_db_path(char *out, size_t out_size) {
+    const char *xdg = getenv("XDG_CONFIG_HOME");
+    if (xdg && xdg[0]) return snprintf(out, out_size, "%s/dconf/user", xdg) < (int)out_size;
+
+    const char *home = getenv("HOME");
+    if (home && home[0]) return snprintf(out, out_size, "%s/.config/dconf/user", home) < (int)out_size;
+
+    return false;
+}
+
+static bool dconf_read_string(const char *key, char *out, size_t out_size, bool *db_present_out) {
+    char path[PATH_MAX];
+    struct stat st;
+    if (!dconf_user_db_path(path, sizeof(path)) || stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        dconf_unmap();
+        return false;
+    }
+    if (db_present_out) *db_present_out = true;
+
+    // dconf rewrites the database by rename, so a new inode means new data.
+    bool current = g_dconf_map.mapped && g_dconf_map.dev == st.st_dev && g_dconf_map.ino == st.st_ino &&
+                   g_dconf_map.size == (size_t)st.st_size && g_dconf_map.mtime == st.st_mtime;
+    if (!current) {
+        dconf_unmap();
+        if (st.st_size <= 0) return false;
+
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) return false;
+
+        g_dconf_map.data = data;
+        g_dconf_map.size = (size_t)st.st_size;
+        g_dconf_map.dev = st.st_dev;
+        g_dconf_map.ino = st.st_ino;
+        g_dconf_map.mtime = st.st_mtime;
+        g_dconf_map.mapped = true;
+    }
+
+    return cf_gvdb_lookup_string(g_dconf_map.data, g_dconf_map.size, key, out, out_size);
+}
+#endif
+
+bool cf_dconf_read_string(const char *key, char *out, size_t out_size, bool *db_present_out) {
+    if (db_present_out) *db_present_out = false;
+#ifdef _WIN32
+    (void)key;
+    (void)out;
+    (void)out_size;
+    return false;
+#else
+    // The mapping is swapped when dconf replaces the file; readers hold the
+    // lock until their value is copied out.
+    cf_mutex_lock(&g_dconf_lock);
+    bool found = dconf_read_string(key, out, out_size, db_present_out);
+    cf_mutex_unlock(&g_dconf_lock);
+    return found;
+#endif
+}
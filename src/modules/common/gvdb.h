@@ -0,0 +1,16 @@
+#ifndef GVDB_H
+#define GVDB_H
+
+#include "../../cupidfetch.h"
+
+// Look up a string-valued key (e.g. "/org/gnome/desktop/interface/gtk-theme")
+// in an in-memory GVDB table, the on-disk format dconf uses for its databases.
+// Returns false when the table is malformed, the key is unset or not a string.
+bool cf_gvdb_lookup_string(const void *data, size_t size, const char *key, char *out, size_t out_size);
+
+// Same lookup against the user's dconf database (~/.config/dconf/user), mapped
+// once and re-mapped when dconf replaces the file. `db_present_out` reports
+// whether the database exists, so callers can decide whether to fall back.
+bool cf_dconf_read_string(const char *key, char *out, size_t out_size, bool *db_present_out);
+
+#endif
@@ -0,0 +1,296 @@
+#include "keyfile.h"
+#include "module_helpers.h"
+
+#include <limits.h>
+
+#define KEYFILE_CACHE_CAP 8
+#define KEYFILE_BUCKETS 64
+#define KEYFILE_NO_ENTRY (-1)
+
+struct keyfile_entry {
+    const char *section;
+    const char *key;
+    const char *value;
+    unsigned int hash;
+    int next;
+};
+
+// Stat fields used to tell whether a cached parse is still current.
+struct keyfile_stamp {
+    bool exists;
+    long long size;
+    long long mtime_sec;
+    long mtime_nsec;
+    unsigned long long inode;
+};
+
+/*
+ * One parsed file. `text` owns the file contents and every section/key/value
+ * pointer in `entries` points into it, so a reload is a single free.
+ */
+struct keyfile {
+    char path[PATH_MAX];
+    struct keyfile_stamp stamp;
+    char *text;
+    struct keyfile_entry *entries;
+    size_t count;
+    size_t capacity;
+    int buckets[KEYFILE_BUCKETS];
+};
+
+static cf_mutex g_keyfile_lock = CF_MUTEX_INIT;
+static struct keyfile g_keyfiles[KEYFILE_CACHE_CAP];
+static size_t g_keyfile_count = 0;
+static size_t g_keyfile_evict = 0;
+
+static bool eq_icase(const char *a, const char *b) {
+    if (!a || !b) return false;
+    while (*a && *b) {
+        if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) return false;
+        a++;
+        b++;
+    }
+    return *a == '\0' && *b == '\0';
+}
+
+// FNV-1a over the lowercased section and key.
+static unsigned int hash_icase(unsigned int hash, const char *str) {
+    for (; *str; str++) {
+        hash ^= (unsigned char)tolower((unsigned char)*str);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static unsigned int entry_hash(const char *section, const char *key) {
+    unsigned int hash = hash_icase(2166136261u, section);
+    hash ^= (unsigned char)'\n';
+    hash *= 16777619u;
+    return hash_icase(hash, key);
+}
+
+void cf_keyfile_normalize_value(char *value) {
+    if (!value) return;
+
+    char *trimmed = cf_trim_spaces(value);
+    if (trimmed != value) {
+        memmove(value, trimmed, strlen(trimmed) + 1);
+    }
+
+    size_t len = strlen(value);
+    if (len >= 2) {
+        bool single_quoted = value[0] == '\'' && value[len - 1] == '\'';
+        bool double_quoted = value[0] == '"' && value[len - 1] == '"';
+        if (single_quoted || double_quoted) {
+            memmove(value, value + 1, len - 2);
+            value[len - 2] = '\0';
+        }
+    }
+
+    trimmed = cf_trim_spaces(value);
+    if (trimmed != value) {
+        memmove(value, trimmed, strlen(trimmed) + 1);
+    }
+}
+
+static void keyfile_release(struct keyfile *kf) {
+    free(kf->text);
+    free(kf->entries);
+    kf->text = NULL;
+    kf->entries = NULL;
+    kf->count = 0;
+    kf->capacity = 0;
+    for (size_t i = 0; i < KEYFILE_BUCKETS; i++) kf->buckets[i] = KEYFILE_NO_ENTRY;
+}
+
+static bool keyfile_add(struct keyfile *kf, const char *section, const char *key, const char *value) {
+    unsigned int hash = entry_hash(section, key);
+    size_t bucket = hash & (KEYFILE_BUCKETS - 1);
+
+    // The first occurrence wins, as it did with the line-by-line scan.
+    for (int i = kf->buckets[bucket]; i != KEYFILE_NO_ENTRY; i = kf->entries[i].next) {
+        const struct keyfile_entry *entry = &kf->entries[i];
+        if (entry->hash == hash && eq_icase(entry->section, section) && eq_icase(entry->key, key)) {
+            return true;
+        }
+    }
+
+    if (kf->count == kf->capacity) {
+        size_t capacity = kf->capacity ? kf->capacity * 2 : 32;
+        struct keyfile_entry *entries = realloc(kf->entries, capacity * sizeof(*entries));
+        if (!entries) return false;
+        kf->entries = entries;
+        kf->capacity = capacity;
+    }
+
+    struct keyfile_entry *entry = &kf->entries[kf->count];
+    entry->section = section;
+    entry->key = key;
+    entry->value = value;
+    entry->hash = hash;
+    entry->next = kf->buckets[bucket];
+    kf->buckets[bucket] = (int)kf->count;
+    kf->count++;
+    return true;
+}
+
+static void keyfile_parse(struct keyfile *kf) {
+    static char no_section[] = "";
+    char *section = no_section;
+
+    for (char *line = kf->text; line; ) {
+        char *newline = strchr(line, '\n');
+        if (newline) *newline = '\0';
+        char *next = newline ? newline + 1 : NULL;
+
+        char *trimmed = cf_trim_spaces(line);
+        size_t len = strlen(trimmed);
+        line = next;
+        if (!trimmed[0] || trimmed[0] == '#' || trimmed[0] == ';') continue;
+
+        if (trimmed[0] == '[' && len > 2 && trimmed[len - 1] == ']') {
+            trimmed[len - 1] = '\0';
+            section = cf_trim_spaces(trimmed + 1);
+            continue;
+        }
+
+        char *eq = strchr(trimmed, '=');
+        if (!eq) continue;
+
+        *eq = '\0';
+        char *key = cf_trim_spaces(trimmed);
+        char *value = eq + 1;
+        cf_keyfile_normalize_value(value);
+        if (!key[0]) continue;
+
+        if (!keyfile_add(kf, section, key, value)) return;
+    }
+}
+
+static void read_stamp(const char *path, struct keyfile_stamp *stamp) {
+    struct stat st;
+    memset(stamp, 0, sizeof(*stamp));
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) return;
+
+    stamp->exists = true;
+    stamp->size = (long long)st.st_size;
+    stamp->mtime_sec = (long long)st.st_mtime;
+#ifndef _WIN32
+    stamp->mtime_nsec = st.st_mtim.tv_nsec;
+    stamp->inode = (unsigned long long)st.st_ino;
+#endif
+}
+
+static bool stamp_equal(const struct keyfile_stamp *a, const struct keyfile_stamp *b) {
+    if (!a->exists || !b->exists) return a->exists == b->exists;
+    return a->size == b->size && a->mtime_sec == b->mtime_sec &&
+           a->mtime_nsec == b->mtime_nsec && a->inode == b->inode;
+}
+
+static void keyfile_load(struct keyfile *kf) {
+    if (!kf->stamp.exists) return;
+
+    FILE *fp = fopen(kf->path, "rb");
+    if (!fp) return;
+
+    size_t size = (size_t)kf->stamp.size;
+    kf->text = malloc(size + 1);
+    if (!kf->text) {
+        fclose(fp);
+        return;
+    }
+
+    size_t nread = fread(kf->text, 1, size, fp);
+    fclose(fp);
+    kf->text[nread] = '\0';
+    keyfile_parse(kf);
+}
+
+static struct keyfile *keyfile_lookup(const char *path) {
+    size_t path_len = strlen(path);
+    if (path_len >= sizeof(g_keyfiles[0].path)) return NULL;
+
+    // One stat per lookup keeps watch-mode redraws honest without re-parsing.
+    struct keyfile_stamp stamp;
+    read_stamp(path, &stamp);
+
+    struct keyfile *kf = NULL;
+    for (size_t i = 0; i < g_keyfile_count; i++) {
+        if (strcmp(g_keyfiles[i].path, path) == 0) {
+            kf = &g_keyfiles[i];
+            break;
+        }
+    }
+
+    if (kf && stamp_equal(&kf->stamp, &stamp)) return kf;
+
+    if (!kf) {
+        if (g_keyfile_count < KEYFILE_CACHE_CAP) {
+            kf = &g_keyfiles[g_keyfile_count++];
+            kf->text = NULL;
+            kf->entries = NULL;
+        } else {
+            kf = &g_keyfiles[g_keyfile_evict];
+            g_keyfile_evict = (g_keyfile_evict + 1) % KEYFILE_CACHE_CAP;
+        }
+        memcpy(kf->path, path, path_len + 1);
+    }
+
+    keyfile_release(kf);
+    kf->stamp = stamp;
+    keyfile_load(kf);
+    return kf;
+}
+
+static bool keyfile_get(const char *path, const char *section, const char *key, char *out, size_t out_size) {
+    struct keyfile *kf = keyfile_lookup(path);
+    if (!kf || kf->count == 0) return false;
+
+    const struct keyfile_entry *found = NULL;
+    if (section && section[0]) {
+        unsigned int hash = entry_hash(section, key);
+        for (int i = kf->buckets[hash & (KEYFILE_BUCKETS - 1)]; i != KEYFILE_NO_ENTRY; i = kf->entries[i].next) {
+            const struct keyfile_entry *entry = &kf->entries[i];
+            if (entry->hash == hash && eq_icase(entry->section, section) && eq_icase(entry->key, key)) {
+                found = entry;
+                break;
+            }
+        }
+    } else {
+        // Sectionless lookups (.gtkrc-2.0) take the first key in file order.
+        for (size_t i = 0; i < kf->count; i++) {
+            if (eq_icase(kf->entries[i].key, key)) {
+                found = &kf->entries[i];
+                break;
+            }
+        }
+    }
+
+    if (!found) return false;
+
+    strncpy(out, found->value, out_size - 1);
+    out[out_size - 1] = '\0';
+    return out[0] != '\0';
+}
+
+// The value is copied out under the lock, so a reload by another thread
+// can't free it from under the caller.
+bool cf_keyfile_get(const char *path, const char *section, const char *key, char *out, size_t out_size) {
+    if (!path || !key || !out || out_size == 0) return false;
+
+    cf_mutex_lock(&g_keyfile_lock);
+    bool found = keyfile_get(path, section, key, out, out_size);
+    cf_mutex_unlock(&g_keyfile_lock);
+    return found;
+}
+
+void cf_keyfile_cache_clear(void) {
+    cf_mutex_lock(&g_keyfile_lock);
+    for (size_t i = 0; i < g_keyfile_count; i++) {
+        keyfile_release(&g_keyfiles[i]);
+        g_keyfiles[i].path[0] = '\0';
+    }
+    g_keyfile_count = 0;
+    g_keyfile_evict = 0;
+    cf_mutex_unlock(&g_keyfile_lock);
+}
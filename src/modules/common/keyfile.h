@@ -0,0 +1,16 @@
+#ifndef KEYFILE_H
+#define KEYFILE_H
+
+#include "../../cupidfetch.h"
+
+// Look up `key` in `section` of an INI-style keyfile (GTK settings.ini,
+// kdeglobals, .gtkrc-2.0). A NULL or empty section matches the first key in
+// any section. Each file is parsed once and re-parsed only when its mtime or
+// size changes; names compare case-insensitively.
+bool cf_keyfile_get(const char *path, const char *section, const char *key, char *out, size_t out_size);
+void cf_keyfile_cache_clear(void);
+
+// Trim whitespace and one level of matching single or double quotes.
+void cf_keyfile_normalize_value(char *value);
+
+#endif
@@ -1,5 +1,9 @@
 #include "module_helpers.h"
 
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+
 #define CF_EXEC_CACHE_CAP 64
 
 struct cf_exec_cache_entry {
@@ -7,6 +11,7 @@ struct cf_exec_cache_entry {
     bool exists;
 };
 
+static cf_mutex g_exec_cache_lock = CF_MUTEX_INIT;
 static struct cf_exec_cache_entry g_exec_cache[CF_EXEC_CACHE_CAP];
 static size_t g_exec_cache_count = 0;
 static char g_exec_cache_path[4096] = "";
@@ -29,7 +34,8 @@ static bool cf_scan_executable_in_path(const char *path_env, const char *name) {
 #ifdef _WIN32
     sep = ";";
 #endif
-    char *token = strtok(path_copy, sep);
+    char *save = NULL;
+    char *token = strtok_r(path_copy, sep, &save);
     while (token) {
         char full[4352];
         const char *slash = "/";
@@ -44,46 +50,12 @@ static bool cf_scan_executable_in_path(const char *path_env, const char *name) {
             if (access(full, X_OK) == 0) return true;
         }
 #endif
-        token = strtok(NULL, sep);
+        token = strtok_r(NULL, sep, &save);
     }
 
     return false;
 }
 
-static bool process_matches(const char *pid, const char *needle) {
-#ifdef _WIN32
-    (void)pid;
-    (void)needle;
-    return false;
-#else
-    char path[64];
-    char comm[128];
-
-    snprintf(path, sizeof(path), "/proc/%s/comm", pid);
-    FILE *comm_file = fopen(path, "r");
-    if (comm_file) {
-        if (fgets(comm, sizeof(comm), comm_file)) {
-            cf_trim_newline(comm);
-            fclose(comm_file);
-            if (cf_contains_icase(comm, needle)) return true;
-        } else {
-            fclose(comm_file);
-        }
-    }
-
-    snprintf(path, sizeof(path), "/proc/%s/cmdline", pid);
-    FILE *cmdline_file = fopen(path, "r");
-    if (!cmdline_file) return false;
-
-    char cmdline[512];
-    size_t nread = fread(cmdline, 1, sizeof(cmdline) - 1, cmdline_file);
-    fclose(cmdline_file);
-    cmdline[nread] = '\0';
-
-    return cf_contains_icase(cmdline, needle);
-#endif
-}
-
 void cf_trim_newline(char *str) {
     str[strcspn(str, "\r\n")] = '\0';
 }
@@ -103,14 +75,15 @@ bool cf_contains_icase(const char *haystack, const char *needle) {
     return false;
 }
 
-const char *cf_detect_process_label(const struct process_match *candidates, size_t num_candidates) {
+void cf_for_each_pid(cf_pid_visitor visit, void *ctx) {
 #ifdef _WIN32
-    (void)candidates;
-    (void)num_candidates;
-    return NULL;
+    (void)visit;
+    (void)ctx;
 #else
+    if (!visit) return;
+
     DIR *dir = opendir("/proc");
-    if (!dir) return NULL;
+    if (!dir) return;
 
     struct dirent *entry;
     while ((entry = readdir(dir)) != NULL) {
@@ -119,19 +92,186 @@ const char *cf_detect_process_label(const struct process_match *candidates, size
         const char *pid = entry->d_name;
         if (!isdigit((unsigned char)pid[0])) continue;
 
-        for (size_t i = 0; i < num_candidates; i++) {
-            if (process_matches(pid, candidates[i].proc_name)) {
-                closedir(dir);
-                return candidates[i].label;
+        if (visit(pid, ctx)) break;
+    }
+
+    closedir(dir);
+#endif
+}
+
+bool cf_cgroup_user_slice_prefix(const char *cgroup_path, char *out, size_t out_size) {
+    if (!cgroup_path || !out || out_size == 0) return false;
+
+    // systemd puts every login session and the user manager under
+    // /user.slice/user-<uid>.slice/; keep the path up to that component.
+    for (const char *p = strstr(cgroup_path, "/user-"); p; p = strstr(p + 1, "/user-")) {
+        const char *digits = p + 6;
+        const char *end = digits;
+        while (isdigit((unsigned char)*end)) end++;
+        if (end == digits || strncmp(end, ".slice", 6) != 0 || (end[6] != '/' && end[6] != '\0')) continue;
+
+        size_t len = (size_t)(end + 6 - cgroup_path);
+        if (len >= out_size) return false;
+        memcpy(out, cgroup_path, len);
+        out[len] = '\0';
+        return true;
+    }
+    return false;
+}
+
+#ifndef _WIN32
+#define CF_CGROUP_WALK_MAX_DEPTH 16
+
+static bool read_cgroup_v2_location(const char **mount_out, char *path_out, size_t path_out_size);
+
+// Visits the pids in cgroup.procs of `dir` and every cgroup below it;
+// returns true once the visitor asks to stop.
+static bool walk_cgroup_procs(const char *dir, int depth, cf_pid_visitor visit, void *ctx) {
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/cgroup.procs", dir) >= (int)sizeof(path)) return false;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        // cgroup.procs can list thousands of pids, so it is streamed through
+        // a stack buffer with any partial last line carried over.
+        char buffer[4096];
+        size_t used = 0;
+        bool stop = false;
+        for (;;) {
+            ssize_t nread = read(fd, buffer + used, sizeof(buffer) - 1 - used);
+            if (nread < 0 && errno == EINTR) continue;
+            if (nread <= 0) break;
+            used += (size_t)nread;
+            buffer[used] = '\0';
+
+            char *line = buffer;
+            char *newline;
+            while (!stop && (newline = strchr(line, '\n')) != NULL) {
+                *newline = '\0';
+                if (line[0]) stop = visit(line, ctx);
+                line = newline + 1;
             }
+            if (stop) break;
+
+            used = (size_t)(buffer + used - line);
+            memmove(buffer, line, used);
+            if (used == sizeof(buffer) - 1) used = 0;
+        }
+        if (!stop && used > 0) {
+            buffer[used] = '\0';
+            stop = visit(buffer, ctx);
         }
+        close(fd);
+        if (stop) return true;
     }
 
-    closedir(dir);
-    return NULL;
+    if (depth >= CF_CGROUP_WALK_MAX_DEPTH) return false;
+
+    DIR *children = opendir(dir);
+    if (!children) return false;
+
+    bool stop = false;
+    struct dirent *entry;
+    while (!stop && (entry = readdir(children)) != NULL) {
+        if (entry->d_type != DT_DIR || entry->d_name[0] == '.') continue;
+        if (snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name) >= (int)sizeof(path)) continue;
+        stop = walk_cgroup_procs(path, depth + 1, visit, ctx);
+    }
+    closedir(children);
+    return stop;
+}
+
+struct same_uid_filter {
+    cf_pid_visitor visit;
+    void *ctx;
+    uid_t uid;
+};
+
+static bool visit_same_uid(const char *pid, void *ctx) {
+    struct same_uid_filter *filter = ctx;
+    char path[64];
+    struct stat st;
+
+    if (snprintf(path, sizeof(path), "/proc/%s", pid) >= (int)sizeof(path)) return false;
+    if (stat(path, &st) != 0 || st.st_uid != filter->uid) return false;
+    return filter->visit(pid, filter->ctx);
+}
+#endif
+
+bool cf_for_each_session_pid(cf_pid_visitor visit, void *ctx) {
+#ifdef _WIN32
+    (void)visit;
+    (void)ctx;
+    return false;
+#else
+    if (!visit) return false;
+
+    const char *mount = NULL;
+    char cgroup_path[512];
+    char slice_path[512];
+    if (read_cgroup_v2_location(&mount, cgroup_path, sizeof(cgroup_path)) &&
+        cf_cgroup_user_slice_prefix(cgroup_path, slice_path, sizeof(slice_path))) {
+        char slice_dir[PATH_MAX];
+        if (snprintf(slice_dir, sizeof(slice_dir), "%s%s", mount, slice_path) < (int)sizeof(slice_dir) &&
+            access(slice_dir, F_OK) == 0) {
+            walk_cgroup_procs(slice_dir, 0, visit, ctx);
+            return true;
+        }
+    }
+
+    // No user slice (no systemd, containers): same-uid processes are the
+    // next best guess. A stat() is far cheaper than reading comm/cmdline,
+    // but for root it filters nothing, so leave that to the full scan.
+    uid_t uid = getuid();
+    if (uid == 0) return false;
+
+    struct same_uid_filter filter = {visit, ctx, uid};
+    cf_for_each_pid(visit_same_uid, &filter);
+    return true;
 #endif
 }
 
+struct process_label_search {
+    const struct process_match *candidates;
+    size_t num_candidates;
+    const char *label;
+};
+
+static bool visit_process_label(const char *pid, void *ctx) {
+#ifdef _WIN32
+    (void)pid;
+    (void)ctx;
+    return false;
+#else
+    struct process_label_search *search = ctx;
+    char proc_dir[64];
+
+    snprintf(proc_dir, sizeof(proc_dir), "/proc/%s", pid);
+    search->label = cf_match_process_label_at(AT_FDCWD, proc_dir, search->candidates, search->num_candidates);
+    return search->label != NULL;
+#endif
+}
+
+const char *cf_detect_process_label(const struct process_match *candidates, size_t num_candidates) {
+    struct process_label_search search = {candidates, num_candidates, NULL};
+
+    // The caller's own session first; widen to every pid only on a miss.
+    if (cf_for_each_session_pid(visit_process_label, &search) && search.label) return search.label;
+
+    return cf_scan_process_label("/proc", candidates, num_candidates, 0);
+}
+
+const char *cf_process_label_for_pid(long pid, const struct process_match *candidates, size_t num_candidates) {
+    if (pid <= 0 || !candidates) return NULL;
+
+    char pid_str[32];
+    snprintf(pid_str, sizeof(pid_str), "%ld", pid);
+
+    struct process_label_search search = {candidates, num_candidates, NULL};
+    visit_process_label(pid_str, &search);
+    return search.label;
+}
+
 const char *cf_basename_or_self(const char *path) {
     if (!path || !path[0]) return NULL;
     const char *base = strrchr(path, '/');
@@ -143,31 +283,151 @@ const char *cf_basename_or_self(const char *path) {
 }
 
 bool cf_read_first_line(const char *path, char *buffer, size_t size) {
-    FILE *file = fopen(path, "r");
-    if (!file) return false;
+    if (cf_read_file(path, buffer, size) <= 0) return false;
+    cf_trim_newline(buffer);
+    return true;
+}
 
-    if (!fgets(buffer, size, file)) {
-        fclose(file);
-        return false;
-    }
-    fclose(file);
+#ifndef _WIN32
+bool cf_read_first_line_at(int dirfd, const char *path, char *buffer, size_t size) {
+    if (cf_read_file_at(dirfd, path, buffer, size) <= 0) return false;
     cf_trim_newline(buffer);
     return true;
 }
+#endif
 
 bool cf_read_ulong_file(const char *path, unsigned long *value) {
     char line[64];
-    if (!cf_read_first_line(path, line, sizeof(line))) return false;
+    return cf_read_first_line(path, line, sizeof(line)) && cf_parse_ulong(line, value);
+}
+
+bool cf_parse_ulong(const char *text, unsigned long *value) {
+    if (!text || !value) return false;
 
     char *endptr = NULL;
     errno = 0;
-    unsigned long parsed = strtoul(line, &endptr, 10);
-    if (errno != 0 || endptr == line) return false;
+    unsigned long parsed = strtoul(text, &endptr, 10);
+    if (errno != 0 || endptr == text) return false;
 
     *value = parsed;
     return true;
 }
 
+ssize_t cf_read_file(const char *path, char *buffer, size_t size) {
+    if (!path || !buffer || size == 0) return -1;
+
+#ifdef _WIN32
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return -1;
+    size_t nread = fread(buffer, 1, size - 1, fp);
+    fclose(fp);
+
+    buffer[nread] = '\0';
+    return (ssize_t)nread;
+#else
+    return cf_read_file_at(AT_FDCWD, path, buffer, size);
+#endif
+}
+
+#ifndef _WIN32
+ssize_t cf_read_file_at(int dirfd, const char *path, char *buffer, size_t size) {
+    if (!path || !buffer || size == 0) return -1;
+
+    // procfs/sysfs hand back small files in a single read, so one read(2)
+    // into the caller's buffer is enough and nothing is allocated.
+    int fd = openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    ssize_t nread;
+    do {
+        nread = read(fd, buffer, size - 1);
+    } while (nread < 0 && errno == EINTR);
+    close(fd);
+
+    if (nread < 0) return -1;
+
+    buffer[nread] = '\0';
+    return nread;
+}
+#endif
+
+bool cf_get_cache_dir(char *dir_out, size_t dir_out_size) {
+    if (!dir_out || dir_out_size == 0) return false;
+
+    int written = -1;
+    const char *xdg_cache = getenv("XDG_CACHE_HOME");
+#ifdef _WIN32
+    const char *local_appdata = getenv("LOCALAPPDATA");
+    if (xdg_cache && xdg_cache[0]) {
+        written = snprintf(dir_out, dir_out_size, "%s\\cupidfetch", xdg_cache);
+    } else if (local_appdata && local_appdata[0]) {
+        written = snprintf(dir_out, dir_out_size, "%s\\cupidfetch", local_appdata);
+    }
+#else
+    const char *home = getenv("HOME");
+    if (xdg_cache && xdg_cache[0]) {
+        written = snprintf(dir_out, dir_out_size, "%s/cupidfetch", xdg_cache);
+    } else if (home && home[0]) {
+        written = snprintf(dir_out, dir_out_size, "%s/.cache/cupidfetch", home);
+    }
+#endif
+
+    if (written < 0 || (size_t)written >= dir_out_size) {
+        dir_out[0] = '\0';
+        return false;
+    }
+    return true;
+}
+
+bool cf_make_dirs(const char *path) {
+    if (!path || !path[0]) return false;
+
+    char tmp[PATH_MAX];
+    size_t len = strlen(path);
+    if (len >= sizeof(tmp)) return false;
+    memcpy(tmp, path, len + 1);
+
+    for (size_t i = 1; i <= len; i++) {
+        if (tmp[i] != '/' && tmp[i] != '\\' && tmp[i] != '\0') continue;
+
+        char saved = tmp[i];
+        tmp[i] = '\0';
+#ifdef _WIN32
+        int rc = _mkdir(tmp);
+#else
+        int rc = mkdir(tmp, 0755);
+#endif
+        if (rc != 0 && errno != EEXIST) return false;
+        tmp[i] = saved;
+    }
+
+    return true;
+}
+
+bool cf_write_file_atomic(const char *path, const char *data, size_t len) {
+    if (!path || !data) return false;
+
+    // Write a sibling temp file and rename it over the target so readers
+    // only ever see the old or the new contents.
+    char tmp_path[PATH_MAX];
+    int written = snprintf(tmp_path, sizeof(tmp_path), "%s.%ld.tmp", path, (long)getpid());
+    if (written < 0 || (size_t)written >= sizeof(tmp_path)) return false;
+
+    FILE *fp = fopen(tmp_path, "wb");
+    if (!fp) return false;
+
+    bool ok = fwrite(data, 1, len, fp) == len;
+    ok = (fclose(fp) == 0) && ok;
+#ifdef _WIN32
+    if (ok) remove(path);
+#endif
+    if (!ok || rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
 bool cf_starts_with(const char *str, const char *prefix) {
     if (!str || !prefix) return false;
     size_t prefix_len = strlen(prefix);
@@ -189,12 +449,100 @@ char *cf_trim_spaces(char *str) {
     return str;
 }
 
+struct cf_codepoint_range {
+    unsigned long first;
+    unsigned long last;
+};
+
+static bool in_ranges(unsigned long cp, const struct cf_codepoint_range *ranges, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (cp < ranges[i].first) return false;
+        if (cp <= ranges[i].last) return true;
+    }
+    return false;
+}
+
+// Combining marks, joiners and variation selectors, sorted.
+static const struct cf_codepoint_range zero_width[] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF}, {0x05C1, 0x05C2},
+    {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A}, {0x064B, 0x065F}, {0x0670, 0x0670},
+    {0x06D6, 0x06DC}, {0x06DF, 0x06E4}, {0x06E7, 0x06E8}, {0x06EA, 0x06ED}, {0x0900, 0x0902},
+    {0x093A, 0x093A}, {0x093C, 0x093C}, {0x0941, 0x0948}, {0x094D, 0x094D}, {0x0E31, 0x0E31},
+    {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x1AB0, 0x1AFF}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F},
+    {0x202A, 0x202E}, {0x2060, 0x2064}, {0x20D0, 0x20FF}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F},
+    {0xFEFF, 0xFEFF}, {0xE0001, 0xE007F}, {0xE0100, 0xE01EF},
+};
+
+// East Asian Wide and Fullwidth characters and emoji presentation, sorted.
+static const struct cf_codepoint_range double_width[] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0},
+    {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F},
+    {0x2693, 0x2693}, {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5},
+    {0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+    {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728},
+    {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755}, {0x2757, 0x2757}, {0x2795, 0x2797},
+    {0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55},
+    {0x2E80, 0x303E}, {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF},
+    {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19}, {0xFE30, 0xFE6F},
+    {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4}, {0x17000, 0x18CFF}, {0x1B000, 0x1B2FF},
+    {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F251},
+    {0x1F300, 0x1F64F}, {0x1F680, 0x1F6FF}, {0x1F7E0, 0x1F7EB}, {0x1F900, 0x1F9FF}, {0x1FA70, 0x1FAFF},
+    {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+};
+
+// A small wcwidth() of our own: the real one answers for the process
+// locale, which a library has no business setting.
+int cf_utf8_char_width(const char *s, size_t max_len, size_t *consumed) {
+    if (!s || max_len == 0 || *s == '\0') {
+        if (consumed) *consumed = max_len == 0 ? 0 : 1;
+        return 0;
+    }
+
+    const unsigned char *bytes = (const unsigned char *)s;
+    unsigned long cp = bytes[0];
+    size_t len = 1;
+    unsigned long min_cp = 0;
+    if (cp >= 0xF0 && cp <= 0xF4) {
+        len = 4;
+        cp &= 0x07;
+        min_cp = 0x10000;
+    } else if (cp >= 0xE0) {
+        len = cp <= 0xEF ? 3 : 0;
+        cp &= 0x0F;
+        min_cp = 0x800;
+    } else if (cp >= 0xC2) {
+        len = 2;
+        cp &= 0x1F;
+        min_cp = 0x80;
+    } else if (cp >= 0x80) {
+        len = 0;
+    }
+
+    bool valid = len > 0 && len <= max_len;
+    for (size_t i = 1; valid && i < len; i++) {
+        valid = (bytes[i] & 0xC0) == 0x80;
+        cp = (cp << 6) | (bytes[i] & 0x3F);
+    }
+    if (valid) valid = cp >= min_cp && cp <= 0x10FFFF && (cp < 0xD800 || cp > 0xDFFF);
+    if (!valid) {
+        if (consumed) *consumed = 1;
+        return 1;
+    }
+
+    if (consumed) *consumed = len;
+    if (cp < 0x20 || (cp >= 0x7F && cp < 0xA0)) return 0;
+    if (in_ranges(cp, zero_width, sizeof(zero_width) / sizeof(zero_width[0]))) return 0;
+    if (in_ranges(cp, double_width, sizeof(double_width) / sizeof(double_width[0]))) return 2;
+    return 1;
+}
+
 bool cf_executable_in_path(const char *name) {
     if (!name || !name[0]) return false;
 
     const char *path_env = getenv("PATH");
     if (!path_env || !path_env[0]) return false;
 
+    cf_mutex_lock(&g_exec_cache_lock);
     if (!g_exec_cache_path_set || strcmp(g_exec_cache_path, path_env) != 0) {
         cf_exec_cache_reset();
         strncpy(g_exec_cache_path, path_env, sizeof(g_exec_cache_path) - 1);
@@ -204,18 +552,31 @@ bool cf_executable_in_path(const char *name) {
 
     for (size_t i = 0; i < g_exec_cache_count; i++) {
         if (strcmp(g_exec_cache[i].name, name) == 0) {
-            return g_exec_cache[i].exists;
+            bool cached = g_exec_cache[i].exists;
+            cf_mutex_unlock(&g_exec_cache_lock);
+            return cached;
         }
     }
+    cf_mutex_unlock(&g_exec_cache_lock);
 
-    bool exists = cf_scan_executable_in_path(path_env, name);
+    // The persisted index answers from memory; probing each PATH entry is
+    // the fallback (and the only way on Windows).
+    bool exists = false;
+    if (!cf_path_index_lookup(path_env, name, &exists)) {
+        exists = cf_scan_executable_in_path(path_env, name);
+    }
 
-    if (strlen(name) < sizeof(g_exec_cache[0].name) && g_exec_cache_count < CF_EXEC_CACHE_CAP) {
+    // Another thread may have added the same name meanwhile; a duplicate
+    // entry is harmless.
+    cf_mutex_lock(&g_exec_cache_lock);
+    if (strcmp(g_exec_cache_path, path_env) == 0 && strlen(name) < sizeof(g_exec_cache[0].name) &&
+        g_exec_cache_count < CF_EXEC_CACHE_CAP) {
         strncpy(g_exec_cache[g_exec_cache_count].name, name, sizeof(g_exec_cache[g_exec_cache_count].name) - 1);
         g_exec_cache[g_exec_cache_count].name[sizeof(g_exec_cache[g_exec_cache_count].name) - 1] = '\0';
         g_exec_cache[g_exec_cache_count].exists = exists;
         g_exec_cache_count++;
     }
+    cf_mutex_unlock(&g_exec_cache_lock);
 
     return exists;
 }
@@ -223,12 +584,9 @@ bool cf_executable_in_path(const char *name) {
 bool cf_run_command_first_line(const char *command, char *out, size_t out_size) {
     if (!command || !command[0] || !out || out_size == 0) return false;
 
-    FILE *fp = popen(command, "r");
-    if (!fp) return false;
-
-    bool ok = fgets(out, out_size, fp) != NULL;
-    pclose(fp);
-    if (!ok) return false;
+    struct cf_command run = {.command = command, .first_line = true, .output = out, .output_size = out_size};
+    cf_run_command(&run);
+    if (run.timed_out || run.output_len == 0) return false;
 
     cf_trim_newline(out);
     char *trimmed = cf_trim_spaces(out);
@@ -239,15 +597,8 @@ bool cf_run_command_first_line(const char *command, char *out, size_t out_size)
 }
 
 static bool read_cpu_times(unsigned long long *idle_all, unsigned long long *total_all) {
-    FILE *fp = fopen("/proc/stat", "r");
-    if (!fp) return false;
-
     char line[256];
-    if (!fgets(line, sizeof(line), fp)) {
-        fclose(fp);
-        return false;
-    }
-    fclose(fp);
+    if (!cf_read_first_line("/proc/stat", line, sizeof(line))) return false;
 
     if (!cf_starts_with(line, "cpu ")) return false;
 
@@ -267,17 +618,17 @@ static bool read_cpu_times(unsigned long long *idle_all, unsigned long long *tot
     return true;
 }
 
-bool cf_detect_cpu_usage_percent(double *usage_out) {
+// `prev` carries the previous sample between calls, so usage is measured
+// over the interval since then; with no valid sample it is the average
+// since boot.
+bool cf_detect_cpu_usage_percent(struct cf_cpu_sample *prev, double *usage_out) {
 #ifdef _WIN32
+    (void)prev;
     (void)usage_out;
     return false;
 #else
     if (!usage_out) return false;
 
-    static bool have_prev = false;
-    static unsigned long long prev_idle = 0;
-    static unsigned long long prev_total = 0;
-
     unsigned long long idle_now = 0;
     unsigned long long total_now = 0;
     if (!read_cpu_times(&idle_now, &total_now)) return false;
@@ -285,9 +636,9 @@ bool cf_detect_cpu_usage_percent(double *usage_out) {
 
     double usage = 0.0;
 
-    if (have_prev && total_now > prev_total) {
-        unsigned long long total_delta = total_now - prev_total;
-        unsigned long long idle_delta = (idle_now >= prev_idle) ? (idle_now - prev_idle) : 0;
+    if (prev && prev->valid && total_now > prev->total) {
+        unsigned long long total_delta = total_now - prev->total;
+        unsigned long long idle_delta = (idle_now >= prev->idle) ? (idle_now - prev->idle) : 0;
 
         if (total_delta == 0) return false;
         usage = (double)(total_delta - idle_delta) * 100.0 / (double)total_delta;
@@ -295,9 +646,11 @@ bool cf_detect_cpu_usage_percent(double *usage_out) {
         usage = (double)(total_now - idle_now) * 100.0 / (double)total_now;
     }
 
-    prev_idle = idle_now;
-    prev_total = total_now;
-    have_prev = true;
+    if (prev) {
+        prev->idle = idle_now;
+        prev->total = total_now;
+        prev->valid = true;
+    }
 
     if (usage < 0.0) usage = 0.0;
     if (usage > 100.0) usage = 100.0;
@@ -419,30 +772,33 @@ bool cf_detect_gpu_from_lspci(char *gpu_out, size_t gpu_out_size) {
     (void)gpu_out_size;
     return false;
 #else
-    FILE *fp = popen("lspci 2>/dev/null", "r");
-    if (!fp) return false;
+    // Grown to the whole listing: on servers the GPU can come after many KB
+    // of bridges, NICs and storage controllers.
+    struct cf_command run = {.command = "lspci", .grow_output = true};
+    cf_run_command(&run);
 
-    char line[512];
-    while (fgets(line, sizeof(line), fp)) {
+    bool found = false;
+    for (char *line = run.output_len > 0 ? run.output : NULL; line && *line; ) {
+        char *next = strchr(line, '\n');
+        if (next) *next++ = '\0';
         if (!cf_contains_icase(line, "vga compatible controller") &&
             !cf_contains_icase(line, "3d controller") &&
             !cf_contains_icase(line, "display controller") &&
             !cf_contains_icase(line, "render driver")) {
+            line = next;
             continue;
         }
 
-        cf_trim_newline(line);
         char *desc = strstr(line, ": ");
         desc = desc ? (desc + 2) : line;
 
         strncpy(gpu_out, desc, gpu_out_size);
         gpu_out[gpu_out_size - 1] = '\0';
-        pclose(fp);
-        return true;
+        found = true;
+        break;
     }
-
-    pclose(fp);
-    return false;
+    free(run.output);
+    return found;
 #endif
 }
 
@@ -458,24 +814,9 @@ bool cf_read_pci_slot_from_uevent(const char *drm_name, char *slot_out, size_t s
         return false;
     }
 
-    FILE *fp = fopen(path, "r");
-    if (!fp) return false;
-
-    char line[256];
-    bool found = false;
-    while (fgets(line, sizeof(line), fp)) {
-        if (strncmp(line, "PCI_SLOT_NAME=", 14) == 0) {
-            char *value = line + 14;
-            cf_trim_newline(value);
-            strncpy(slot_out, value, slot_out_size);
-            slot_out[slot_out_size - 1] = '\0';
-            found = slot_out[0] != '\0';
-            break;
-        }
-    }
-
-    fclose(fp);
-    return found;
+    char text[4096];
+    if (cf_read_file(path, text, sizeof(text)) <= 0) return false;
+    return cf_find_key_value(text, "PCI_SLOT_NAME", slot_out, slot_out_size);
 #endif
 }
 
@@ -487,17 +828,13 @@ bool cf_detect_gpu_from_pci_slot(const char *pci_slot, char *gpu_out, size_t gpu
     return false;
 #else
     char cmd[128];
-    snprintf(cmd, sizeof(cmd), "lspci -s %s 2>/dev/null", pci_slot);
-
-    FILE *fp = popen(cmd, "r");
-    if (!fp) return false;
+    snprintf(cmd, sizeof(cmd), "lspci -s %s", pci_slot);
+    if (cf_command_needs_shell(cmd)) return false;
 
     char line[512];
-    if (!fgets(line, sizeof(line), fp)) {
-        pclose(fp);
-        return false;
-    }
-    pclose(fp);
+    struct cf_command run = {.command = cmd, .first_line = true, .output = line, .output_size = sizeof(line)};
+    cf_run_command(&run);
+    if (run.timed_out || run.output_len == 0) return false;
 
     cf_trim_newline(line);
     char *desc = strstr(line, ": ");
@@ -647,24 +984,26 @@ bool cf_detect_primary_ip(char *iface_out, size_t iface_out_size, char *ip_out,
 
 bool cf_get_public_ip(char *ip_out, size_t ip_out_size) {
 #ifdef _WIN32
-    FILE *fp = popen(
-        "powershell -NoProfile -Command \"try { (Invoke-RestMethod -Uri 'https://api.ipify.org' -TimeoutSec 2) } catch { '' }\" 2>nul",
-        "r"
-    );
+    const char *command =
+        "powershell -NoProfile -Command \"try { (Invoke-RestMethod -Uri 'https://api.ipify.org' -TimeoutSec 2) } catch { '' }\" 2>nul";
 #else
-    FILE *fp = popen(
-        "sh -c \"if command -v curl >/dev/null 2>&1; then curl -fsS --max-time 2 https://api.ipify.org; "
-        "elif command -v wget >/dev/null 2>&1; then wget -qO- --timeout=2 https://api.ipify.org; fi\" 2>/dev/null",
-        "r"
-    );
+    // Picked here rather than by a shell's `command -v`, so the fetch is
+    // spawned directly.
+    const char *command = NULL;
+    if (cf_executable_in_path("curl")) {
+        command = "curl -fsS --max-time 2 https://api.ipify.org";
+    } else if (cf_executable_in_path("wget")) {
+        command = "wget -qO- --timeout=2 https://api.ipify.org";
+    }
+    if (!command) return false;
 #endif
-    if (!fp) return false;
 
     char buffer[128] = "";
-    bool ok = fgets(buffer, sizeof(buffer), fp) != NULL;
-    pclose(fp);
-
-    if (!ok) return false;
+    struct cf_command run = {
+        .command = command, .timeout_ms = 3000, .first_line = true, .output = buffer, .output_size = sizeof(buffer),
+    };
+    cf_run_command(&run);
+    if (run.timed_out || run.output_len == 0) return false;
 
     cf_trim_newline(buffer);
     if (buffer[0] == '\0') return false;
@@ -809,7 +1148,603 @@ bool cf_parse_os_release_id_line(const char *line, char *id_out, size_t id_out_s
     return true;
 }
 
+// Shell-style value: "double" (with \\ escapes), 'single' or bare.
+static void unquote_os_release_value(const char *value, size_t len, char *out, size_t out_size) {
+    size_t n = 0;
+    char quote = '\0';
+    if (len >= 2 && (value[0] == '"' || value[0] == '\'') && value[len - 1] == value[0]) {
+        quote = value[0];
+        value++;
+        len -= 2;
+    }
+
+    for (size_t i = 0; i < len && n + 1 < out_size; i++) {
+        char c = value[i];
+        if (quote == '"' && c == '\\' && i + 1 < len && strchr("\"\\$`", value[i + 1])) c = value[++i];
+        out[n++] = c;
+    }
+    out[n] = '\0';
+}
+
+bool cf_parse_os_release(const char *text, struct cf_os_release *out) {
+    if (!text || !out) return false;
+    memset(out, 0, sizeof(*out));
+
+    static const struct {
+        const char *key;
+        size_t offset;
+        size_t size;
+        bool lowercase;
+    } fields[] = {
+        {"ID", offsetof(struct cf_os_release, id), sizeof(((struct cf_os_release *)0)->id), true},
+        {"ID_LIKE", offsetof(struct cf_os_release, id_like), sizeof(((struct cf_os_release *)0)->id_like), true},
+        {"VERSION_ID", offsetof(struct cf_os_release, version_id), sizeof(((struct cf_os_release *)0)->version_id), false},
+        {"PRETTY_NAME", offsetof(struct cf_os_release, pretty_name), sizeof(((struct cf_os_release *)0)->pretty_name), false},
+    };
+
+    for (const char *line = text; *line; ) {
+        const char *end = strchr(line, '\n');
+        size_t line_len = end ? (size_t)(end - line) : strlen(line);
+        if (line_len > 0 && line[line_len - 1] == '\r') line_len--;
+
+        const char *eq = memchr(line, '=', line_len);
+        for (size_t i = 0; eq && i < sizeof(fields) / sizeof(fields[0]); i++) {
+            size_t key_len = strlen(fields[i].key);
+            if ((size_t)(eq - line) != key_len || strncmp(line, fields[i].key, key_len) != 0) continue;
+
+            char *dest = (char *)out + fields[i].offset;
+            const char *value = eq + 1;
+            size_t value_len = line_len - key_len - 1;
+            while (value_len > 0 && (value[value_len - 1] == ' ' || value[value_len - 1] == '\t')) value_len--;
+            unquote_os_release_value(value, value_len, dest, fields[i].size);
+            if (fields[i].lowercase) {
+                for (char *c = dest; *c; c++) *c = (char)tolower((unsigned char)*c);
+            }
+            break;
+        }
+        if (!end) break;
+        line = end + 1;
+    }
+
+    // os-release(5): a missing ID means "linux".
+    if (!out->id[0]) snprintf(out->id, sizeof(out->id), "linux");
+    return true;
+}
+
+// True when `family` is the ID or one of the ID_LIKE words.
+bool cf_os_release_is_like(const struct cf_os_release *os, const char *family) {
+    if (!os || !family || !family[0]) return false;
+    if (strcmp(os->id, family) == 0) return true;
+
+    size_t family_len = strlen(family);
+    for (const char *word = os->id_like; *word; ) {
+        while (*word == ' ') word++;
+        size_t word_len = strcspn(word, " ");
+        if (word_len == family_len && strncmp(word, family, family_len) == 0) return true;
+        word += word_len;
+    }
+    return false;
+}
+
 unsigned long cf_convert_bytes_to_unit(unsigned long long bytes, unsigned long unit_size) {
     if (unit_size == 0) return 0;
     return (unsigned long)(bytes / unit_size);
 }
+
+bool cf_parse_psi_line(const char *text, const char *kind, double *avg10_out, double *avg60_out) {
+    if (!text || !kind || !kind[0] || !avg10_out || !avg60_out) return false;
+
+    size_t kind_len = strlen(kind);
+    const char *line = text;
+    while (line && *line) {
+        if (strncmp(line, kind, kind_len) == 0 && line[kind_len] == ' ') {
+            double avg10 = 0.0;
+            double avg60 = 0.0;
+            if (sscanf(line + kind_len, " avg10=%lf avg60=%lf", &avg10, &avg60) != 2) return false;
+
+            *avg10_out = avg10;
+            *avg60_out = avg60;
+            return true;
+        }
+
+        line = strchr(line, '\n');
+        if (line) line++;
+    }
+
+    return false;
+}
+
+bool cf_parse_cgroup_v2_path(const char *text, char *path_out, size_t path_out_size) {
+    if (!text || !path_out || path_out_size == 0) return false;
+
+    path_out[0] = '\0';
+
+    // /proc/self/cgroup lines are "hierarchy-ID:controllers:path"; the
+    // unified (v2) hierarchy is always "0::<path>".
+    const char *line = text;
+    while (line && *line) {
+        if (strncmp(line, "0::", 3) == 0) {
+            const char *value = line + 3;
+            size_t len = strcspn(value, "\r\n");
+            if (len == 0 || len >= path_out_size) return false;
+
+            memcpy(path_out, value, len);
+            path_out[len] = '\0';
+            return path_out[0] == '/';
+        }
+
+        line = strchr(line, '\n');
+        if (line) line++;
+    }
+
+    return false;
+}
+
+#ifndef _WIN32
+static bool read_cgroup_v2_location(const char **mount_out, char *path_out, size_t path_out_size) {
+    char text[1024];
+    if (cf_read_file("/proc/self/cgroup", text, sizeof(text)) <= 0) return false;
+    if (!cf_parse_cgroup_v2_path(text, path_out, path_out_size)) return false;
+
+    // Pure v2 hosts mount the unified hierarchy at /sys/fs/cgroup, hybrid
+    // setups keep it under /sys/fs/cgroup/unified.
+    *mount_out = "/sys/fs/cgroup";
+    if (access("/sys/fs/cgroup/cgroup.controllers", F_OK) != 0) {
+        if (access("/sys/fs/cgroup/unified/cgroup.controllers", F_OK) != 0) return false;
+        *mount_out = "/sys/fs/cgroup/unified";
+    }
+    return true;
+}
+#endif
+
+bool cf_resolve_cgroup_v2_dir(char *dir_out, size_t dir_out_size, bool *is_root_out) {
+#ifdef _WIN32
+    (void)dir_out;
+    (void)dir_out_size;
+    (void)is_root_out;
+    return false;
+#else
+    if (!dir_out || dir_out_size == 0) return false;
+
+    const char *mount = NULL;
+    char path[512];
+    if (!read_cgroup_v2_location(&mount, path, sizeof(path))) return false;
+
+    bool is_root = strcmp(path, "/") == 0;
+    int written = snprintf(dir_out, dir_out_size, "%s%s", mount, is_root ? "" : path);
+    if (written < 0 || (size_t)written >= dir_out_size) return false;
+
+    if (is_root_out) *is_root_out = is_root;
+    return true;
+#endif
+}
+
+bool cf_parse_cgroup_limit_value(const char *text, unsigned long long *value_out) {
+    if (!text || !value_out) return false;
+
+    while (*text == ' ' || *text == '\t') text++;
+    if (strncmp(text, "max", 3) == 0) return false;
+
+    char *endptr = NULL;
+    errno = 0;
+    unsigned long long parsed = strtoull(text, &endptr, 10);
+    if (errno != 0 || endptr == text) return false;
+
+    *value_out = parsed;
+    return true;
+}
+
+bool cf_parse_cgroup_cpu_max(const char *text, unsigned long long *quota_out, unsigned long long *period_out) {
+    if (!text || !quota_out || !period_out) return false;
+
+    // cpu.max is "<quota> <period>", with "max" as the quota when unlimited.
+    unsigned long long quota = 0;
+    if (!cf_parse_cgroup_limit_value(text, &quota)) return false;
+
+    const char *space = strchr(text, ' ');
+    if (!space) return false;
+
+    unsigned long long period = 0;
+    if (!cf_parse_cgroup_limit_value(space + 1, &period) || period == 0) return false;
+
+    *quota_out = quota;
+    *period_out = period;
+    return true;
+}
+
+#ifndef _WIN32
+static bool read_cgroup_value(const char *dir, const char *file, char *text, size_t text_size) {
+    char path[640];
+    if (snprintf(path, sizeof(path), "%s/%s", dir, file) >= (int)sizeof(path)) return false;
+    return cf_read_file(path, text, text_size) > 0;
+}
+#endif
+
+bool cf_read_cgroup_limits(struct cf_cgroup_limits *limits_out, unsigned int fields) {
+#ifdef _WIN32
+    (void)limits_out;
+    (void)fields;
+    return false;
+#else
+    if (!limits_out) return false;
+    memset(limits_out, 0, sizeof(*limits_out));
+
+    char dir[512];
+    bool is_root = true;
+    if (!cf_resolve_cgroup_v2_dir(dir, sizeof(dir), &is_root)) return false;
+
+    const char *mount = cf_starts_with(dir, "/sys/fs/cgroup/unified") ? "/sys/fs/cgroup/unified" : "/sys/fs/cgroup";
+    size_t mount_len = strlen(mount);
+    snprintf(limits_out->path, sizeof(limits_out->path), "%s", is_root ? "/" : dir + mount_len);
+
+    char text[128];
+    unsigned long long value = 0;
+
+    if ((fields & CF_CGROUP_MEMORY) &&
+        read_cgroup_value(dir, "memory.current", text, sizeof(text)) &&
+        cf_parse_cgroup_limit_value(text, &value)) {
+        limits_out->memory_current = value;
+        limits_out->have_memory_current = true;
+    }
+    if ((fields & CF_CGROUP_PIDS) &&
+        read_cgroup_value(dir, "pids.current", text, sizeof(text)) &&
+        cf_parse_cgroup_limit_value(text, &value)) {
+        limits_out->pids_current = value;
+        limits_out->have_pids_current = true;
+    }
+
+    // Limits are inherited: the effective one is the tightest along the path
+    // up to the hierarchy root, so walk the ancestors too.
+    for (;;) {
+        if ((fields & CF_CGROUP_MEMORY) &&
+            read_cgroup_value(dir, "memory.max", text, sizeof(text)) &&
+            cf_parse_cgroup_limit_value(text, &value) &&
+            (!limits_out->have_memory_max || value < limits_out->memory_max)) {
+            limits_out->memory_max = value;
+            limits_out->have_memory_max = true;
+        }
+
+        if ((fields & CF_CGROUP_PIDS) &&
+            read_cgroup_value(dir, "pids.max", text, sizeof(text)) &&
+            cf_parse_cgroup_limit_value(text, &value) &&
+            (!limits_out->have_pids_max || value < limits_out->pids_max)) {
+            limits_out->pids_max = value;
+            limits_out->have_pids_max = true;
+        }
+
+        unsigned long long quota = 0;
+        unsigned long long period = 0;
+        if ((fields & CF_CGROUP_CPU) &&
+            read_cgroup_value(dir, "cpu.max", text, sizeof(text)) &&
+            cf_parse_cgroup_cpu_max(text, &quota, &period)) {
+            bool tighter = !limits_out->have_cpu_quota ||
+                (double)quota / (double)period <
+                (double)limits_out->cpu_quota_us / (double)limits_out->cpu_period_us;
+            if (tighter) {
+                limits_out->cpu_quota_us = quota;
+                limits_out->cpu_period_us = period;
+                limits_out->have_cpu_quota = true;
+            }
+        }
+
+        char *slash = strrchr(dir, '/');
+        if (!slash || (size_t)(slash - dir) < mount_len) break;
+        *slash = '\0';
+    }
+
+    return true;
+#endif
+}
+
+struct meminfo_slot {
+    const char *name;
+    size_t len;
+    int field;
+};
+
+#define MEMINFO_HASH_SLOTS 32
+#define MEMINFO_MAX_KEY_LEN 15
+
+/*
+ * Perfect hash over the /proc/meminfo keys we care about. The multipliers
+ * were picked offline so every known key lands in its own slot; any other
+ * key either hits an empty slot or fails the length/memcmp check.
+ */
+static unsigned int meminfo_key_hash(const char *key, size_t len) {
+    return (unsigned int)(len * 5u +
+                          (unsigned char)key[0] * 4u +
+                          (unsigned char)key[len - 1] * 19u +
+                          (unsigned char)key[len / 2]) & (MEMINFO_HASH_SLOTS - 1u);
+}
+
+static const struct meminfo_slot meminfo_slots[MEMINFO_HASH_SLOTS] = {
+    [2] = {"Hugepagesize", 12, CF_MEMINFO_HUGE_PAGE_SIZE},
+    [8] = {"Zswap", 5, CF_MEMINFO_ZSWAP},
+    [9] = {"Shmem", 5, CF_MEMINFO_SHMEM},
+    [10] = {"HugePages_Free", 14, CF_MEMINFO_HUGE_PAGES_FREE},
+    [11] = {"SwapCached", 10, CF_MEMINFO_SWAP_CACHED},
+    [12] = {"Zswapped", 8, CF_MEMINFO_ZSWAPPED},
+    [14] = {"Hugetlb", 7, CF_MEMINFO_HUGETLB},
+    [15] = {"MemTotal", 8, CF_MEMINFO_MEM_TOTAL},
+    [16] = {"SReclaimable", 12, CF_MEMINFO_SRECLAIMABLE},
+    [17] = {"SwapTotal", 9, CF_MEMINFO_SWAP_TOTAL},
+    [20] = {"HugePages_Total", 15, CF_MEMINFO_HUGE_PAGES_TOTAL},
+    [21] = {"AnonHugePages", 13, CF_MEMINFO_ANON_HUGE_PAGES},
+    [22] = {"Dirty", 5, CF_MEMINFO_DIRTY},
+    [23] = {"HugePages_Rsvd", 14, CF_MEMINFO_HUGE_PAGES_RSVD},
+    [24] = {"MemAvailable", 12, CF_MEMINFO_MEM_AVAILABLE},
+    [25] = {"SwapFree", 8, CF_MEMINFO_SWAP_FREE},
+    [26] = {"Buffers", 7, CF_MEMINFO_BUFFERS},
+    [28] = {"MemFree", 7, CF_MEMINFO_MEM_FREE},
+    [30] = {"Cached", 6, CF_MEMINFO_CACHED},
+    [31] = {"Writeback", 9, CF_MEMINFO_WRITEBACK},
+};
+
+static int meminfo_field_lookup(const char *key, size_t len) {
+    if (len == 0 || len > MEMINFO_MAX_KEY_LEN) return -1;
+
+    const struct meminfo_slot *slot = &meminfo_slots[meminfo_key_hash(key, len)];
+    if (!slot->name || slot->len != len || memcmp(slot->name, key, len) != 0) return -1;
+    return slot->field;
+}
+
+bool cf_parse_meminfo(const char *text, struct cf_meminfo *info_out) {
+    if (!text || !info_out) return false;
+    memset(info_out, 0, sizeof(*info_out));
+
+    const char *line = text;
+    while (*line) {
+        const char *line_end = strchr(line, '\n');
+        if (!line_end) line_end = line + strlen(line);
+
+        // Per-node files prefix every line with "Node <n> ".
+        const char *key = line;
+        if (strncmp(key, "Node ", 5) == 0) {
+            key += 5;
+            while (isdigit((unsigned char)*key)) key++;
+            while (*key == ' ') key++;
+        }
+
+        const char *colon = memchr(key, ':', (size_t)(line_end - key));
+        if (colon) {
+            int field = meminfo_field_lookup(key, (size_t)(colon - key));
+            if (field >= 0) {
+                char *endptr = NULL;
+                unsigned long long value = strtoull(colon + 1, &endptr, 10);
+                if (endptr != colon + 1) {
+                    info_out->values[field] = value;
+                    info_out->present |= 1UL << field;
+                }
+            }
+        }
+
+        line = *line_end ? line_end + 1 : line_end;
+    }
+
+    return info_out->present != 0;
+}
+
+bool cf_meminfo_has(const struct cf_meminfo *info, enum cf_meminfo_field field) {
+    if (!info || field < 0 || field >= CF_MEMINFO_FIELD_COUNT) return false;
+    return (info->present & (1UL << field)) != 0;
+}
+
+bool cf_find_key_value(const char *text, const char *key, char *out, size_t out_size) {
+    if (!text || !key || !key[0] || !out || out_size == 0) return false;
+
+    size_t key_len = strlen(key);
+    for (const char *line = text; line && *line; ) {
+        const char *end = strchr(line, '\n');
+        if (strncmp(line, key, key_len) == 0 && line[key_len] == '=') {
+            const char *value = line + key_len + 1;
+            size_t len = end ? (size_t)(end - value) : strlen(value);
+            if (len > 0 && value[len - 1] == '\r') len--;
+            if (len >= out_size) len = out_size - 1;
+            memcpy(out, value, len);
+            out[len] = '\0';
+            return out[0] != '\0';
+        }
+        line = end ? end + 1 : NULL;
+    }
+    return false;
+}
+
+bool cf_parse_proc_stat_line(
+    const char *line,
+    char *comm_out,
+    size_t comm_out_size,
+    long *ppid_out,
+    unsigned long long *cpu_ticks_out
+) {
+    if (!line) return false;
+
+    // comm may contain spaces and parentheses, so anchor on the last ')'.
+    const char *lparen = strchr(line, '(');
+    const char *rparen = strrchr(line, ')');
+    if (!lparen || !rparen || rparen < lparen || rparen[1] != ' ') return false;
+
+    char state = '\0';
+    long ppid = 0;
+    unsigned long long utime = 0;
+    unsigned long long stime = 0;
+    if (sscanf(rparen + 2, "%c %ld %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+               &state, &ppid, &utime, &stime) != 4) {
+        return false;
+    }
+
+    if (comm_out && comm_out_size > 0) {
+        size_t len = (size_t)(rparen - lparen - 1);
+        if (len >= comm_out_size) len = comm_out_size - 1;
+        memcpy(comm_out, lparen + 1, len);
+        comm_out[len] = '\0';
+    }
+    if (ppid_out) *ppid_out = ppid;
+    if (cpu_ticks_out) *cpu_ticks_out = utime + stime;
+    return true;
+}
+
+static void top_heap_swap(struct cf_top_entry *a, struct cf_top_entry *b) {
+    struct cf_top_entry tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static void top_heap_sift_down(struct cf_top_entry *entries, size_t count, size_t index) {
+    for (;;) {
+        size_t smallest = index;
+        size_t left = index * 2 + 1;
+        size_t right = left + 1;
+
+        if (left < count && entries[left].value < entries[smallest].value) smallest = left;
+        if (right < count && entries[right].value < entries[smallest].value) smallest = right;
+        if (smallest == index) return;
+
+        top_heap_swap(&entries[index], &entries[smallest]);
+        index = smallest;
+    }
+}
+
+void cf_top_heap_init(struct cf_top_heap *heap, struct cf_top_entry *storage, size_t capacity) {
+    if (!heap) return;
+    heap->entries = storage;
+    heap->count = 0;
+    heap->capacity = storage ? capacity : 0;
+}
+
+void cf_top_heap_offer(struct cf_top_heap *heap, const struct cf_top_entry *entry) {
+    if (!heap || !entry || heap->capacity == 0) return;
+
+    if (heap->count < heap->capacity) {
+        size_t index = heap->count++;
+        heap->entries[index] = *entry;
+        while (index > 0) {
+            size_t parent = (index - 1) / 2;
+            if (heap->entries[parent].value <= heap->entries[index].value) break;
+            top_heap_swap(&heap->entries[parent], &heap->entries[index]);
+            index = parent;
+        }
+        return;
+    }
+
+    // Full: the root is the smallest kept value, so only larger ones get in.
+    if (entry->value <= heap->entries[0].value) return;
+    heap->entries[0] = *entry;
+    top_heap_sift_down(heap->entries, heap->count, 0);
+}
+
+void cf_top_heap_sort_desc(struct cf_top_heap *heap) {
+    if (!heap) return;
+
+    // Heapsort on a min-heap leaves the array in descending order.
+    for (size_t end = heap->count; end > 1; end--) {
+        top_heap_swap(&heap->entries[0], &heap->entries[end - 1]);
+        top_heap_sift_down(heap->entries, end - 1, 0);
+    }
+}
+
+bool cf_parse_drm_fdinfo(const char *text, struct cf_drm_fdinfo *info_out) {
+    if (!text || !info_out) return false;
+    memset(info_out, 0, sizeof(*info_out));
+
+    for (const char *line = text; line && *line; ) {
+        const char *next = strchr(line, '\n');
+
+        if (strncmp(line, "drm-pdev:", 9) == 0) {
+            sscanf(line + 9, " %31s", info_out->pdev);
+        } else if (strncmp(line, "drm-client-id:", 14) == 0) {
+            info_out->have_client_id = sscanf(line + 14, " %llu", &info_out->client_id) == 1;
+        } else if (strncmp(line, "drm-engine-", 11) == 0 &&
+                   strncmp(line + 11, "capacity-", 9) != 0 &&
+                   info_out->engine_count < CF_DRM_MAX_ENGINES) {
+            // drm-engine-<name>:\t<ns> ns
+            const char *name = line + 11;
+            const char *colon = strchr(name, ':');
+            unsigned long long busy_ns = 0;
+            if (colon && (!next || colon < next) && sscanf(colon + 1, " %llu", &busy_ns) == 1) {
+                struct cf_drm_engine_time *engine = &info_out->engines[info_out->engine_count++];
+                size_t len = (size_t)(colon - name);
+                if (len >= sizeof(engine->name)) len = sizeof(engine->name) - 1;
+                memcpy(engine->name, name, len);
+                engine->name[len] = '\0';
+                engine->busy_ns = busy_ns;
+            }
+        }
+
+        line = next ? next + 1 : NULL;
+    }
+
+    return info_out->have_client_id && info_out->engine_count > 0;
+}
+
+static const struct {
+    const char *key;
+    enum cf_power_supply_field field;
+} power_supply_keys[] = {
+    {"PRESENT", CF_PSU_PRESENT},
+    {"CAPACITY", CF_PSU_CAPACITY},
+    {"ENERGY_NOW", CF_PSU_ENERGY_NOW},
+    {"ENERGY_FULL", CF_PSU_ENERGY_FULL},
+    {"POWER_NOW", CF_PSU_POWER_NOW},
+    {"CHARGE_NOW", CF_PSU_CHARGE_NOW},
+    {"CHARGE_FULL", CF_PSU_CHARGE_FULL},
+    {"CURRENT_NOW", CF_PSU_CURRENT_NOW},
+    {"VOLTAGE_NOW", CF_PSU_VOLTAGE_NOW},
+};
+
+static void copy_uevent_value(char *dest, size_t dest_size, const char *value, size_t len) {
+    if (len >= dest_size) len = dest_size - 1;
+    memcpy(dest, value, len);
+    dest[len] = '\0';
+}
+
+bool cf_parse_power_supply_uevent(const char *text, struct cf_power_supply *supply_out) {
+    if (!text || !supply_out) return false;
+    memset(supply_out, 0, sizeof(*supply_out));
+
+    bool any = false;
+    for (const char *line = text; line && *line; ) {
+        const char *next = strchr(line, '\n');
+        size_t line_len = next ? (size_t)(next - line) : strlen(line);
+
+        const char *eq = memchr(line, '=', line_len);
+        if (strncmp(line, "POWER_SUPPLY_", 13) == 0 && eq) {
+            const char *key = line + 13;
+            size_t key_len = (size_t)(eq - key);
+            const char *value = eq + 1;
+            size_t value_len = line_len - (size_t)(value - line);
+
+            if (key_len == 4 && strncmp(key, "TYPE", 4) == 0) {
+                copy_uevent_value(supply_out->type, sizeof(supply_out->type), value, value_len);
+                any = true;
+            } else if (key_len == 6 && strncmp(key, "STATUS", 6) == 0) {
+                copy_uevent_value(supply_out->status, sizeof(supply_out->status), value, value_len);
+                any = true;
+            } else if (key_len == 5 && strncmp(key, "SCOPE", 5) == 0) {
+                copy_uevent_value(supply_out->scope, sizeof(supply_out->scope), value, value_len);
+            } else {
+                for (size_t i = 0; i < sizeof(power_supply_keys) / sizeof(power_supply_keys[0]); i++) {
+                    if (strlen(power_supply_keys[i].key) != key_len ||
+                        strncmp(key, power_supply_keys[i].key, key_len) != 0) {
+                        continue;
+                    }
+                    char *endptr = NULL;
+                    long long parsed = strtoll(value, &endptr, 10);
+                    if (endptr == value) break;
+                    enum cf_power_supply_field field = power_supply_keys[i].field;
+                    supply_out->values[field] = (unsigned long long)(parsed < 0 ? -parsed : parsed);
+                    supply_out->present |= 1UL << field;
+                    any = true;
+                    break;
+                }
+            }
+        }
+
+        line = next ? next + 1 : NULL;
+    }
+    return any;
+}
+
+bool cf_power_supply_has(const struct cf_power_supply *supply, enum cf_power_supply_field field) {
+    if (!supply || field < 0 || field >= CF_PSU_FIELD_COUNT) return false;
+    return (supply->present & (1UL << field)) != 0;
+}
@@ -3,22 +3,263 @@
 
 #include "../../cupidfetch.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <pthread.h>
+#define CF_AT_FDCWD AT_FDCWD
+#else
+#define CF_AT_FDCWD (-1)
+#endif
+
+// Guards the process-wide caches (exec lookups, PATH index, keyfiles,
+// distro overlay) so modules may run on several threads at once.
+#ifdef _WIN32
+typedef SRWLOCK cf_mutex;
+#define CF_MUTEX_INIT SRWLOCK_INIT
+#define cf_mutex_lock(m) AcquireSRWLockExclusive(m)
+#define cf_mutex_unlock(m) ReleaseSRWLockExclusive(m)
+#else
+typedef pthread_mutex_t cf_mutex;
+#define CF_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+#define cf_mutex_lock(m) pthread_mutex_lock(m)
+#define cf_mutex_unlock(m) pthread_mutex_unlock(m)
+#endif
+
 struct process_match {
     const char *proc_name;
     const char *label;
 };
 
+#define CF_CGROUP_MEMORY 0x1u
+#define CF_CGROUP_CPU 0x2u
+#define CF_CGROUP_PIDS 0x4u
+#define CF_CGROUP_ALL (CF_CGROUP_MEMORY | CF_CGROUP_CPU | CF_CGROUP_PIDS)
+
+struct cf_cgroup_limits {
+    char path[512];
+    bool have_memory_max;
+    unsigned long long memory_max;
+    bool have_memory_current;
+    unsigned long long memory_current;
+    bool have_cpu_quota;
+    unsigned long long cpu_quota_us;
+    unsigned long long cpu_period_us;
+    bool have_pids_max;
+    unsigned long long pids_max;
+    bool have_pids_current;
+    unsigned long long pids_current;
+};
+
+enum cf_meminfo_field {
+    CF_MEMINFO_MEM_TOTAL,
+    CF_MEMINFO_MEM_FREE,
+    CF_MEMINFO_MEM_AVAILABLE,
+    CF_MEMINFO_BUFFERS,
+    CF_MEMINFO_CACHED,
+    CF_MEMINFO_SWAP_CACHED,
+    CF_MEMINFO_SHMEM,
+    CF_MEMINFO_SRECLAIMABLE,
+    CF_MEMINFO_SWAP_TOTAL,
+    CF_MEMINFO_SWAP_FREE,
+    CF_MEMINFO_ZSWAP,
+    CF_MEMINFO_ZSWAPPED,
+    CF_MEMINFO_DIRTY,
+    CF_MEMINFO_WRITEBACK,
+    CF_MEMINFO_ANON_HUGE_PAGES,
+    CF_MEMINFO_HUGE_PAGES_TOTAL,
+    CF_MEMINFO_HUGE_PAGES_FREE,
+    CF_MEMINFO_HUGE_PAGES_RSVD,
+    CF_MEMINFO_HUGE_PAGE_SIZE,
+    CF_MEMINFO_HUGETLB,
+    CF_MEMINFO_FIELD_COUNT
+};
+
+// Values are as reported: kB for sizes, plain counts for HugePages_*.
+struct cf_meminfo {
+    unsigned long long values[CF_MEMINFO_FIELD_COUNT];
+    unsigned long present;
+};
+
+struct cf_top_entry {
+    long pid;
+    unsigned long long value;
+    char comm[32];
+};
+
+// Fixed-capacity min-heap that keeps the N largest entries offered to it.
+struct cf_top_heap {
+    struct cf_top_entry *entries;
+    size_t count;
+    size_t capacity;
+};
+
+// Bump allocator for short-lived, variable-length data (one fetch, one
+// redraw). Nothing is freed on its own: cf_arena_reset() rewinds every
+// block for reuse and cf_arena_free() returns them.
+struct cf_arena_block;
+
+struct cf_arena {
+    struct cf_arena_block *first;
+    struct cf_arena_block *current;
+    size_t block_size;
+};
+
+#define CF_DRM_MAX_ENGINES 8
+
+struct cf_drm_engine_time {
+    char name[16];
+    unsigned long long busy_ns;
+};
+
+// Per-fd DRM client usage (Documentation/gpu/drm-usage-stats.rst).
+struct cf_drm_fdinfo {
+    char pdev[32];
+    bool have_client_id;
+    unsigned long long client_id;
+    struct cf_drm_engine_time engines[CF_DRM_MAX_ENGINES];
+    size_t engine_count;
+};
+
+// One small-file read for cf_read_batch(). `dirfd` is CF_AT_FDCWD or a
+// directory fd that `path` is relative to; `result` is the byte count
+// (the buffer is NUL-terminated) or -1.
+struct cf_read_request {
+    int dirfd;
+    const char *path;
+    char *buffer;
+    size_t size;
+    ssize_t result;
+};
+
+#define CF_COMMAND_TIMEOUT_MS 5000
+
+// One external command for cf_run_commands(). Stdout is stored in `output`
+// (NUL-terminated, may be NULL) up to its size and counted in `lines` in
+// full; stderr is discarded. `exit_status` is -1 when the command could not
+// start, died from a signal or ran past `timeout_ms` (0 for the default).
+// A `first_line` command is stopped as soon as one whole line has arrived.
+// With `grow_output`, `output` is a malloc()ed buffer (NULL to start) that
+// is enlarged until EOF; the caller frees it.
+struct cf_command {
+    const char *command;
+    int timeout_ms;
+    bool first_line;
+    char *output;
+    size_t output_size;
+    size_t output_len;
+    unsigned long lines;
+    int exit_status;
+    bool timed_out;
+    bool grow_output;
+};
+
+enum cf_power_supply_field {
+    CF_PSU_PRESENT,
+    CF_PSU_CAPACITY,
+    CF_PSU_ENERGY_NOW,
+    CF_PSU_ENERGY_FULL,
+    CF_PSU_POWER_NOW,
+    CF_PSU_CHARGE_NOW,
+    CF_PSU_CHARGE_FULL,
+    CF_PSU_CURRENT_NOW,
+    CF_PSU_VOLTAGE_NOW,
+    CF_PSU_FIELD_COUNT
+};
+
+// POWER_SUPPLY_* keys from a power_supply uevent file. Values are as the
+// kernel reports them (uWh, uW, uAh, uA, uV); POWER_NOW and CURRENT_NOW,
+// which some drivers sign by direction, are stored as magnitudes.
+struct cf_power_supply {
+    char type[16];
+    char status[32];
+    char scope[16];
+    unsigned long long values[CF_PSU_FIELD_COUNT];
+    unsigned long present;
+};
+
+// The os-release(5) fields cupidfetch uses, unquoted. `id` and the
+// space-separated `id_like` list are lowercased.
+struct cf_os_release {
+    char id[64];
+    char id_like[128];
+    char version_id[64];
+    char pretty_name[128];
+};
+
+#define CF_SENSOR_PATH_LEN 320
+
+// Temperature input files by role; "" when no sensor was found.
+struct cf_sensor_paths {
+    char cpu[CF_SENSOR_PATH_LEN];
+    char gpu[CF_SENSOR_PATH_LEN];
+};
+
+struct cf_sensor_temps {
+    double cpu;  // degrees Celsius
+    double gpu;
+    bool have_cpu;
+    bool have_gpu;
+};
+
+typedef bool (*cf_pid_visitor)(const char *pid, void *ctx);
+typedef void (*cf_sensor_discover_fn)(struct cf_sensor_paths *paths_out);
+
 void cf_trim_newline(char *str);
 bool cf_contains_icase(const char *haystack, const char *needle);
+void cf_for_each_pid(cf_pid_visitor visit, void *ctx);
+bool cf_for_each_session_pid(cf_pid_visitor visit, void *ctx);
+bool cf_cgroup_user_slice_prefix(const char *cgroup_path, char *out, size_t out_size);
 const char *cf_detect_process_label(const struct process_match *candidates, size_t num_candidates);
+const char *cf_process_label_for_pid(long pid, const struct process_match *candidates, size_t num_candidates);
+const char *cf_match_process_label_at(int proc_fd, const char *pid, const struct process_match *candidates, size_t num_candidates);
+const char *cf_scan_process_label(const char *proc_root, const struct process_match *candidates, size_t num_candidates, unsigned int max_threads);
+bool cf_unix_socket_peer_pid(const char *socket_path, long *pid_out);
+bool cf_display_socket_path(char *out, size_t out_size, bool *is_wayland_out);
+bool cf_display_server_pid(long *pid_out, bool *is_wayland_out);
+const char *cf_detect_display_server_label(const struct process_match *candidates, size_t num_candidates);
 const char *cf_basename_or_self(const char *path);
 bool cf_read_first_line(const char *path, char *buffer, size_t size);
 bool cf_read_ulong_file(const char *path, unsigned long *value);
+bool cf_parse_ulong(const char *text, unsigned long *value);
+ssize_t cf_read_file(const char *path, char *buffer, size_t size);
+#ifndef _WIN32
+bool cf_read_first_line_at(int dirfd, const char *path, char *buffer, size_t size);
+ssize_t cf_read_file_at(int dirfd, const char *path, char *buffer, size_t size);
+#endif
+void cf_arena_init(struct cf_arena *arena, size_t block_size);
+void *cf_arena_alloc(struct cf_arena *arena, size_t size);
+// Resizes the arena's latest allocation in place when it can, else copies.
+void *cf_arena_grow(struct cf_arena *arena, void *ptr, size_t old_size, size_t new_size);
+char *cf_arena_strndup(struct cf_arena *arena, const char *text, size_t len);
+char *cf_arena_strdup(struct cf_arena *arena, const char *text);
+void cf_arena_reset(struct cf_arena *arena);
+void cf_arena_free(struct cf_arena *arena);
+// `ring` keeps an io_uring open from one batch to the next (see
+// cf_ctx_read_ring()); NULL reads every file synchronously.
+struct cf_read_ring *cf_read_ring_new(void);
+void cf_read_ring_free(struct cf_read_ring *ring);
+size_t cf_read_batch(struct cf_read_ring *ring, struct cf_read_request *requests, size_t count);
+#ifndef _WIN32
+// Reads the temperatures from the sensor files cached for `boot_id`, or
+// runs `discover` (and caches its answer) when there is no usable cache.
+void cf_read_sensor_temps(const char *boot_id, cf_sensor_discover_fn discover, struct cf_sensor_temps *temps_out);
+#endif
+bool cf_get_cache_dir(char *dir_out, size_t dir_out_size);
+bool cf_make_dirs(const char *path);
+bool cf_write_file_atomic(const char *path, const char *data, size_t len);
 bool cf_starts_with(const char *str, const char *prefix);
 char *cf_trim_spaces(char *str);
+// Terminal columns of the UTF-8 character at `s`, whatever the locale. An
+// invalid or truncated sequence counts as one byte one column wide.
+int cf_utf8_char_width(const char *s, size_t max_len, size_t *consumed);
 bool cf_executable_in_path(const char *name);
+bool cf_path_index_lookup(const char *path_env, const char *name, bool *exists_out);
+void cf_path_index_reset(void);
+bool cf_command_needs_shell(const char *command);
+bool cf_run_command(struct cf_command *command);
+size_t cf_run_commands(struct cf_command *commands, size_t count);
 bool cf_run_command_first_line(const char *command, char *out, size_t out_size);
-bool cf_detect_cpu_usage_percent(double *usage_out);
+bool cf_detect_cpu_usage_percent(struct cf_cpu_sample *prev, double *usage_out);
 bool cf_build_power_supply_path(char *dest, size_t dest_size, const char *entry_name, const char *suffix);
 void cf_format_duration_compact(unsigned long seconds, char *buffer, size_t size);
 bool cf_is_drm_card_device(const char *name);
@@ -42,6 +283,24 @@ bool cf_parse_distro_def_line(
     size_t pkgcmd_out_size
 );
 bool cf_parse_os_release_id_line(const char *line, char *id_out, size_t id_out_size);
+bool cf_parse_os_release(const char *text, struct cf_os_release *out);
+bool cf_os_release_is_like(const struct cf_os_release *os, const char *family);
 unsigned long cf_convert_bytes_to_unit(unsigned long long bytes, unsigned long unit_size);
+bool cf_parse_psi_line(const char *text, const char *kind, double *avg10_out, double *avg60_out);
+bool cf_parse_cgroup_v2_path(const char *text, char *path_out, size_t path_out_size);
+bool cf_resolve_cgroup_v2_dir(char *dir_out, size_t dir_out_size, bool *is_root_out);
+bool cf_parse_cgroup_limit_value(const char *text, unsigned long long *value_out);
+bool cf_parse_cgroup_cpu_max(const char *text, unsigned long long *quota_out, unsigned long long *period_out);
+bool cf_find_key_value(const char *text, const char *key, char *out, size_t out_size);
+bool cf_parse_proc_stat_line(const char *line, char *comm_out, size_t comm_out_size, long *ppid_out, unsigned long long *cpu_ticks_out);
+void cf_top_heap_init(struct cf_top_heap *heap, struct cf_top_entry *storage, size_t capacity);
+void cf_top_heap_offer(struct cf_top_heap *heap, const struct cf_top_entry *entry);
+void cf_top_heap_sort_desc(struct cf_top_heap *heap);
+bool cf_parse_meminfo(const char *text, struct cf_meminfo *info_out);
+bool cf_meminfo_has(const struct cf_meminfo *info, enum cf_meminfo_field field);
+bool cf_read_cgroup_limits(struct cf_cgroup_limits *limits_out, unsigned int fields);
+bool cf_parse_drm_fdinfo(const char *text, struct cf_drm_fdinfo *info_out);
+bool cf_parse_power_supply_uevent(const char *text, struct cf_power_supply *supply_out);
+bool cf_power_supply_has(const struct cf_power_supply *supply, enum cf_power_supply_field field);
 
 #endif
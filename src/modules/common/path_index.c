@@ -0,0 +1,300 @@
+#include "module_helpers.h"
+
+#ifndef _WIN32
+#include <limits.h>
+#include <stdint.h>
+
+#define PATH_INDEX_MAGIC "cupidfetch-path-index 1\n"
+#define PATH_INDEX_MIN_SLOTS 1024
+
+struct strbuf {
+    char *data;
+    size_t len;
+    size_t cap;
+};
+
+/*
+ * Every executable name found on PATH, as an open-addressing hash set over
+ * one arena of NUL-terminated names. Built once per process and PATH value.
+ */
+struct path_index {
+    char path_env[4096];
+    bool built;
+    char *names;
+    size_t names_len;
+    size_t names_cap;
+    uint32_t *slots;  // 1 + offset into `names`; 0 marks an empty slot
+    size_t slot_count;
+    size_t name_count;
+};
+
+static cf_mutex g_path_index_lock = CF_MUTEX_INIT;
+static struct path_index g_path_index;
+
+static bool strbuf_append(struct strbuf *buf, const char *data, size_t len) {
+    if (buf->len + len + 1 > buf->cap) {
+        size_t cap = buf->cap ? buf->cap : 16384;
+        while (buf->len + len + 1 > cap) cap *= 2;
+        char *grown = realloc(buf->data, cap);
+        if (!grown) return false;
+        buf->data = grown;
+        buf->cap = cap;
+    }
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    buf->data[buf->len] = '\0';
+    return true;
+}
+
+// FNV-1a, as in the keyfile cache.
+static uint32_t hash_name(const char *name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static size_t find_slot(const struct path_index *index, const char *name, size_t len) {
+    size_t mask = index->slot_count - 1;
+    size_t slot = hash_name(name, len) & mask;
+    while (index->slots[slot] != 0) {
+        const char *existing = index->names + index->slots[slot] - 1;
+        if (strncmp(existing, name, len) == 0 && existing[len] == '\0') break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static bool index_grow(struct path_index *index) {
+    size_t slot_count = index->slot_count ? index->slot_count * 2 : PATH_INDEX_MIN_SLOTS;
+    uint32_t *slots = calloc(slot_count, sizeof(*slots));
+    if (!slots) return false;
+
+    uint32_t *old_slots = index->slots;
+    size_t old_count = index->slot_count;
+    index->slots = slots;
+    index->slot_count = slot_count;
+    for (size_t i = 0; i < old_count; i++) {
+        if (old_slots[i] == 0) continue;
+        const char *name = index->names + old_slots[i] - 1;
+        index->slots[find_slot(index, name, strlen(name))] = old_slots[i];
+    }
+    free(old_slots);
+    return true;
+}
+
+static bool index_insert(struct path_index *index, const char *name, size_t len) {
+    if (len == 0) return true;
+    if ((index->name_count + 1) * 2 > index->slot_count && !index_grow(index)) return false;
+
+    size_t slot = find_slot(index, name, len);
+    if (index->slots[slot] != 0) return true;
+
+    if (index->names_len + len + 1 > index->names_cap) {
+        size_t cap = index->names_cap ? index->names_cap * 2 : 32768;
+        while (index->names_len + len + 1 > cap) cap *= 2;
+        if (cap > UINT32_MAX) return false;
+        char *grown = realloc(index->names, cap);
+        if (!grown) return false;
+        index->names = grown;
+        index->names_cap = cap;
+    }
+
+    memcpy(index->names + index->names_len, name, len);
+    index->names[index->names_len + len] = '\0';
+    index->slots[slot] = (uint32_t)index->names_len + 1;
+    index->names_len += len + 1;
+    index->name_count++;
+    return true;
+}
+
+static void index_free(struct path_index *index) {
+    free(index->names);
+    free(index->slots);
+    memset(index, 0, sizeof(*index));
+}
+
+static bool path_index_file(char *out, size_t out_size, char *dir_out, size_t dir_out_size) {
+    if (!cf_get_cache_dir(dir_out, dir_out_size)) return false;
+    return snprintf(out, out_size, "%s/path-index", dir_out) < (int)out_size;
+}
+
+static char *load_cache_text(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) return NULL;
+
+    size_t size = (size_t)st.st_size + 1;
+    char *text = malloc(size);
+    if (!text) return NULL;
+    ssize_t nread = cf_read_file(path, text, size);
+    if (nread <= 0 || (size_t)nread != size - 1 || !cf_starts_with(text, PATH_INDEX_MAGIC)) {
+        free(text);
+        return NULL;
+    }
+    return text;
+}
+
+/*
+ * Sections look like "dir <mtime_sec> <mtime_nsec> <path>" followed by one
+ * tab-prefixed name per line. Returns the section header when the directory
+ * is cached with the same mtime, so its listing is still current.
+ */
+static const char *find_cached_section(const char *text, const char *dir, const struct stat *st) {
+    size_t dir_len = strlen(dir);
+    for (const char *line = text; line && *line; ) {
+        const char *next = strchr(line, '\n');
+        if (cf_starts_with(line, "dir ")) {
+            long long sec = 0;
+            long nsec = 0;
+            int consumed = 0;
+            if (sscanf(line + 4, "%lld %ld %n", &sec, &nsec, &consumed) == 2 && consumed > 0) {
+                const char *cached_dir = line + 4 + consumed;
+                size_t cached_len = next ? (size_t)(next - cached_dir) : strlen(cached_dir);
+                if (cached_len == dir_len && strncmp(cached_dir, dir, dir_len) == 0) {
+                    if (sec == (long long)st->st_mtim.tv_sec && nsec == (long)st->st_mtim.tv_nsec) return line;
+                    return NULL;
+                }
+            }
+        }
+        line = next ? next + 1 : NULL;
+    }
+    return NULL;
+}
+
+static bool add_cached_section(struct path_index *index, const char *header, struct strbuf *out) {
+    const char *line = strchr(header, '\n');
+    line = line ? line + 1 : header + strlen(header);
+    while (*line == '\t') {
+        const char *next = strchr(line, '\n');
+        size_t len = next ? (size_t)(next - line - 1) : strlen(line + 1);
+        if (!index_insert(index, line + 1, len)) return false;
+        line = next ? next + 1 : line + 1 + len;
+    }
+    return strbuf_append(out, header, (size_t)(line - header));
+}
+
+static bool add_dir_entries(struct path_index *index, const char *dir, struct strbuf *out) {
+    DIR *handle = opendir(dir);
+    if (!handle) return true;
+
+    bool ok = true;
+    struct dirent *entry;
+    while (ok && (entry = readdir(handle)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        if (entry->d_type != DT_REG && entry->d_type != DT_LNK && entry->d_type != DT_UNKNOWN) continue;
+
+        size_t len = strlen(entry->d_name);
+        if (strchr(entry->d_name, '\n')) continue;
+        // Same test as the access(X_OK) fallback; this also drops dangling
+        // symlinks, since faccessat follows them.
+        if (faccessat(dirfd(handle), entry->d_name, X_OK, 0) != 0) continue;
+        ok = index_insert(index, entry->d_name, len);
+        if (ok && out) {
+            ok = strbuf_append(out, "\t", 1) && strbuf_append(out, entry->d_name, len) && strbuf_append(out, "\n", 1);
+        }
+    }
+    closedir(handle);
+    return ok;
+}
+
+static bool path_index_build(struct path_index *index, const char *path_env) {
+    index_free(index);
+    size_t path_len = strlen(path_env);
+    if (path_len >= sizeof(index->path_env)) return false;
+    memcpy(index->path_env, path_env, path_len + 1);
+    if (!index_grow(index)) return false;
+
+    char cache_dir[PATH_MAX];
+    char cache_path[PATH_MAX];
+    bool have_cache_path = path_index_file(cache_path, sizeof(cache_path), cache_dir, sizeof(cache_dir));
+    char *cached = have_cache_path ? load_cache_text(cache_path) : NULL;
+
+    // Rewritten only when PATH or one of its directories changed.
+    struct strbuf out = {NULL, 0, 0};
+    bool ok = strbuf_append(&out, PATH_INDEX_MAGIC, strlen(PATH_INDEX_MAGIC)) &&
+              strbuf_append(&out, "path ", 5) && strbuf_append(&out, path_env, path_len) &&
+              strbuf_append(&out, "\n", 1);
+    bool dirty = !cached || !ok || strncmp(cached + strlen(PATH_INDEX_MAGIC), out.data + strlen(PATH_INDEX_MAGIC),
+                                           out.len - strlen(PATH_INDEX_MAGIC)) != 0;
+
+    for (const char *dir_start = path_env; ok && *dir_start; ) {
+        const char *colon = strchr(dir_start, ':');
+        size_t dir_len = colon ? (size_t)(colon - dir_start) : strlen(dir_start);
+        const char *next = colon ? colon + 1 : dir_start + dir_len;
+
+        char dir[PATH_MAX];
+        if (dir_len == 0 || dir_len >= sizeof(dir)) {
+            dir_start = next;
+            continue;
+        }
+        memcpy(dir, dir_start, dir_len);
+        dir[dir_len] = '\0';
+        dir_start = next;
+
+        // Relative entries depend on the working directory: never cached.
+        if (dir[0] != '/') {
+            ok = add_dir_entries(index, dir, NULL);
+            continue;
+        }
+
+        struct stat st;
+        if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode)) continue;
+
+        const char *section = cached ? find_cached_section(cached, dir, &st) : NULL;
+        if (section) {
+            ok = add_cached_section(index, section, &out);
+            continue;
+        }
+
+        char header[PATH_MAX + 64];
+        int len = snprintf(header, sizeof(header), "dir %lld %ld %s\n",
+                           (long long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec, dir);
+        if (len <= 0 || (size_t)len >= sizeof(header)) continue;
+        dirty = true;
+        ok = strbuf_append(&out, header, (size_t)len) && add_dir_entries(index, dir, &out);
+    }
+
+    // Best effort: a read-only cache dir only costs the next run a rescan.
+    if (ok && dirty && have_cache_path && cf_make_dirs(cache_dir)) {
+        cf_write_file_atomic(cache_path, out.data, out.len);
+    }
+
+    free(out.data);
+    free(cached);
+    if (!ok) {
+        index_free(index);
+        return false;
+    }
+    index->built = true;
+    return true;
+}
+#endif
+
+bool cf_path_index_lookup(const char *path_env, const char *name, bool *exists_out) {
+#ifdef _WIN32
+    (void)path_env;
+    (void)name;
+    (void)exists_out;
+    return false;
+#else
+    if (!path_env || !name || !name[0] || !exists_out || strchr(name, '/')) return false;
+
+    struct path_index *index = &g_path_index;
+    cf_mutex_lock(&g_path_index_lock);
+    bool ready = index->built && strcmp(index->path_env, path_env) == 0;
+    if (!ready) ready = path_index_build(index, path_env);
+    if (ready) *exists_out = index->slots[find_slot(index, name, strlen(name))] != 0;
+    cf_mutex_unlock(&g_path_index_lock);
+    return ready;
+#endif
+}
+
+void cf_path_index_reset(void) {
+#ifndef _WIN32
+    cf_mutex_lock(&g_path_index_lock);
+    index_free(&g_path_index);
+    cf_mutex_unlock(&g_path_index_lock);
+#endif
+}
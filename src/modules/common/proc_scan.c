@@ -0,0 +1,276 @@
+#include "module_helpers.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#define PROC_SCAN_DENTS_BYTES 65536
+#define PROC_SCAN_AUTO_THREADS 4
+#define PROC_SCAN_MAX_THREADS 16
+#define PROC_SCAN_MIN_PIDS_PER_THREAD 512
+#define PROC_SCAN_CHECK_EVERY 64
+
+struct pid_list {
+    int *pids;
+    size_t count;
+    size_t capacity;
+};
+
+static bool pid_list_push(struct pid_list *list, int pid) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+        int *pids = realloc(list->pids, capacity * sizeof(*pids));
+        if (!pids) return false;
+        list->pids = pids;
+        list->capacity = capacity;
+    }
+    list->pids[list->count++] = pid;
+    return true;
+}
+
+static int parse_pid_name(const char *name) {
+    if (!isdigit((unsigned char)name[0])) return -1;
+
+    long pid = 0;
+    for (const char *p = name; *p; p++) {
+        if (!isdigit((unsigned char)*p)) return -1;
+        pid = pid * 10 + (*p - '0');
+        if (pid > INT32_MAX) return -1;
+    }
+    return (int)pid;
+}
+
+#ifdef __linux__
+struct cf_linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// Large getdents64 batches: one syscall covers ~2k /proc entries where
+// readdir() would refill its own 32KB buffer more often.
+static bool collect_pids(int proc_fd, struct pid_list *list) {
+    uint64_t buffer[PROC_SCAN_DENTS_BYTES / sizeof(uint64_t)];
+    char *bytes = (char *)buffer;
+
+    for (;;) {
+        long nread = syscall(SYS_getdents64, proc_fd, buffer, sizeof(buffer));
+        if (nread < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (nread == 0) return true;
+
+        for (long offset = 0; offset < nread; ) {
+            const struct cf_linux_dirent64 *entry = (const struct cf_linux_dirent64 *)(bytes + offset);
+            offset += entry->d_reclen;
+            if (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) continue;
+
+            int pid = parse_pid_name(entry->d_name);
+            if (pid >= 0 && !pid_list_push(list, pid)) return false;
+        }
+    }
+}
+#else
+static bool collect_pids(int proc_fd, struct pid_list *list) {
+    int dup_fd = dup(proc_fd);
+    if (dup_fd < 0) return false;
+
+    DIR *dir = fdopendir(dup_fd);
+    if (!dir) {
+        close(dup_fd);
+        return false;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int pid = parse_pid_name(entry->d_name);
+        if (pid >= 0 && !pid_list_push(list, pid)) break;
+    }
+    closedir(dir);
+    return true;
+}
+#endif
+
+struct scan_shared {
+    int proc_fd;
+    const int *pids;
+    const struct process_match *candidates;
+    size_t num_candidates;
+    pthread_mutex_t lock;
+    size_t best_index;
+    const char *best_label;
+};
+
+struct scan_shard {
+    struct scan_shared *shared;
+    size_t begin;
+    size_t end;
+};
+
+// Results must match a sequential walk, so the match with the lowest list
+// index wins and shards stop once a lower one has already been found.
+static void *scan_shard_run(void *arg) {
+    struct scan_shard *shard = arg;
+    struct scan_shared *shared = shard->shared;
+    char pid_str[16];
+
+    for (size_t i = shard->begin; i < shard->end; i++) {
+        if ((i - shard->begin) % PROC_SCAN_CHECK_EVERY == 0) {
+            pthread_mutex_lock(&shared->lock);
+            bool beaten = shared->best_index < i;
+            pthread_mutex_unlock(&shared->lock);
+            if (beaten) break;
+        }
+
+        snprintf(pid_str, sizeof(pid_str), "%d", shared->pids[i]);
+        const char *label = cf_match_process_label_at(shared->proc_fd, pid_str,
+                                                      shared->candidates, shared->num_candidates);
+        if (!label) continue;
+
+        pthread_mutex_lock(&shared->lock);
+        if (i < shared->best_index) {
+            shared->best_index = i;
+            shared->best_label = label;
+        }
+        pthread_mutex_unlock(&shared->lock);
+        break;
+    }
+    return NULL;
+}
+
+static size_t pick_thread_count(size_t num_pids, unsigned int max_threads) {
+    size_t threads = max_threads;
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t)online : 1;
+        if (threads > PROC_SCAN_AUTO_THREADS) threads = PROC_SCAN_AUTO_THREADS;
+    }
+    if (threads > PROC_SCAN_MAX_THREADS) threads = PROC_SCAN_MAX_THREADS;
+
+    // Thread start-up outweighs the work on ordinary desktops.
+    size_t useful = num_pids / PROC_SCAN_MIN_PIDS_PER_THREAD;
+    if (max_threads == 0 && threads > useful) threads = useful;
+    if (threads > num_pids) threads = num_pids;
+    return threads ? threads : 1;
+}
+#endif
+
+const char *cf_match_process_label_at(
+    int proc_fd,
+    const char *pid,
+    const struct process_match *candidates,
+    size_t num_candidates
+) {
+#ifdef _WIN32
+    (void)proc_fd;
+    (void)pid;
+    (void)candidates;
+    (void)num_candidates;
+    return NULL;
+#else
+    char path[64];
+    char comm[128];
+    char cmdline[512];
+    bool have_comm = false;
+    bool have_cmdline = false;
+    bool cmdline_read = false;
+
+    snprintf(path, sizeof(path), "%s/comm", pid);
+    if (cf_read_file_at(proc_fd, path, comm, sizeof(comm)) > 0) {
+        cf_trim_newline(comm);
+        have_comm = true;
+    }
+
+    // Each file is read once per pid, however many candidates there are;
+    // cmdline only when comm alone did not settle it.
+    for (size_t i = 0; i < num_candidates; i++) {
+        const char *needle = candidates[i].proc_name;
+        if (have_comm && cf_contains_icase(comm, needle)) return candidates[i].label;
+
+        if (!cmdline_read) {
+            cmdline_read = true;
+            snprintf(path, sizeof(path), "%s/cmdline", pid);
+            have_cmdline = cf_read_file_at(proc_fd, path, cmdline, sizeof(cmdline)) > 0;
+        }
+        if (have_cmdline && cf_contains_icase(cmdline, needle)) return candidates[i].label;
+    }
+    return NULL;
+#endif
+}
+
+const char *cf_scan_process_label(
+    const char *proc_root,
+    const struct process_match *candidates,
+    size_t num_candidates,
+    unsigned int max_threads
+) {
+#ifdef _WIN32
+    (void)proc_root;
+    (void)candidates;
+    (void)num_candidates;
+    (void)max_threads;
+    return NULL;
+#else
+    if (!proc_root || !candidates || num_candidates == 0) return NULL;
+
+    int proc_fd = open(proc_root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (proc_fd < 0) return NULL;
+
+    struct pid_list list = {NULL, 0, 0};
+    if (!collect_pids(proc_fd, &list) || list.count == 0) {
+        free(list.pids);
+        close(proc_fd);
+        return NULL;
+    }
+
+    struct scan_shared shared;
+    shared.proc_fd = proc_fd;
+    shared.pids = list.pids;
+    shared.candidates = candidates;
+    shared.num_candidates = num_candidates;
+    shared.best_index = list.count;
+    shared.best_label = NULL;
+    pthread_mutex_init(&shared.lock, NULL);
+
+    size_t num_threads = pick_thread_count(list.count, max_threads);
+    struct scan_shard shards[PROC_SCAN_MAX_THREADS];
+    pthread_t threads[PROC_SCAN_MAX_THREADS];
+    bool started[PROC_SCAN_MAX_THREADS];
+
+    // Contiguous pid ranges; shard 0 runs on the calling thread.
+    size_t per_shard = (list.count + num_threads - 1) / num_threads;
+    for (size_t t = 0; t < num_threads; t++) {
+        shards[t].shared = &shared;
+        shards[t].begin = t * per_shard;
+        shards[t].end = shards[t].begin + per_shard;
+        if (shards[t].begin > list.count) shards[t].begin = list.count;
+        if (shards[t].end > list.count) shards[t].end = list.count;
+        started[t] = false;
+    }
+
+    for (size_t t = 1; t < num_threads; t++) {
+        started[t] = pthread_create(&threads[t], NULL, scan_shard_run, &shards[t]) == 0;
+    }
+    scan_shard_run(&shards[0]);
+    for (size_t t = 1; t < num_threads; t++) {
+        if (started[t]) {
+            pthread_join(threads[t], NULL);
+        } else {
+            scan_shard_run(&shards[t]);
+        }
+    }
+
+    const char *label = shared.best_label;
+    pthread_mutex_destroy(&shared.lock);
+    free(list.pids);
+    close(proc_fd);
+    return label;
+#endif
+}
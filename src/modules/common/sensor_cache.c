@@ -0,0 +1,93 @@
+#include "module_helpers.h"
+
+#ifndef _WIN32
+#include <limits.h>
+
+static bool sensor_cache_path(char *out, size_t out_size) {
+    char cache_dir[PATH_MAX];
+    if (!cf_get_cache_dir(cache_dir, sizeof(cache_dir))) return false;
+    return snprintf(out, out_size, "%s/sensors.cache", cache_dir) < (int)out_size;
+}
+
+static void copy_cache_value(const char *line, const char *prefix, char *out, size_t out_size) {
+    size_t prefix_len = strlen(prefix);
+    if (strncmp(line, prefix, prefix_len) != 0) return;
+
+    const char *value = line + prefix_len;
+    size_t len = strcspn(value, "\n");
+    if (len >= out_size) return;
+    memcpy(out, value, len);
+    out[len] = '\0';
+}
+
+/*
+ * The cache maps roles to sensor files for the current boot: hwmonN numbering
+ * is stable until reboot, so a boot_id match lets later runs open just the
+ * cached temperature files and skip the whole discovery walk.
+ */
+static bool load_sensor_cache(const char *boot_id, struct cf_sensor_paths *paths) {
+    char cache_path[PATH_MAX];
+    char text[1024];
+    if (!sensor_cache_path(cache_path, sizeof(cache_path))) return false;
+    if (cf_read_file(cache_path, text, sizeof(text)) <= 0) return false;
+
+    char cached_boot_id[64] = "";
+    paths->cpu[0] = '\0';
+    paths->gpu[0] = '\0';
+
+    for (const char *line = text; line && *line; ) {
+        copy_cache_value(line, "boot_id ", cached_boot_id, sizeof(cached_boot_id));
+        copy_cache_value(line, "cpu ", paths->cpu, sizeof(paths->cpu));
+        copy_cache_value(line, "gpu ", paths->gpu, sizeof(paths->gpu));
+
+        line = strchr(line, '\n');
+        if (line) line++;
+    }
+
+    return cached_boot_id[0] != '\0' && strcmp(cached_boot_id, boot_id) == 0;
+}
+
+static void store_sensor_cache(const char *boot_id, const struct cf_sensor_paths *paths) {
+    char cache_dir[PATH_MAX];
+    char cache_path[PATH_MAX];
+    if (!cf_get_cache_dir(cache_dir, sizeof(cache_dir)) || !cf_make_dirs(cache_dir)) return;
+    if (!sensor_cache_path(cache_path, sizeof(cache_path))) return;
+
+    char text[1024];
+    int len = snprintf(text, sizeof(text), "boot_id %s\ncpu %s\ngpu %s\n", boot_id, paths->cpu, paths->gpu);
+    if (len <= 0 || (size_t)len >= sizeof(text)) return;
+
+    // Best effort: without a cache the next run just walks hwmon again.
+    cf_write_file_atomic(cache_path, text, (size_t)len);
+}
+
+static bool read_temp_celsius(const char *path, double *celsius_out) {
+    char text[32];
+    if (!path[0] || cf_read_file(path, text, sizeof(text)) <= 0) return false;
+
+    char *endptr = NULL;
+    long millidegrees = strtol(text, &endptr, 10);
+    if (endptr == text) return false;
+
+    *celsius_out = (double)millidegrees / 1000.0;
+    return true;
+}
+
+void cf_read_sensor_temps(const char *boot_id, cf_sensor_discover_fn discover, struct cf_sensor_temps *temps_out) {
+    struct cf_sensor_paths paths;
+    bool cached = boot_id != NULL && load_sensor_cache(boot_id, &paths);
+
+    temps_out->have_cpu = cached && read_temp_celsius(paths.cpu, &temps_out->cpu);
+    temps_out->have_gpu = cached && read_temp_celsius(paths.gpu, &temps_out->gpu);
+
+    // A cached path that stopped working (driver reload, hotplug) means the
+    // mapping is stale: rediscover once and refresh the cache.
+    bool stale = !cached || (paths.cpu[0] && !temps_out->have_cpu) || (paths.gpu[0] && !temps_out->have_gpu);
+    if (!stale) return;
+
+    discover(&paths);
+    temps_out->have_cpu = read_temp_celsius(paths.cpu, &temps_out->cpu);
+    temps_out->have_gpu = read_temp_celsius(paths.gpu, &temps_out->gpu);
+    if (boot_id != NULL) store_sensor_cache(boot_id, &paths);
+}
+#endif
@@ -1,149 +1,189 @@
 #include "../../cupidfetch.h"
 #include "../common/module_helpers.h"
 
-void get_battery() {
-    DIR *dir = opendir("/sys/class/power_supply");
-    if (!dir) return;
+#define BATTERY_READ_CHUNK 8
+
+// Sums over every system battery. Energy is in uWh and power in uW; a
+// battery that reports only charge is converted with its voltage when it
+// has one, and kept in the uAh/uA sums otherwise.
+struct battery_totals {
+    bool found;
+    char status[32];
+    unsigned long cap_sum;
+    size_t cap_count;
+    unsigned long long energy_now;
+    unsigned long long energy_full;
+    unsigned long long energy_rate;
+    unsigned long long charge_now;
+    unsigned long long charge_full;
+    unsigned long long charge_rate;
+    unsigned long long draw_uw;
+};
+
+static unsigned long long psu_value(const struct cf_power_supply *psu, enum cf_power_supply_field field) {
+    return cf_power_supply_has(psu, field) ? psu->values[field] : 0;
+}
 
-    struct dirent *entry;
-    unsigned long cap_sum = 0;
-    size_t cap_count = 0;
-    unsigned long energy_now_sum = 0;
-    unsigned long energy_full_sum = 0;
-    unsigned long energy_rate_sum = 0;
-    unsigned long charge_now_sum = 0;
-    unsigned long charge_full_sum = 0;
-    unsigned long charge_rate_sum = 0;
-    bool found_battery = false;
-    char battery_status[64] = "";
+static void add_battery(struct battery_totals *totals, const struct cf_power_supply *psu) {
+    totals->found = true;
 
-    while ((entry = readdir(dir)) != NULL) {
-        if (entry->d_name[0] == '.') continue;
-
-        char path[512];
-        char type[64];
+    if (psu->status[0] != '\0') {
+        if (totals->status[0] == '\0') {
+            snprintf(totals->status, sizeof(totals->status), "%s", psu->status);
+        } else if (strcmp(totals->status, psu->status) != 0) {
+            snprintf(totals->status, sizeof(totals->status), "Mixed");
+        }
+    }
 
-        if (!cf_build_power_supply_path(path, sizeof(path), entry->d_name, "/type")) continue;
+    if (cf_power_supply_has(psu, CF_PSU_CAPACITY)) {
+        totals->cap_sum += (unsigned long)psu->values[CF_PSU_CAPACITY];
+        totals->cap_count++;
+    }
 
-        if (!cf_read_first_line(path, type, sizeof(type))) continue;
-        if (strcmp(type, "Battery") != 0) continue;
+    unsigned long long voltage = psu_value(psu, CF_PSU_VOLTAGE_NOW);
+    unsigned long long power = psu_value(psu, CF_PSU_POWER_NOW);
+    if (power == 0 && voltage > 0) power = psu_value(psu, CF_PSU_CURRENT_NOW) * voltage / 1000000ULL;
+    totals->draw_uw += power;
+
+    unsigned long long energy_full = psu_value(psu, CF_PSU_ENERGY_FULL);
+    unsigned long long charge_full = psu_value(psu, CF_PSU_CHARGE_FULL);
+    if (cf_power_supply_has(psu, CF_PSU_ENERGY_NOW) && energy_full > 0) {
+        totals->energy_now += psu->values[CF_PSU_ENERGY_NOW];
+        totals->energy_full += energy_full;
+        totals->energy_rate += power;
+    } else if (cf_power_supply_has(psu, CF_PSU_CHARGE_NOW) && charge_full > 0 && voltage > 0) {
+        totals->energy_now += psu->values[CF_PSU_CHARGE_NOW] * voltage / 1000000ULL;
+        totals->energy_full += charge_full * voltage / 1000000ULL;
+        totals->energy_rate += power;
+    } else if (cf_power_supply_has(psu, CF_PSU_CHARGE_NOW) && charge_full > 0) {
+        totals->charge_now += psu->values[CF_PSU_CHARGE_NOW];
+        totals->charge_full += charge_full;
+        totals->charge_rate += psu_value(psu, CF_PSU_CURRENT_NOW);
+    }
+}
 
-        found_battery = true;
+static bool is_system_battery(const struct cf_power_supply *psu, const char *name) {
+    char type[16];
+    const char *kind = psu->type;
 
-        if (battery_status[0] == '\0') {
-            if (cf_build_power_supply_path(path, sizeof(path), entry->d_name, "/status")) {
-                cf_read_first_line(path, battery_status, sizeof(battery_status));
-            }
-        } else if (cf_build_power_supply_path(path, sizeof(path), entry->d_name, "/status")) {
-            char status_this[64];
-            if (cf_read_first_line(path, status_this, sizeof(status_this)) &&
-                status_this[0] != '\0' && strcmp(battery_status, status_this) != 0) {
-                snprintf(battery_status, sizeof(battery_status), "Mixed");
-            }
+    // POWER_SUPPLY_TYPE joined the uevent only in newer kernels.
+    if (kind[0] == '\0') {
+        char path[512];
+        if (!cf_build_power_supply_path(path, sizeof(path), name, "/type") ||
+            !cf_read_first_line(path, type, sizeof(type))) {
+            return false;
         }
+        kind = type;
+    }
+    if (strcmp(kind, "Battery") != 0) return false;
 
-        unsigned long capacity = 0;
-        if (cf_build_power_supply_path(path, sizeof(path), entry->d_name, "/capacity") &&
-            cf_read_ulong_file(path, &capacity)) {
-            cap_sum += capacity;
-            cap_count++;
-        }
+    // Mice, keyboards and headsets report SCOPE=Device.
+    if (strcmp(psu->scope, "Device") == 0) return false;
+    return !cf_power_supply_has(psu, CF_PSU_PRESENT) || psu->values[CF_PSU_PRESENT] != 0;
+}
 
-        char now_path[512];
-        char full_path[512];
-        char rate_path[512];
-        unsigned long now_val = 0;
-        unsigned long full_val = 0;
-        unsigned long rate_val = 0;
-
-        bool have_energy_paths =
-            cf_build_power_supply_path(now_path, sizeof(now_path), entry->d_name, "/energy_now") &&
-            cf_build_power_supply_path(full_path, sizeof(full_path), entry->d_name, "/energy_full");
-
-        if (have_energy_paths && cf_read_ulong_file(now_path, &now_val) && cf_read_ulong_file(full_path, &full_val) && full_val > 0) {
-            energy_now_sum += now_val;
-            energy_full_sum += full_val;
-
-            if (cf_build_power_supply_path(rate_path, sizeof(rate_path), entry->d_name, "/power_now") &&
-                cf_read_ulong_file(rate_path, &rate_val)) {
-                energy_rate_sum += rate_val;
-            }
-            continue;
-        }
+// One chunk of uevent reads; systems with more supplies (UCSI ports, AC
+// adapters, HID batteries) take several.
+struct supply_batch {
+    char names[BATTERY_READ_CHUNK][64];
+    char paths[BATTERY_READ_CHUNK][512];
+    char texts[BATTERY_READ_CHUNK][2048];
+    struct cf_read_request requests[BATTERY_READ_CHUNK];
+    size_t count;
+};
+
+static void flush_supply_batch(struct cf_read_ring *ring, struct supply_batch *batch, struct battery_totals *totals) {
+    if (batch->count == 0) return;
+    cf_read_batch(ring, batch->requests, batch->count);
+
+    for (size_t i = 0; i < batch->count; i++) {
+        struct cf_power_supply psu;
+        if (batch->requests[i].result <= 0 || !cf_parse_power_supply_uevent(batch->texts[i], &psu)) continue;
+        if (is_system_battery(&psu, batch->names[i])) add_battery(totals, &psu);
+    }
+    batch->count = 0;
+}
 
-        if (!cf_build_power_supply_path(now_path, sizeof(now_path), entry->d_name, "/charge_now") ||
-            !cf_build_power_supply_path(full_path, sizeof(full_path), entry->d_name, "/charge_full")) {
-            continue;
-        }
+void get_battery(struct cf_context *ctx, struct cf_sink *sink) {
+    DIR *dir = opendir("/sys/class/power_supply");
+    if (!dir) return;
 
-        if (cf_read_ulong_file(now_path, &now_val) && cf_read_ulong_file(full_path, &full_val) && full_val > 0) {
-            charge_now_sum += now_val;
-            charge_full_sum += full_val;
+    struct cf_read_ring *ring = cf_ctx_read_ring(ctx);
+    struct supply_batch batch;
+    batch.count = 0;
+    struct battery_totals totals;
+    memset(&totals, 0, sizeof(totals));
 
-            if (cf_build_power_supply_path(rate_path, sizeof(rate_path), entry->d_name, "/current_now") &&
-                cf_read_ulong_file(rate_path, &rate_val)) {
-                charge_rate_sum += rate_val;
-            }
+    // Each supply's uevent carries all of its POWER_SUPPLY_* attributes,
+    // so one file per supply, read in batches.
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t slot = batch.count;
+        if (entry->d_name[0] == '.' || strlen(entry->d_name) >= sizeof(batch.names[0])) continue;
+        if (!cf_build_power_supply_path(batch.paths[slot], sizeof(batch.paths[slot]), entry->d_name, "/uevent")) {
+            continue;
         }
-    }
 
+        memcpy(batch.names[slot], entry->d_name, strlen(entry->d_name) + 1);
+        batch.requests[slot].dirfd = CF_AT_FDCWD;
+        batch.requests[slot].path = batch.paths[slot];
+        batch.requests[slot].buffer = batch.texts[slot];
+        batch.requests[slot].size = sizeof(batch.texts[slot]);
+        if (++batch.count == BATTERY_READ_CHUNK) flush_supply_batch(ring, &batch, &totals);
+    }
     closedir(dir);
+    flush_supply_batch(ring, &batch, &totals);
 
-    if (!found_battery) return;
+    if (!totals.found) return;
 
     unsigned long percent = 0;
-    if (cap_count > 0) {
-        percent = cap_sum / cap_count;
-    } else if (energy_full_sum > 0) {
-        percent = (energy_now_sum * 100UL) / energy_full_sum;
-    } else if (charge_full_sum > 0) {
-        percent = (charge_now_sum * 100UL) / charge_full_sum;
+    if (totals.cap_count > 0) {
+        percent = totals.cap_sum / totals.cap_count;
+    } else if (totals.energy_full > 0) {
+        percent = (unsigned long)((totals.energy_now * 100ULL) / totals.energy_full);
+    } else if (totals.charge_full > 0) {
+        percent = (unsigned long)((totals.charge_now * 100ULL) / totals.charge_full);
     } else {
         return;
     }
 
     if (percent > 100UL) percent = 100UL;
 
-    bool is_charging = cf_contains_icase(battery_status, "charging") && !cf_contains_icase(battery_status, "discharging");
-    bool is_discharging = cf_contains_icase(battery_status, "discharging");
-    bool have_time = false;
-    unsigned long remaining_seconds = 0;
-
-    if (is_discharging) {
-        if (energy_now_sum > 0 && energy_rate_sum > 0) {
-            remaining_seconds = (unsigned long)(((unsigned long long)energy_now_sum * 3600ULL) / (unsigned long long)energy_rate_sum);
-            have_time = true;
-        } else if (charge_now_sum > 0 && charge_rate_sum > 0) {
-            remaining_seconds = (unsigned long)(((unsigned long long)charge_now_sum * 3600ULL) / (unsigned long long)charge_rate_sum);
-            have_time = true;
-        }
-    } else if (is_charging) {
-        if (energy_full_sum > energy_now_sum && energy_rate_sum > 0) {
-            unsigned long to_full = energy_full_sum - energy_now_sum;
-            remaining_seconds = (unsigned long)(((unsigned long long)to_full * 3600ULL) / (unsigned long long)energy_rate_sum);
-            have_time = true;
-        } else if (charge_full_sum > charge_now_sum && charge_rate_sum > 0) {
-            unsigned long to_full = charge_full_sum - charge_now_sum;
-            remaining_seconds = (unsigned long)(((unsigned long long)to_full * 3600ULL) / (unsigned long long)charge_rate_sum);
-            have_time = true;
-        }
+    bool is_charging = cf_contains_icase(totals.status, "charging") && !cf_contains_icase(totals.status, "discharging");
+    bool is_discharging = cf_contains_icase(totals.status, "discharging");
+
+    // Time to empty while discharging, to full while charging.
+    unsigned long long amount = 0;
+    unsigned long long rate = 0;
+    if (totals.energy_rate > 0 && totals.energy_full > 0) {
+        amount = is_discharging ? totals.energy_now
+                                : (totals.energy_full > totals.energy_now ? totals.energy_full - totals.energy_now : 0);
+        rate = totals.energy_rate;
+    } else if (totals.charge_rate > 0 && totals.charge_full > 0) {
+        amount = is_discharging ? totals.charge_now
+                                : (totals.charge_full > totals.charge_now ? totals.charge_full - totals.charge_now : 0);
+        rate = totals.charge_rate;
     }
 
-    if (battery_status[0] != '\0') {
-        if (have_time) {
-            char duration[32];
-            cf_format_duration_compact(remaining_seconds, duration, sizeof(duration));
-            if (is_discharging) {
-                print_info("Battery", "%lu%% (%s, %s left)", 20, 30, percent, battery_status, duration);
-            } else if (is_charging) {
-                print_info("Battery", "%lu%% (%s, %s until full)", 20, 30, percent, battery_status, duration);
-            } else {
-                print_info("Battery", "%lu%% (%s)", 20, 30, percent, battery_status);
-            }
-        } else {
-            print_info("Battery", "%lu%% (%s)", 20, 30, percent, battery_status);
-        }
-    } else {
-        print_info("Battery", "%lu%%", 20, 30, percent);
+    // Everything after the status, e.g. ", 2h 10m left, 8.5 W".
+    char detail[128] = "";
+    if ((is_charging || is_discharging) && amount > 0 && rate > 0) {
+        char duration[32];
+        cf_format_duration_compact((unsigned long)(amount * 3600ULL / rate), duration, sizeof(duration));
+        size_t len = strlen(detail);
+        snprintf(detail + len, sizeof(detail) - len, ", %s %s", duration, is_discharging ? "left" : "until full");
+    }
+    if ((is_charging || is_discharging) && totals.draw_uw > 0) {
+        size_t len = strlen(detail);
+        snprintf(detail + len, sizeof(detail) - len, ", %.1f W", (double)totals.draw_uw / 1000000.0);
+    }
+
+    cf_emit_line(sink, "Battery");
+    cf_emit_percent(sink, "percent", (double)percent, 0);
+    if (totals.status[0] != '\0' || detail[0] != '\0') {
+        cf_emit_str(sink, NULL, " (");
+        cf_emit_str(sink, "status", totals.status);
+        cf_emit_str(sink, NULL, detail);
+        cf_emit_str(sink, NULL, ")");
     }
 }
@@ -1,7 +1,14 @@
 #include "../../cupidfetch.h"
 #include "../common/module_helpers.h"
 
-void get_cpu() {
+static void emit_topology(struct cf_sink *sink, unsigned int cores, unsigned int threads) {
+    cf_emit_u64(sink, "cores", cores, NULL);
+    cf_emit_str(sink, NULL, "C/");
+    cf_emit_u64(sink, "threads", threads, NULL);
+    cf_emit_str(sink, NULL, "T");
+}
+
+void get_cpu(struct cf_context *ctx, struct cf_sink *sink) {
 #ifdef _WIN32
     char cpu_name[256] = "";
     unsigned int total_cores = 0;
@@ -85,7 +92,12 @@ void get_cpu() {
         if (total_cores == 0) total_cores = total_threads;
     }
 
-    print_info("CPU", "%s (%uC/%uT)", 20, 30, cpu_name, total_cores, total_threads);
+    (void)ctx;
+    cf_emit_line(sink, "CPU");
+    cf_emit_str(sink, "model", cpu_name);
+    cf_emit_str(sink, NULL, " (");
+    emit_topology(sink, total_cores, total_threads);
+    cf_emit_str(sink, NULL, ")");
     return;
 #else
     FILE* cpuinfo = fopen("/proc/cpuinfo", "r");
@@ -139,22 +151,40 @@ void get_cpu() {
     }
 
     double cpu_usage = 0.0;
-    bool has_usage = cf_detect_cpu_usage_percent(&cpu_usage);
+    bool has_usage = cf_detect_cpu_usage_percent(ctx->state ? &ctx->state->cpu : NULL, &cpu_usage);
 
-    if (model_name[0] != '\0' && num_cores > 0 && logical_threads > 0) {
-        if (has_usage) {
-            print_info("CPU", "%s (%dC/%dT, %.1f%%)", 20, 30, model_name, num_cores, logical_threads, cpu_usage);
-        } else {
-            print_info("CPU", "%s (%dC/%dT)", 20, 30, model_name, num_cores, logical_threads);
-        }
-    } else if (model_name[0] != '\0') {
-        if (has_usage) {
-            print_info("CPU", "%s (%.1f%%)", 20, 30, model_name, cpu_usage);
-        } else {
-            print_info("CPU", "%s", 20, 30, model_name);
-        }
-    } else {
+    // A cpu.max quota caps this process well below the host thread count.
+    struct cf_cgroup_limits limits;
+    bool has_quota = ctx->config->cgroup_aware && cf_read_cgroup_limits(&limits, CF_CGROUP_CPU) &&
+                     limits.have_cpu_quota;
+
+    if (model_name[0] == '\0') {
         cupid_log(LogType_ERROR, "Failed to retrieve CPU information");
+        return;
+    }
+
+    cf_emit_line(sink, "CPU");
+    cf_emit_str(sink, "model", model_name);
+
+    const char *separator = " (";
+    if (num_cores > 0 && logical_threads > 0) {
+        cf_emit_str(sink, NULL, separator);
+        emit_topology(sink, (unsigned int)num_cores, (unsigned int)logical_threads);
+        separator = ", ";
+    }
+    if (has_usage) {
+        cf_emit_str(sink, NULL, separator);
+        cf_emit_percent(sink, "usage_percent", cpu_usage, 1);
+        separator = ", ";
+    }
+    if (has_quota) {
+        char quota_item[48];
+        snprintf(quota_item, sizeof(quota_item), "cgroup %.2f CPUs",
+                 (double)limits.cpu_quota_us / (double)limits.cpu_period_us);
+        cf_emit_str(sink, NULL, separator);
+        cf_emit_str(sink, NULL, quota_item);
+        separator = ", ";
     }
+    if (separator[0] == ',') cf_emit_str(sink, NULL, ")");
 #endif
 }
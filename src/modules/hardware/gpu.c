@@ -12,50 +12,32 @@ static bool read_uevent_value(
         return false;
     }
 
-    FILE *fp = fopen(path, "r");
-    if (!fp) return false;
-
-    char key_prefix[64];
-    if (snprintf(key_prefix, sizeof(key_prefix), "%s=", key) <= 0) {
-        fclose(fp);
-        return false;
-    }
-
-    char line[256];
-    bool found = false;
-    while (fgets(line, sizeof(line), fp)) {
-        if (strncmp(line, key_prefix, strlen(key_prefix)) != 0) continue;
-
-        char *value = line + strlen(key_prefix);
-        cf_trim_newline(value);
-        strncpy(out, value, out_size);
-        out[out_size - 1] = '\0';
-        found = out[0] != '\0';
-        break;
-    }
-
-    fclose(fp);
-    return found;
+    char text[4096];
+    if (cf_read_file(path, text, sizeof(text)) <= 0) return false;
+    return cf_find_key_value(text, key, out, out_size);
 }
 
 static bool read_first_pci_slot_from_sys(char *slot_out, size_t slot_out_size) {
     if (!slot_out || slot_out_size == 0) return false;
 
-    FILE *fp = popen("grep -Rsm1 '^PCI_SLOT_NAME=' /sys 2>/dev/null", "r");
-    if (!fp) return false;
-
+    // Line-buffered so the first match arrives at once and the rest of the
+    // /sys walk can be cut short.
     char line[512] = "";
-    bool ok = fgets(line, sizeof(line), fp) != NULL;
-    pclose(fp);
-    if (!ok) return false;
+    struct cf_command run = {
+        .command = "grep --line-buffered -Rsm1 ^PCI_SLOT_NAME= /sys",
+        .first_line = true,
+        .output = line,
+        .output_size = sizeof(line),
+    };
+    cf_run_command(&run);
+    if (run.timed_out || run.output_len == 0) return false;
 
     char *slot = strstr(line, "PCI_SLOT_NAME=");
     if (!slot) return false;
 
     slot += strlen("PCI_SLOT_NAME=");
     cf_trim_newline(slot);
-    strncpy(slot_out, slot, slot_out_size);
-    slot_out[slot_out_size - 1] = '\0';
+    snprintf(slot_out, slot_out_size, "%s", slot);
     return slot_out[0] != '\0';
 }
 
@@ -67,7 +49,7 @@ static bool is_microsoft_kernel(void) {
     return cf_contains_icase(kernel_release, "microsoft");
 }
 
-void get_gpu() {
+void get_gpu(struct cf_context *ctx, struct cf_sink *sink) {
 #ifdef _WIN32
     FILE *fp = popen("wmic path win32_VideoController get name 2>nul", "r");
     if (!fp) return;
@@ -78,7 +60,7 @@ void get_gpu() {
         cf_trim_newline(trimmed);
         if (!trimmed[0]) continue;
         if (cf_contains_icase(trimmed, "name")) continue;
-        print_info("GPU", "%s", 20, 30, trimmed);
+        print_info(sink, "GPU", "%s", 20, 30, trimmed);
         break;
     }
     pclose(fp);
@@ -174,6 +156,6 @@ void get_gpu() {
         }
     }
 
-    print_info("GPU", "%s", 20, 30, gpu_summary);
+    print_info(sink, "GPU", "%s", 20, 30, gpu_summary);
 #endif
 }
@@ -0,0 +1,410 @@
+#include "../../cupidfetch.h"
+#include "../common/module_helpers.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <time.h>
+
+#define GPU_USAGE_MAX_CARDS 8
+#define GPU_USAGE_MAX_CLIENTS 256
+#define GPU_FDINFO_BATCH 32
+
+enum gpu_stats_source {
+    GPU_STATS_NONE,
+    GPU_STATS_AMDGPU,
+    GPU_STATS_FREQ,
+    GPU_STATS_FDINFO
+};
+
+// fdinfo engine totals for one card, summed over unique DRM clients.
+struct gpu_fdinfo_sample {
+    bool valid;
+    struct timespec taken;
+    struct cf_drm_engine_time engines[CF_DRM_MAX_ENGINES];
+    size_t engine_count;
+    unsigned long long client_ids[GPU_USAGE_MAX_CLIENTS];
+    size_t client_count;
+};
+
+/*
+ * Discovered once and kept across redraws: the fds stay open so watch mode
+ * re-reads each counter with a single pread(2) instead of path lookups.
+ */
+struct gpu_card {
+    char name[16];
+    char driver[32];
+    char pdev[32];
+    enum gpu_stats_source source;
+    int busy_fd;
+    int vram_used_fd;
+    int freq_cur_fd;
+    unsigned long vram_total;
+    unsigned long freq_max_mhz;
+    struct gpu_fdinfo_sample prev;
+    struct gpu_fdinfo_sample cur;
+};
+
+// Lives in the caller's cf_state so each embedding keeps its own cards.
+struct gpu_usage_state {
+    struct gpu_card cards[GPU_USAGE_MAX_CARDS];
+    size_t card_count;
+    bool scanned;
+};
+
+static int open_card_file(const char *card, const char *suffix) {
+    char path[320];
+    if (!cf_build_path3(path, sizeof(path), "/sys/class/drm/", card, suffix)) return -1;
+    return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+static bool read_ulong_fd(int fd, unsigned long *value_out) {
+    if (fd < 0) return false;
+
+    char text[64];
+    ssize_t n = pread(fd, text, sizeof(text) - 1, 0);
+    if (n <= 0) return false;
+    text[n] = '\0';
+
+    char *endptr = NULL;
+    unsigned long value = strtoul(text, &endptr, 10);
+    if (endptr == text) return false;
+
+    *value_out = value;
+    return true;
+}
+
+static bool read_card_ulong(const char *card, const char *suffix, unsigned long *value_out) {
+    int fd = open_card_file(card, suffix);
+    bool ok = read_ulong_fd(fd, value_out);
+    if (fd >= 0) close(fd);
+    return ok;
+}
+
+static void read_card_driver(const char *card, char *out, size_t out_size) {
+    char path[320];
+    char link[512];
+    out[0] = '\0';
+
+    if (!cf_build_path3(path, sizeof(path), "/sys/class/drm/", card, "/device/driver")) return;
+    ssize_t n = readlink(path, link, sizeof(link) - 1);
+    if (n <= 0) return;
+    link[n] = '\0';
+
+    snprintf(out, out_size, "%s", cf_basename_or_self(link));
+}
+
+static void close_card_fd(int *fd) {
+    if (*fd >= 0) close(*fd);
+    *fd = -1;
+}
+
+static void close_card_fds(struct gpu_card *card) {
+    close_card_fd(&card->busy_fd);
+    close_card_fd(&card->vram_used_fd);
+    close_card_fd(&card->freq_cur_fd);
+}
+
+static void setup_card(struct gpu_card *card) {
+    read_card_driver(card->name, card->driver, sizeof(card->driver));
+    cf_read_pci_slot_from_uevent(card->name, card->pdev, sizeof(card->pdev));
+
+    if (strcmp(card->driver, "amdgpu") == 0) {
+        card->busy_fd = open_card_file(card->name, "/device/gpu_busy_percent");
+        card->vram_used_fd = open_card_file(card->name, "/device/mem_info_vram_used");
+        read_card_ulong(card->name, "/device/mem_info_vram_total", &card->vram_total);
+        if (card->busy_fd >= 0) {
+            card->source = GPU_STATS_AMDGPU;
+            return;
+        }
+        // VRAM is only reported next to the busy percent.
+        close_card_fd(&card->vram_used_fd);
+    }
+
+    if (strcmp(card->driver, "i915") == 0) {
+        card->freq_cur_fd = open_card_file(card->name, "/gt_act_freq_mhz");
+        if (card->freq_cur_fd < 0) card->freq_cur_fd = open_card_file(card->name, "/gt_cur_freq_mhz");
+        read_card_ulong(card->name, "/gt_max_freq_mhz", &card->freq_max_mhz);
+    } else if (strcmp(card->driver, "xe") == 0) {
+        card->freq_cur_fd = open_card_file(card->name, "/device/tile0/gt0/freq0/act_freq");
+        read_card_ulong(card->name, "/device/tile0/gt0/freq0/max_freq", &card->freq_max_mhz);
+    }
+    if (card->freq_cur_fd >= 0) {
+        card->source = GPU_STATS_FREQ;
+        return;
+    }
+
+    // No driver-specific counters: fall back to per-client engine time.
+    if (card->pdev[0] != '\0') card->source = GPU_STATS_FDINFO;
+}
+
+static void scan_cards(struct gpu_usage_state *state) {
+    state->scanned = true;
+
+    DIR *dir = opendir("/sys/class/drm");
+    if (!dir) return;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && state->card_count < GPU_USAGE_MAX_CARDS) {
+        if (!cf_is_drm_card_device(entry->d_name)) continue;
+
+        size_t name_len = strlen(entry->d_name);
+        if (name_len >= sizeof(state->cards[0].name)) continue;
+
+        struct gpu_card *card = &state->cards[state->card_count];
+        memset(card, 0, sizeof(*card));
+        memcpy(card->name, entry->d_name, name_len + 1);
+        card->busy_fd = -1;
+        card->vram_used_fd = -1;
+        card->freq_cur_fd = -1;
+
+        setup_card(card);
+        if (card->source != GPU_STATS_NONE) {
+            state->card_count++;
+        } else {
+            // The slot is reused for the next card.
+            close_card_fds(card);
+        }
+    }
+    closedir(dir);
+}
+
+static struct gpu_card *find_fdinfo_card(struct gpu_usage_state *state, const char *pdev) {
+    for (size_t i = 0; i < state->card_count; i++) {
+        if (state->cards[i].source == GPU_STATS_FDINFO && strcmp(state->cards[i].pdev, pdev) == 0) {
+            return &state->cards[i];
+        }
+    }
+    return NULL;
+}
+
+static void add_fdinfo_client(struct gpu_fdinfo_sample *sample, const struct cf_drm_fdinfo *info) {
+    // Several fds can share one DRM client; count its engine time once.
+    for (size_t i = 0; i < sample->client_count; i++) {
+        if (sample->client_ids[i] == info->client_id) return;
+    }
+    if (sample->client_count >= GPU_USAGE_MAX_CLIENTS) return;
+    sample->client_ids[sample->client_count++] = info->client_id;
+
+    for (size_t i = 0; i < info->engine_count; i++) {
+        size_t j = 0;
+        while (j < sample->engine_count && strcmp(sample->engines[j].name, info->engines[i].name) != 0) j++;
+        if (j == sample->engine_count) {
+            if (sample->engine_count >= CF_DRM_MAX_ENGINES) continue;
+            sample->engines[j] = info->engines[i];
+            sample->engine_count++;
+            continue;
+        }
+        sample->engines[j].busy_ns += info->engines[i].busy_ns;
+    }
+}
+
+// DRM fds found in one pass over /proc; their fdinfo files are then read
+// GPU_FDINFO_BATCH at a time through cf_read_batch().
+struct fdinfo_scan {
+    struct gpu_usage_state *state;
+    struct cf_read_ring *ring;
+    int proc_fd;
+    size_t pending;
+    char paths[GPU_FDINFO_BATCH][64];
+    char texts[GPU_FDINFO_BATCH][2048];
+    struct cf_read_request requests[GPU_FDINFO_BATCH];
+};
+
+static void flush_fdinfo_batch(struct fdinfo_scan *scan) {
+    if (scan->pending == 0) return;
+    cf_read_batch(scan->ring, scan->requests, scan->pending);
+
+    for (size_t i = 0; i < scan->pending; i++) {
+        struct cf_drm_fdinfo info;
+        if (scan->requests[i].result <= 0 || !cf_parse_drm_fdinfo(scan->texts[i], &info)) continue;
+
+        struct gpu_card *card = find_fdinfo_card(scan->state, info.pdev);
+        if (card) add_fdinfo_client(&card->cur, &info);
+    }
+    scan->pending = 0;
+}
+
+static bool visit_fdinfo_pid(const char *pid, void *ctx) {
+    struct fdinfo_scan *scan = ctx;
+
+    char fd_dir[64];
+    if (!cf_build_path3(fd_dir, sizeof(fd_dir), "/proc/", pid, "/fd")) return false;
+
+    DIR *dir = opendir(fd_dir);
+    if (!dir) return false;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+
+        // A readlink is much cheaper than reading fdinfo for every fd.
+        char path[128];
+        char target[64];
+        if (!cf_build_path3(path, sizeof(path), fd_dir, "/", entry->d_name)) continue;
+        ssize_t n = readlink(path, target, sizeof(target) - 1);
+        if (n <= 0) continue;
+        target[n] = '\0';
+        if (!cf_starts_with(target, "/dev/dri/")) continue;
+
+        size_t slot = scan->pending;
+        int written = snprintf(scan->paths[slot], sizeof(scan->paths[slot]), "%s/fdinfo/%s", pid, entry->d_name);
+        if (written < 0 || (size_t)written >= sizeof(scan->paths[slot])) continue;
+
+        scan->requests[slot].dirfd = scan->proc_fd;
+        scan->requests[slot].path = scan->paths[slot];
+        scan->requests[slot].buffer = scan->texts[slot];
+        scan->requests[slot].size = sizeof(scan->texts[slot]);
+        if (++scan->pending == GPU_FDINFO_BATCH) flush_fdinfo_batch(scan);
+    }
+    closedir(dir);
+    return false;
+}
+
+static void sample_fdinfo_cards(struct gpu_usage_state *state, struct cf_read_ring *ring) {
+    bool any = false;
+    for (size_t i = 0; i < state->card_count; i++) {
+        struct gpu_card *card = &state->cards[i];
+        if (card->source != GPU_STATS_FDINFO) continue;
+
+        card->prev = card->cur;
+        memset(&card->cur, 0, sizeof(card->cur));
+        clock_gettime(CLOCK_MONOTONIC, &card->cur.taken);
+        card->cur.valid = true;
+        any = true;
+    }
+    if (!any) return;
+
+    struct fdinfo_scan *scan = malloc(sizeof(*scan));
+    if (!scan) return;
+    scan->state = state;
+    scan->ring = ring;
+    scan->proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    scan->pending = 0;
+    if (scan->proc_fd >= 0) {
+        cf_for_each_pid(visit_fdinfo_pid, scan);
+        flush_fdinfo_batch(scan);
+        close(scan->proc_fd);
+    }
+    free(scan);
+}
+
+// Busiest engine over the interval since the previous sample, as a percent.
+static bool fdinfo_busy_percent(const struct gpu_card *card, double *percent_out, const char **engine_out) {
+    if (!card->prev.valid || !card->cur.valid) return false;
+
+    double wall_ns = (double)(card->cur.taken.tv_sec - card->prev.taken.tv_sec) * 1e9 +
+                     (double)(card->cur.taken.tv_nsec - card->prev.taken.tv_nsec);
+    if (wall_ns <= 0.0) return false;
+
+    bool found = false;
+    for (size_t i = 0; i < card->cur.engine_count; i++) {
+        const struct cf_drm_engine_time *engine = &card->cur.engines[i];
+        for (size_t j = 0; j < card->prev.engine_count; j++) {
+            const struct cf_drm_engine_time *before = &card->prev.engines[j];
+            // Totals drop when a client exits; skip rather than go negative.
+            if (strcmp(before->name, engine->name) != 0 || engine->busy_ns < before->busy_ns) continue;
+
+            double percent = (double)(engine->busy_ns - before->busy_ns) * 100.0 / wall_ns;
+            if (percent > 100.0) percent = 100.0;
+            if (!found || percent > *percent_out) {
+                *percent_out = percent;
+                *engine_out = engine->name;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+static void emit_card(struct cf_sink *sink, const char *key, const struct gpu_card *card, const char *driver) {
+    cf_emit_line(sink, key);
+    cf_emit_str(sink, "card", card->name);
+    cf_emit_str(sink, NULL, " ");
+    cf_emit_str(sink, "driver", driver);
+    cf_emit_str(sink, NULL, ": ");
+}
+
+static bool print_card_usage(struct cf_sink *sink, const struct gpu_card *card, const char *key) {
+    unsigned long value = 0;
+
+    switch (card->source) {
+    case GPU_STATS_AMDGPU: {
+        unsigned long busy = 0;
+        if (!read_ulong_fd(card->busy_fd, &busy)) return false;
+
+        emit_card(sink, key, card, card->driver);
+        cf_emit_percent(sink, "busy_percent", (double)busy, 0);
+        cf_emit_str(sink, NULL, " busy");
+        if (card->vram_total > 0 && read_ulong_fd(card->vram_used_fd, &value)) {
+            cf_emit_str(sink, NULL, ", VRAM ");
+            cf_emit_bytes(sink, "vram_used_bytes", value, CF_BYTES_MEMORY);
+            cf_emit_str(sink, NULL, " / ");
+            cf_emit_bytes(sink, "vram_total_bytes", card->vram_total, CF_BYTES_MEMORY);
+        }
+        break;
+    }
+    case GPU_STATS_FREQ:
+        if (!read_ulong_fd(card->freq_cur_fd, &value)) return false;
+        emit_card(sink, key, card, card->driver);
+        if (card->freq_max_mhz > 0) {
+            cf_emit_u64(sink, "freq_mhz", value, NULL);
+            cf_emit_str(sink, NULL, "/");
+            cf_emit_u64(sink, "freq_max_mhz", card->freq_max_mhz, "MHz");
+        } else {
+            cf_emit_u64(sink, "freq_mhz", value, "MHz");
+        }
+        break;
+    case GPU_STATS_FDINFO: {
+        double percent = 0.0;
+        const char *engine = NULL;
+        emit_card(sink, key, card, card->driver[0] ? card->driver : "drm");
+        // The first sample is only a baseline; watch redraws show the rate.
+        if (fdinfo_busy_percent(card, &percent, &engine)) {
+            cf_emit_percent(sink, "busy_percent", percent, 0);
+            cf_emit_str(sink, NULL, " ");
+            cf_emit_str(sink, "engine", engine);
+            cf_emit_str(sink, NULL, ", ");
+        }
+        cf_emit_u64(sink, "clients", card->cur.client_count, "clients");
+        break;
+    }
+    case GPU_STATS_NONE:
+        return false;
+    }
+    return true;
+}
+#endif
+
+void gpu_usage_state_free(struct gpu_usage_state *state) {
+#ifndef _WIN32
+    if (!state) return;
+    for (size_t i = 0; i < state->card_count; i++) close_card_fds(&state->cards[i]);
+#endif
+    free(state);
+}
+
+void get_gpu_usage(struct cf_context *ctx, struct cf_sink *sink) {
+#ifdef _WIN32
+    (void)ctx;
+    (void)sink;
+    return;
+#else
+    // Without a cf_state the cards are found again and dropped afterwards.
+    struct gpu_usage_state *state = ctx->state ? ctx->state->gpu_usage : NULL;
+    if (!state) {
+        state = calloc(1, sizeof(*state));
+        if (!state) return;
+        if (ctx->state) ctx->state->gpu_usage = state;
+    }
+
+    if (!state->scanned) scan_cards(state);
+    sample_fdinfo_cards(state, cf_ctx_read_ring(ctx));
+
+    bool printed = false;
+    for (size_t i = 0; i < state->card_count; i++) {
+        if (print_card_usage(sink, &state->cards[i], printed ? "" : "GPU Usage")) printed = true;
+    }
+
+    if (!ctx->state) gpu_usage_state_free(state);
+#endif
+}
@@ -1,7 +1,138 @@
 #include "../../cupidfetch.h"
 #include "../common/module_helpers.h"
 
-void get_available_memory() {
+// "<used> / <total>" as two byte values, the shape most memory lines share.
+static void emit_used_of(struct cf_sink *sink, const char *used_name, unsigned long long used,
+                         const char *total_name, unsigned long long total) {
+    cf_emit_bytes(sink, used_name, used, CF_BYTES_MEMORY);
+    cf_emit_str(sink, NULL, " / ");
+    cf_emit_bytes(sink, total_name, total, CF_BYTES_MEMORY);
+}
+
+#ifndef _WIN32
+static bool read_zram_totals(unsigned long long *orig_out, unsigned long long *compr_out) {
+    DIR *dir = opendir("/sys/block");
+    if (!dir) return false;
+
+    bool found = false;
+    unsigned long long orig_sum = 0;
+    unsigned long long compr_sum = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!cf_starts_with(entry->d_name, "zram")) continue;
+
+        char path[320];
+        char text[256];
+        if (!cf_build_path3(path, sizeof(path), "/sys/block/", entry->d_name, "/mm_stat")) continue;
+        if (cf_read_file(path, text, sizeof(text)) <= 0) continue;
+
+        // mm_stat: orig_data_size compr_data_size mem_used_total ... (bytes)
+        unsigned long long orig = 0;
+        unsigned long long compr = 0;
+        if (sscanf(text, "%llu %llu", &orig, &compr) != 2) continue;
+
+        orig_sum += orig;
+        compr_sum += compr;
+        found = true;
+    }
+
+    closedir(dir);
+    *orig_out = orig_sum;
+    *compr_out = compr_sum;
+    return found;
+}
+
+static void print_numa_nodes(struct cf_sink *sink) {
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (!dir) return;
+
+    struct {
+        char name[32];
+        unsigned long long free_kb;
+        unsigned long long total_kb;
+    } nodes[16];
+    size_t count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && count < sizeof(nodes) / sizeof(nodes[0])) {
+        if (!cf_starts_with(entry->d_name, "node") || !isdigit((unsigned char)entry->d_name[4])) continue;
+
+        char path[320];
+        char text[4096];
+        struct cf_meminfo node;
+        if (!cf_build_path3(path, sizeof(path), "/sys/devices/system/node/", entry->d_name, "/meminfo")) continue;
+        if (cf_read_file(path, text, sizeof(text)) <= 0 || !cf_parse_meminfo(text, &node)) continue;
+        if (!cf_meminfo_has(&node, CF_MEMINFO_MEM_TOTAL)) continue;
+
+        snprintf(nodes[count].name, sizeof(nodes[count].name), "%.16s", entry->d_name);
+        nodes[count].free_kb = node.values[CF_MEMINFO_MEM_FREE];
+        nodes[count].total_kb = node.values[CF_MEMINFO_MEM_TOTAL];
+        count++;
+    }
+    closedir(dir);
+
+    // A single node just repeats the Memory line.
+    if (count < 2) return;
+
+    for (size_t i = 0; i < count; i++) {
+        cf_emit_line(sink, i == 0 ? "NUMA" : "");
+        cf_emit_str(sink, "node", nodes[i].name);
+        cf_emit_str(sink, NULL, ": ");
+        emit_used_of(sink, "free_bytes", nodes[i].free_kb * 1024ULL, "total_bytes", nodes[i].total_kb * 1024ULL);
+        cf_emit_str(sink, NULL, " free");
+    }
+}
+
+static void print_memory_details(struct cf_sink *sink, const struct cf_meminfo *info) {
+    const unsigned long long *kb = info->values;
+
+    if (kb[CF_MEMINFO_SWAP_TOTAL] > 0) {
+        unsigned long long swap_used = kb[CF_MEMINFO_SWAP_TOTAL] > kb[CF_MEMINFO_SWAP_FREE]
+            ? kb[CF_MEMINFO_SWAP_TOTAL] - kb[CF_MEMINFO_SWAP_FREE] : 0;
+        cf_emit_line(sink, "Swap");
+        emit_used_of(sink, "used_bytes", swap_used * 1024ULL, "total_bytes", kb[CF_MEMINFO_SWAP_TOTAL] * 1024ULL);
+        cf_emit_str(sink, NULL, " (cached ");
+        cf_emit_bytes(sink, "cached_bytes", kb[CF_MEMINFO_SWAP_CACHED] * 1024ULL, CF_BYTES_MEMORY);
+        cf_emit_str(sink, NULL, ")");
+    }
+
+    if (kb[CF_MEMINFO_ZSWAPPED] > 0) {
+        cf_emit_line(sink, "Zswap");
+        cf_emit_bytes(sink, "stored_bytes", kb[CF_MEMINFO_ZSWAPPED] * 1024ULL, CF_BYTES_MEMORY);
+        cf_emit_str(sink, NULL, " stored in ");
+        cf_emit_bytes(sink, "pool_bytes", kb[CF_MEMINFO_ZSWAP] * 1024ULL, CF_BYTES_MEMORY);
+    }
+
+    unsigned long long zram_orig = 0;
+    unsigned long long zram_compr = 0;
+    if (read_zram_totals(&zram_orig, &zram_compr)) {
+        cf_emit_line(sink, "Zram");
+        cf_emit_bytes(sink, "stored_bytes", zram_orig, CF_BYTES_MEMORY);
+        cf_emit_str(sink, NULL, " stored in ");
+        cf_emit_bytes(sink, "compressed_bytes", zram_compr, CF_BYTES_MEMORY);
+    }
+
+    if (kb[CF_MEMINFO_HUGE_PAGES_TOTAL] > 0 || kb[CF_MEMINFO_ANON_HUGE_PAGES] > 0) {
+        cf_emit_line(sink, "Huge Pages");
+        cf_emit_u64(sink, "free_pages", kb[CF_MEMINFO_HUGE_PAGES_FREE], NULL);
+        cf_emit_str(sink, NULL, "/");
+        cf_emit_u64(sink, "total_pages", kb[CF_MEMINFO_HUGE_PAGES_TOTAL], NULL);
+        cf_emit_str(sink, NULL, " free (");
+        cf_emit_u64(sink, "page_size_kb", kb[CF_MEMINFO_HUGE_PAGE_SIZE], "kB");
+        cf_emit_str(sink, NULL, " each), THP ");
+        cf_emit_bytes(sink, "thp_bytes", kb[CF_MEMINFO_ANON_HUGE_PAGES] * 1024ULL, CF_BYTES_MEMORY);
+    }
+
+    cf_emit_line(sink, "Writeback");
+    cf_emit_str(sink, NULL, "dirty ");
+    cf_emit_bytes(sink, "dirty_bytes", kb[CF_MEMINFO_DIRTY] * 1024ULL, CF_BYTES_MEMORY);
+    cf_emit_str(sink, NULL, ", writeback ");
+    cf_emit_bytes(sink, "writeback_bytes", kb[CF_MEMINFO_WRITEBACK] * 1024ULL, CF_BYTES_MEMORY);
+
+    print_numa_nodes(sink);
+}
+#endif
+
+void get_available_memory(struct cf_context *ctx, struct cf_sink *sink) {
 #ifdef _WIN32
     MEMORYSTATUSEX memory_status;
     memset(&memory_status, 0, sizeof(memory_status));
@@ -14,83 +145,52 @@ void get_available_memory() {
     unsigned long long mem_avail_bytes = memory_status.ullAvailPhys;
     unsigned long long mem_used_bytes = (mem_total_bytes > mem_avail_bytes) ? (mem_total_bytes - mem_avail_bytes) : 0;
 
-    print_info(
-        "Memory", "%ld %s / %ld %s", 20, 30,
-        (long)cf_convert_bytes_to_unit(mem_used_bytes, g_userConfig.memory_unit_size),
-        g_userConfig.memory_unit,
-        (long)cf_convert_bytes_to_unit(mem_total_bytes, g_userConfig.memory_unit_size),
-        g_userConfig.memory_unit
-    );
+    (void)ctx;
+    cf_emit_line(sink, "Memory");
+    emit_used_of(sink, "used_bytes", mem_used_bytes, "total_bytes", mem_total_bytes);
     return;
 #else
-    ssize_t mem_avail = -1, mem_total = -1;
-    long mem_used = 0;
-    FILE* meminfo;
-    char line[LINUX_PROC_LINE_SZ];
-
-    meminfo = fopen("/proc/meminfo", "r");
-
-    if (meminfo == NULL) return;
-
-    while (fgets(line, sizeof line, meminfo)) {
-        char *value = NULL;
-        size_t vnum;
-        size_t i, len = 0, vlen = 0;
-
-        for (i = 0; line[i]; i++) {
-            if (!len && line[i] == ':')
-                len = i;
-            if (len && !value && isdigit(line[i]))
-                value = &line[i];
-            if (len && value && isdigit(line[i]))
-                vlen = 1 + &line[i] - value;
-        }
-        if (!len || !vlen || !value)
-            continue;
-
-        line[len] = '\0';
-        value[vlen] = '\0';
-
-        if (1 != sscanf(value, "%zu", &vnum))
-            continue;
-
-        if (0 == strcmp("MemTotal", line)) {
-            mem_total = vnum;
-            mem_used += vnum;
-        } else if (0 == strcmp("MemAvailable", line))
-            mem_avail = vnum;
-        else if (0 == strcmp("Shmem", line))
-            mem_used += vnum;
-        else if (0 == strcmp("MemFree", line))
-            mem_used -= vnum;
-        else if (0 == strcmp("Buffers", line))
-            mem_used -= vnum;
-        else if (0 == strcmp("Cached", line))
-            mem_used -= vnum;
-        else if (0 == strcmp("SReclaimable", line))
-            mem_used -= vnum;
-
-        if (mem_total != -1 && mem_avail != -1)
-            break;
+    char text[8192];
+    struct cf_meminfo info;
+
+    if (cf_read_file("/proc/meminfo", text, sizeof(text)) <= 0 || !cf_parse_meminfo(text, &info)) {
+        cupid_log(LogType_ERROR, "Failed to read /proc/meminfo");
+        return;
     }
+    if (!cf_meminfo_has(&info, CF_MEMINFO_MEM_TOTAL)) return;
 
-    fclose(meminfo);
+    const unsigned long long *kb = info.values;
+    unsigned long long mem_total = kb[CF_MEMINFO_MEM_TOTAL];
+    unsigned long long mem_unused = 0;
 
-    if (meminfo == NULL) {
-        cupid_log(LogType_ERROR, "Failed to open /proc/meminfo");
-        return;
+    if (cf_meminfo_has(&info, CF_MEMINFO_MEM_AVAILABLE)) {
+        mem_unused = kb[CF_MEMINFO_MEM_AVAILABLE];
+    } else {
+        mem_unused = kb[CF_MEMINFO_MEM_FREE] + kb[CF_MEMINFO_BUFFERS] + kb[CF_MEMINFO_CACHED]
+            + kb[CF_MEMINFO_SRECLAIMABLE];
+        mem_unused = mem_unused > kb[CF_MEMINFO_SHMEM] ? mem_unused - kb[CF_MEMINFO_SHMEM] : 0;
     }
+    unsigned long long mem_used = mem_total > mem_unused ? mem_total - mem_unused : 0;
+
+    cf_emit_line(sink, "Memory");
+    emit_used_of(sink, "used_bytes", mem_used * 1024ULL, "total_bytes", mem_total * 1024ULL);
 
-    if (mem_avail != -1) {
-        mem_used = mem_total - mem_avail;
+    // Inside a memory-limited cgroup the host totals overstate what this
+    // process can actually use, so show the cgroup's view next to them.
+    struct cf_cgroup_limits limits;
+    if (ctx->config->cgroup_aware && cf_read_cgroup_limits(&limits, CF_CGROUP_MEMORY) && limits.have_memory_max) {
+        if (limits.have_memory_current) {
+            cf_emit_str(sink, NULL, " (cgroup ");
+            emit_used_of(sink, "cgroup_used_bytes", limits.memory_current, "cgroup_limit_bytes", limits.memory_max);
+        } else {
+            cf_emit_str(sink, NULL, " (cgroup limit ");
+            cf_emit_bytes(sink, "cgroup_limit_bytes", limits.memory_max, CF_BYTES_MEMORY);
+        }
+        cf_emit_str(sink, NULL, ")");
     }
 
-    print_info(
-        "Memory", "%ld %s / %ld %s", 20, 30,
-        (long)cf_convert_bytes_to_unit((unsigned long long)mem_used * 1024ULL, g_userConfig.memory_unit_size),
-        g_userConfig.memory_unit,
-        (long)cf_convert_bytes_to_unit((unsigned long long)mem_total * 1024ULL, g_userConfig.memory_unit_size),
-        g_userConfig.memory_unit
-    );
+    if (ctx->config->memory_detailed) {
+        print_memory_details(sink, &info);
+    }
 #endif
 }
@@ -0,0 +1,165 @@
+#include "../../cupidfetch.h"
+#include "../common/module_helpers.h"
+
+#ifndef _WIN32
+static const char *const cpu_hwmon_names[] = {
+    "coretemp", "k10temp", "zenpower", "cpu_thermal", "soc_thermal"
+};
+static const char *const gpu_hwmon_names[] = {
+    "amdgpu", "radeon", "nouveau", "i915", "xe"
+};
+static const char *const cpu_thermal_zone_types[] = {
+    "x86_pkg_temp", "cpu-thermal", "cpu_thermal", "soc_thermal"
+};
+
+static bool name_in_list(const char *name, const char *const *list, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(name, list[i]) == 0) return true;
+    }
+    return false;
+}
+
+static bool pick_hwmon_temp_input(const char *hwmon_dir, char *out, size_t out_size) {
+    // Prefer the package/die sensor over per-core ones when it is labelled.
+    static const char *const preferred_labels[] = {"Package", "Tctl", "Tdie", "edge"};
+    char path[CF_SENSOR_PATH_LEN + 32];
+    char label[64];
+
+    for (int i = 1; i <= 16; i++) {
+        snprintf(path, sizeof(path), "%s/temp%d_label", hwmon_dir, i);
+        if (!cf_read_first_line(path, label, sizeof(label))) continue;
+
+        for (size_t j = 0; j < sizeof(preferred_labels) / sizeof(preferred_labels[0]); j++) {
+            if (cf_contains_icase(label, preferred_labels[j])) {
+                snprintf(path, sizeof(path), "%s/temp%d_input", hwmon_dir, i);
+                return cf_build_path3(out, out_size, path, "", "");
+            }
+        }
+    }
+
+    snprintf(path, sizeof(path), "%s/temp1_input", hwmon_dir);
+    if (access(path, R_OK) != 0) return false;
+    return cf_build_path3(out, out_size, path, "", "");
+}
+
+static void discover_sensor_paths(struct cf_sensor_paths *paths) {
+    paths->cpu[0] = '\0';
+    paths->gpu[0] = '\0';
+
+    DIR *dir = opendir("/sys/class/hwmon");
+    if (dir) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (!cf_starts_with(entry->d_name, "hwmon")) continue;
+
+            char hwmon_dir[CF_SENSOR_PATH_LEN];
+            char name_path[CF_SENSOR_PATH_LEN + 8];
+            char name[64];
+            if (!cf_build_path3(hwmon_dir, sizeof(hwmon_dir), "/sys/class/hwmon/", entry->d_name, "")) continue;
+            snprintf(name_path, sizeof(name_path), "%s/name", hwmon_dir);
+            if (!cf_read_first_line(name_path, name, sizeof(name))) continue;
+
+            if (paths->cpu[0] == '\0' &&
+                name_in_list(name, cpu_hwmon_names, sizeof(cpu_hwmon_names) / sizeof(cpu_hwmon_names[0]))) {
+                pick_hwmon_temp_input(hwmon_dir, paths->cpu, sizeof(paths->cpu));
+            } else if (paths->gpu[0] == '\0' &&
+                       name_in_list(name, gpu_hwmon_names, sizeof(gpu_hwmon_names) / sizeof(gpu_hwmon_names[0]))) {
+                pick_hwmon_temp_input(hwmon_dir, paths->gpu, sizeof(paths->gpu));
+            }
+        }
+        closedir(dir);
+    }
+
+    if (paths->cpu[0] != '\0') return;
+
+    dir = opendir("/sys/class/thermal");
+    if (!dir) return;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!cf_starts_with(entry->d_name, "thermal_zone")) continue;
+
+        char path[CF_SENSOR_PATH_LEN];
+        char type[64];
+        if (!cf_build_path3(path, sizeof(path), "/sys/class/thermal/", entry->d_name, "/type")) continue;
+        if (!cf_read_first_line(path, type, sizeof(type))) continue;
+        if (!name_in_list(type, cpu_thermal_zone_types, sizeof(cpu_thermal_zone_types) / sizeof(cpu_thermal_zone_types[0]))) {
+            continue;
+        }
+
+        cf_build_path3(paths->cpu, sizeof(paths->cpu), "/sys/class/thermal/", entry->d_name, "/temp");
+        break;
+    }
+    closedir(dir);
+}
+
+static bool read_cpu_frequencies(struct cf_sink *sink) {
+    // One cpufreq policy per frequency domain, so this is the per-core view
+    // without reading the same files once per sibling.
+    DIR *dir = opendir("/sys/devices/system/cpu/cpufreq");
+    if (!dir) return false;
+
+    unsigned long cur_min = 0, cur_max = 0, limit_min = 0, limit_max = 0;
+    unsigned long long cur_sum = 0;
+    size_t count = 0;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!cf_starts_with(entry->d_name, "policy")) continue;
+
+        char path[320];
+        unsigned long cur = 0, min = 0, max = 0;
+        if (!cf_build_path3(path, sizeof(path), "/sys/devices/system/cpu/cpufreq/", entry->d_name, "/scaling_cur_freq") ||
+            !cf_read_ulong_file(path, &cur)) {
+            continue;
+        }
+        if (cf_build_path3(path, sizeof(path), "/sys/devices/system/cpu/cpufreq/", entry->d_name, "/scaling_min_freq")) {
+            cf_read_ulong_file(path, &min);
+        }
+        if (cf_build_path3(path, sizeof(path), "/sys/devices/system/cpu/cpufreq/", entry->d_name, "/scaling_max_freq")) {
+            cf_read_ulong_file(path, &max);
+        }
+
+        if (count == 0 || cur < cur_min) cur_min = cur;
+        if (count == 0 || cur > cur_max) cur_max = cur;
+        if (min > 0 && (limit_min == 0 || min < limit_min)) limit_min = min;
+        if (max > limit_max) limit_max = max;
+        cur_sum += cur;
+        count++;
+    }
+    closedir(dir);
+
+    if (count == 0) return false;
+
+    // sysfs reports kHz.
+    double avg_ghz = (double)(cur_sum / count) / 1e6;
+    if (limit_min > 0 && limit_max > 0) {
+        print_info(sink, "CPU Freq", "%.2f GHz avg (%.2f-%.2f GHz now, limits %.2f-%.2f GHz)", 20, 30,
+                   avg_ghz, (double)cur_min / 1e6, (double)cur_max / 1e6,
+                   (double)limit_min / 1e6, (double)limit_max / 1e6);
+    } else {
+        print_info(sink, "CPU Freq", "%.2f GHz avg (%.2f-%.2f GHz now)", 20, 30,
+                   avg_ghz, (double)cur_min / 1e6, (double)cur_max / 1e6);
+    }
+    return true;
+}
+#endif
+
+void get_sensors(struct cf_context *ctx, struct cf_sink *sink) {
+#ifdef _WIN32
+    return;
+#else
+    read_cpu_frequencies(sink);
+
+    struct cf_sensor_temps temps;
+    cf_read_sensor_temps(cf_ctx_boot_id(ctx), discover_sensor_paths, &temps);
+
+    if (temps.have_cpu && temps.have_gpu) {
+        print_info(sink, "Temps", "CPU %.1f°C, GPU %.1f°C", 20, 30, temps.cpu, temps.gpu);
+    } else if (temps.have_cpu) {
+        print_info(sink, "Temps", "CPU %.1f°C", 20, 30, temps.cpu);
+    } else if (temps.have_gpu) {
+        print_info(sink, "Temps", "GPU %.1f°C", 20, 30, temps.gpu);
+    }
+#endif
+}
@@ -1,7 +1,7 @@
 #include "../../cupidfetch.h"
 #include "../common/module_helpers.h"
 
-void get_local_ip() {
+void get_local_ip(struct cf_context *ctx, struct cf_sink *sink) {
     char iface[64] = "";
     char ip_addr[INET6_ADDRSTRLEN] = "";
     bool up = false;
@@ -10,5 +10,5 @@ void get_local_ip() {
         return;
     }
 
-    print_info("Local IP", "%s", 20, 30, ip_addr);
+    print_info(sink, "Local IP", "%s", 20, 30, ip_addr);
 }
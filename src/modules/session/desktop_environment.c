@@ -1,16 +1,16 @@
 #include "../../cupidfetch.h"
 #include "../common/module_helpers.h"
 
-void get_desktop_environment() {
+void get_desktop_environment(struct cf_context *ctx, struct cf_sink *sink) {
     const char* xdgDesktop = getenv("XDG_CURRENT_DESKTOP");
     if (xdgDesktop != NULL && strlen(xdgDesktop) > 0) {
-        print_info("DE", xdgDesktop, 20, 30);
+        print_info(sink, "DE", xdgDesktop, 20, 30);
         return;
     }
 
     const char* desktopSession = getenv("DESKTOP_SESSION");
     if (desktopSession != NULL && strlen(desktopSession) > 0) {
-        print_info("DE", desktopSession, 20, 30);
+        print_info(sink, "DE", desktopSession, 20, 30);
         return;
     }
 
@@ -34,8 +34,10 @@ void get_desktop_environment() {
         {"hyprland", "Hyprland"},
     };
 
-    const char *detected = cf_detect_process_label(de_candidates, sizeof(de_candidates) / sizeof(de_candidates[0]));
+    size_t num_candidates = sizeof(de_candidates) / sizeof(de_candidates[0]);
+    const char *detected = cf_detect_display_server_label(de_candidates, num_candidates);
+    if (!detected) detected = cf_detect_process_label(de_candidates, num_candidates);
     if (detected) {
-        print_info("DE", detected, 20, 30);
+        print_info(sink, "DE", detected, 20, 30);
     }
 }
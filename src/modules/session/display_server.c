@@ -1,28 +1,45 @@
 #include "../../cupidfetch.h"
 #include "../common/module_helpers.h"
 
-void get_display_server() {
+void get_display_server(struct cf_context *ctx, struct cf_sink *sink) {
     const char *session_type = getenv("XDG_SESSION_TYPE");
     if (session_type && session_type[0]) {
         if (cf_contains_icase(session_type, "wayland")) {
-            print_info("Display Server", "Wayland", 20, 30);
+            print_info(sink, "Display Server", "Wayland", 20, 30);
             return;
         }
         if (cf_contains_icase(session_type, "x11")) {
-            print_info("Display Server", "X11", 20, 30);
+            print_info(sink, "Display Server", "X11", 20, 30);
             return;
         }
-        print_info("Display Server", session_type, 20, 30);
+        print_info(sink, "Display Server", session_type, 20, 30);
         return;
     }
 
     if (getenv("WAYLAND_DISPLAY")) {
-        print_info("Display Server", "Wayland", 20, 30);
+        print_info(sink, "Display Server", "Wayland", 20, 30);
         return;
     }
 
     if (getenv("DISPLAY")) {
-        print_info("Display Server", "X11", 20, 30);
+        print_info(sink, "Display Server", "X11", 20, 30);
+        return;
+    }
+
+    // No session variables: ask whoever owns the default display socket.
+    static const struct process_match xwayland_candidate[] = {
+        {"xwayland", "XWayland"},
+    };
+    long server_pid = 0;
+    bool is_wayland = false;
+    if (cf_display_server_pid(&server_pid, &is_wayland)) {
+        if (is_wayland) {
+            print_info(sink, "Display Server", "Wayland", 20, 30);
+        } else if (cf_process_label_for_pid(server_pid, xwayland_candidate, 1)) {
+            print_info(sink, "Display Server", "XWayland", 20, 30);
+        } else {
+            print_info(sink, "Display Server", "X11", 20, 30);
+        }
         return;
     }
 
@@ -34,6 +51,6 @@ void get_display_server() {
 
     const char *detected = cf_detect_process_label(ds_candidates, sizeof(ds_candidates) / sizeof(ds_candidates[0]));
     if (detected) {
-        print_info("Display Server", detected, 20, 30);
+        print_info(sink, "Display Server", detected, 20, 30);
     }
 }
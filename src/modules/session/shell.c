@@ -1,26 +1,11 @@
 #include "../../cupidfetch.h"
 
-void get_shell() {
-#ifdef _WIN32
-    const char *shell = getenv("ComSpec");
-    if (!shell || !shell[0]) shell = "cmd.exe";
-#else
-    const char *shell = getenv("SHELL");
-    if (shell == NULL || shell[0] == '\0') {
-        uid_t uid = geteuid();
-        struct passwd *pw = getpwuid(uid);
-        if (pw == NULL) {
-            cupid_log(LogType_ERROR, "getpwuid failed to retrieve user password entry");
-            return;
-        }
-        shell = pw->pw_shell;
-    }
-
+void get_shell(struct cf_context *ctx, struct cf_sink *sink) {
+    const char *shell = cf_ctx_shell(ctx);
     if (shell == NULL) {
         cupid_log(LogType_ERROR, "getpwuid failed to retrieve user shell information");
         return;
     }
-#endif
 
 #ifdef _WIN32
     const char *baseName = strrchr(shell, '\\');
@@ -31,5 +16,5 @@ void get_shell() {
     baseName = (baseName != NULL) ? baseName + 1 : shell;
 #endif
 
-    print_info("Shell", baseName, 20, 30);
+    print_info(sink, "Shell", baseName, 20, 30);
 }
@@ -2,6 +2,8 @@
 #include "../common/module_helpers.h"
 
 #ifndef _WIN32
+#include <fcntl.h>
+
 static bool is_likely_shell_process(const char *name) {
     if (!name || !name[0]) return false;
 
@@ -33,38 +35,28 @@ static bool is_likely_terminal_process(const char *name) {
     return false;
 }
 
-static bool read_proc_comm(pid_t pid, char *buffer, size_t buffer_size) {
+static bool read_proc_comm(int proc_fd, pid_t pid, char *buffer, size_t buffer_size) {
     if (!buffer || buffer_size == 0) return false;
 
     char path[64];
-    snprintf(path, sizeof(path), "/proc/%ld/comm", (long)pid);
+    snprintf(path, sizeof(path), "%ld/comm", (long)pid);
 
-    if (!cf_read_first_line(path, buffer, buffer_size)) return false;
+    if (!cf_read_first_line_at(proc_fd, path, buffer, buffer_size)) return false;
     return buffer[0] != '\0';
 }
 
-static bool read_parent_pid(pid_t pid, pid_t *ppid_out) {
+static bool read_parent_pid(int proc_fd, pid_t pid, pid_t *ppid_out) {
     if (!ppid_out) return false;
 
     char path[64];
-    snprintf(path, sizeof(path), "/proc/%ld/stat", (long)pid);
-
-    FILE *fp = fopen(path, "r");
-    if (!fp) return false;
+    snprintf(path, sizeof(path), "%ld/stat", (long)pid);
 
     char stat_line[1024];
-    if (!fgets(stat_line, sizeof(stat_line), fp)) {
-        fclose(fp);
+    long ppid_long = 0;
+    if (cf_read_file_at(proc_fd, path, stat_line, sizeof(stat_line)) <= 0 ||
+        !cf_parse_proc_stat_line(stat_line, NULL, 0, &ppid_long, NULL)) {
         return false;
     }
-    fclose(fp);
-
-    char *rparen = strrchr(stat_line, ')');
-    if (!rparen || rparen[1] != ' ') return false;
-
-    char state = '\0';
-    long ppid_long = 0;
-    if (sscanf(rparen + 2, "%c %ld", &state, &ppid_long) != 2) return false;
     if (ppid_long <= 0) return false;
 
     *ppid_out = (pid_t)ppid_long;
@@ -74,27 +66,32 @@ static bool read_parent_pid(pid_t pid, pid_t *ppid_out) {
 static bool detect_terminal_from_process_tree(char *terminal_out, size_t terminal_out_size) {
     if (!terminal_out || terminal_out_size == 0) return false;
 
+    int proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (proc_fd < 0) return false;
+
+    bool found = false;
     pid_t pid = getppid();
     for (int depth = 0; depth < 32 && pid > 1; depth++) {
         char comm[128] = {0};
-        if (!read_proc_comm(pid, comm, sizeof(comm))) break;
+        if (!read_proc_comm(proc_fd, pid, comm, sizeof(comm))) break;
 
         if (strcasecmp(comm, "cupidfetch") != 0 && !is_likely_shell_process(comm) && is_likely_terminal_process(comm)) {
-            strncpy(terminal_out, comm, terminal_out_size - 1);
-            terminal_out[terminal_out_size - 1] = '\0';
-            return true;
+            snprintf(terminal_out, terminal_out_size, "%s", comm);
+            found = true;
+            break;
         }
 
         pid_t next_pid = 0;
-        if (!read_parent_pid(pid, &next_pid) || next_pid == pid) break;
+        if (!read_parent_pid(proc_fd, pid, &next_pid) || next_pid == pid) break;
         pid = next_pid;
     }
 
-    return false;
+    close(proc_fd);
+    return found;
 }
 #endif
 
-void get_terminal() {
+void get_terminal(struct cf_context *ctx, struct cf_sink *sink) {
     if (!isatty(STDOUT_FILENO)) {
 #ifdef _WIN32
         return;
@@ -107,7 +104,7 @@ void get_terminal() {
 #ifdef _WIN32
     const char *term_program = getenv("WT_SESSION");
     if (term_program && term_program[0]) {
-        print_info("Terminal", "%s", 20, 30, "Windows Terminal");
+        print_info(sink, "Terminal", "%s", 20, 30, "Windows Terminal");
         return;
     }
     term_program = getenv("TERM_PROGRAM");
@@ -131,5 +128,5 @@ void get_terminal() {
         return;
     }
 
-    print_info("Terminal", "%s", 20, 30, term_program);
+    print_info(sink, "Terminal", "%s", 20, 30, term_program);
 }
@@ -1,11 +1,11 @@
 #include "../../cupidfetch.h"
 #include "../common/module_helpers.h"
 
-void get_window_manager() {
+void get_window_manager(struct cf_context *ctx, struct cf_sink *sink) {
     const char *wm_env = getenv("WINDOWMANAGER");
     const char *wm_name = cf_basename_or_self(wm_env);
     if (wm_name && wm_name[0]) {
-        print_info("WM", wm_name, 20, 30);
+        print_info(sink, "WM", wm_name, 20, 30);
         return;
     }
 
@@ -58,8 +58,12 @@ void get_window_manager() {
         {"gamescope", "gamescope"},
     };
 
-    const char *detected = cf_detect_process_label(wm_candidates, sizeof(wm_candidates) / sizeof(wm_candidates[0]));
+    // On Wayland the compositor owns the display socket, so its peer pid is
+    // the WM; on X11 the peer is the X server and this falls through.
+    size_t num_candidates = sizeof(wm_candidates) / sizeof(wm_candidates[0]);
+    const char *detected = cf_detect_display_server_label(wm_candidates, num_candidates);
+    if (!detected) detected = cf_detect_process_label(wm_candidates, num_candidates);
     if (detected) {
-        print_info("WM", detected, 20, 30);
+        print_info(sink, "WM", detected, 20, 30);
     }
 }
@@ -4,7 +4,22 @@
 #include "../../cupidfetch.h"
 #include "../common/module_helpers.h"
 
-void get_available_storage() {
+static void emit_mount(struct cf_sink *sink, bool first, const char *mount,
+                       unsigned long long total_bytes, unsigned long long available_bytes) {
+    unsigned long long used_bytes = total_bytes > available_bytes ? total_bytes - available_bytes : 0;
+
+    cf_emit_line(sink, first ? "Storage" : "");
+    cf_emit_str(sink, "mount", mount);
+    cf_emit_str(sink, NULL, ": ");
+    cf_emit_bytes(sink, "used_bytes", used_bytes, CF_BYTES_STORAGE);
+    cf_emit_str(sink, NULL, " / ");
+    cf_emit_bytes(sink, "total_bytes", total_bytes, CF_BYTES_STORAGE);
+    cf_emit_str(sink, NULL, " (");
+    cf_emit_percent(sink, "used_percent", (double)used_bytes * 100.0 / (double)total_bytes, 0);
+    cf_emit_str(sink, NULL, ")");
+}
+
+void get_available_storage(struct cf_context *ctx, struct cf_sink *sink) {
 #ifdef _WIN32
     char drives[512];
     DWORD len = GetLogicalDriveStringsA((DWORD)sizeof(drives), drives);
@@ -22,18 +37,9 @@ void get_available_storage() {
             continue;
         }
 
-        unsigned long total = cf_convert_bytes_to_unit(total_bytes.QuadPart, g_userConfig.storage_unit_size);
-        unsigned long available = cf_convert_bytes_to_unit(total_free_bytes.QuadPart, g_userConfig.storage_unit_size);
-        unsigned long used = (total > available) ? (total - available) : 0;
-        unsigned long usage_percent = total > 0 ? (used * 100UL) / total : 0;
-        if (total == 0) continue;
+        if (cf_convert_bytes_to_unit(total_bytes.QuadPart, ctx->config->storage_unit_size) == 0) continue;
 
-        print_info(
-            first ? "Storage" : "",
-            "%s: %lu/%lu %s (%lu%%)",
-            20, 30,
-            drive, used, total, g_userConfig.storage_unit, usage_percent
-        );
+        emit_mount(sink, first, drive, total_bytes.QuadPart, total_free_bytes.QuadPart);
         first = false;
     }
     return;
@@ -61,19 +67,10 @@ void get_available_storage() {
         unsigned long long total_bytes = (unsigned long long)stat.f_blocks * (unsigned long long)stat.f_frsize;
         unsigned long long available_bytes = (unsigned long long)stat.f_bavail * (unsigned long long)stat.f_frsize;
 
-        unsigned long total = cf_convert_bytes_to_unit(total_bytes, g_userConfig.storage_unit_size);
-        unsigned long available = cf_convert_bytes_to_unit(available_bytes, g_userConfig.storage_unit_size);
-        unsigned long used = (total > available) ? (total - available) : 0;
-        unsigned long usage_percent = total > 0 ? (used * 100UL) / total : 0;
-
-        if (total == 0) continue;
+        // Skip mounts that round to zero in the display unit.
+        if (cf_convert_bytes_to_unit(total_bytes, ctx->config->storage_unit_size) == 0) continue;
 
-        print_info(
-            first ? "Storage" : "",
-            "%s: %lu/%lu %s (%lu%%)",
-            20, 30,
-            mnt_point, used, total, g_userConfig.storage_unit, usage_percent
-        );
+        emit_mount(sink, first, mnt_point, total_bytes, available_bytes);
         first = false;
     }
     fclose(mount_file);
@@ -0,0 +1,46 @@
+#include "../../cupidfetch.h"
+#include "../common/module_helpers.h"
+
+void get_cgroup(struct cf_context *ctx, struct cf_sink *sink) {
+    struct cf_cgroup_limits limits;
+    if (!cf_read_cgroup_limits(&limits, CF_CGROUP_ALL)) return;
+
+    char summary[768] = "";
+    char item[320];
+
+    if (limits.have_memory_current && limits.have_memory_max) {
+        snprintf(item, sizeof(item), "mem %lu %s / %lu %s",
+                 cf_convert_bytes_to_unit(limits.memory_current, ctx->config->memory_unit_size),
+                 ctx->config->memory_unit,
+                 cf_convert_bytes_to_unit(limits.memory_max, ctx->config->memory_unit_size),
+                 ctx->config->memory_unit);
+        cf_append_csv_item(summary, sizeof(summary), item);
+    } else if (limits.have_memory_current) {
+        snprintf(item, sizeof(item), "mem %lu %s",
+                 cf_convert_bytes_to_unit(limits.memory_current, ctx->config->memory_unit_size),
+                 ctx->config->memory_unit);
+        cf_append_csv_item(summary, sizeof(summary), item);
+    }
+
+    if (limits.have_cpu_quota) {
+        snprintf(item, sizeof(item), "cpu %.2f CPUs (%llu/%llu us)",
+                 (double)limits.cpu_quota_us / (double)limits.cpu_period_us,
+                 limits.cpu_quota_us, limits.cpu_period_us);
+        cf_append_csv_item(summary, sizeof(summary), item);
+    }
+
+    if (limits.have_pids_current && limits.have_pids_max) {
+        snprintf(item, sizeof(item), "pids %llu/%llu", limits.pids_current, limits.pids_max);
+        cf_append_csv_item(summary, sizeof(summary), item);
+    } else if (limits.have_pids_current) {
+        snprintf(item, sizeof(item), "pids %llu", limits.pids_current);
+        cf_append_csv_item(summary, sizeof(summary), item);
+    }
+
+    if (summary[0] == '\0') {
+        print_info(sink, "Cgroup", "%s", 20, 30, limits.path);
+        return;
+    }
+
+    print_info(sink, "Cgroup", "%s | %s", 20, 30, limits.path, summary);
+}
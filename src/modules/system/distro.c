@@ -1,6 +1,6 @@
 #include "../../cupidfetch.h"
 
-void get_distro() {
-    const char *distro = detect_linux_distro();
-    print_info("Distro", distro, 20, 30);
+void get_distro(struct cf_context *ctx, struct cf_sink *sink) {
+    const char *distro = detect_linux_distro(ctx);
+    print_info(sink, "Distro", distro, 20, 30);
 }
@@ -1,27 +0,0 @@
-#include "../../cupidfetch.h"
-
-const char* get_home_directory() {
-    static char *homeDir = NULL;
-
-    if (homeDir != NULL) return homeDir;
-
-#ifdef _WIN32
-    if ((homeDir = getenv("USERPROFILE")) == NULL) {
-        homeDir = getenv("HOME");
-    }
-    if (homeDir == NULL) {
-        fprintf(stderr, "home directory couldn't be found\n");
-        exit(EXIT_FAILURE);
-    }
-#else
-    if ((homeDir = getenv("HOME")) == NULL) {
-        struct passwd* pw = getpwuid(getuid());
-        if (pw == NULL) {
-            fprintf(stderr, "home directory couldn't be found sir\n");
-            exit(EXIT_FAILURE);
-        }
-        homeDir = pw->pw_dir;
-    }
-#endif
-    return homeDir;
-}
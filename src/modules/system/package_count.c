@@ -1,4 +1,5 @@
 #include "../../cupidfetch.h"
+#include "../../distro_table.h"
 #include "../common/module_helpers.h"
 
 typedef bool (*count_fn_t)(unsigned long *count_out);
@@ -34,22 +35,21 @@ static bool parse_count(const char *text, unsigned long *count_out) {
     return true;
 }
 
+static void init_line_count_command(struct cf_command *run, const char *command) {
+    memset(run, 0, sizeof(*run));
+    run->command = command;
+    run->exit_status = -1;
+}
+
 static bool count_lines_from_command(const char *command, unsigned long *count_out) {
     if (!command || !command[0] || !count_out) return false;
 
-    FILE *fp = popen(command, "r");
-    if (!fp) return false;
-
-    char line[512];
-    unsigned long lines = 0;
-    while (fgets(line, sizeof(line), fp)) {
-        lines++;
-    }
-
-    int status = pclose(fp);
-    if (status == -1) return false;
+    struct cf_command run;
+    init_line_count_command(&run, command);
+    cf_run_command(&run);
+    if (run.exit_status < 0) return false;
 
-    *count_out = lines;
+    *count_out = run.lines;
     return true;
 }
 
@@ -115,74 +115,58 @@ static bool count_slackware_db(unsigned long *count_out) {
     return count_entries_in_dir("/var/log/packages", count_out);
 }
 
-static bool is_shell_heavy_command(const char *command) {
-    if (!command || !command[0]) return true;
-
-    for (const char *p = command; *p; p++) {
-        if (*p == '|' || *p == ';' || *p == '&' || *p == '>' || *p == '<' ||
-            *p == '`' || *p == '$' || *p == '(' || *p == ')' ||
-            *p == '\n' || *p == '\r') {
-            return true;
-        }
-    }
-
-    return false;
+// os-release IDs (a distro's own or one it lists in ID_LIKE) and the
+// package manager that owns the system database on that family.
+static const struct {
+    const char *family;
+    const char *label;
+} native_managers[] = {
+    {"debian", "dpkg"}, {"ubuntu", "dpkg"},
+    {"arch", "pacman"}, {"arch", "yay"}, {"arch", "paru"},
+    {"fedora", "rpm"}, {"rhel", "rpm"}, {"centos", "rpm"}, {"suse", "rpm"}, {"opensuse", "rpm"},
+    {"mandriva", "rpm"}, {"mageia", "rpm"}, {"amzn", "rpm"},
+    {"alpine", "apk"},
+    {"void", "xbps"},
+    {"gentoo", "portage"},
+    {"solus", "eopkg"},
+    {"nixos", "nix"},
+    {"slackware", "slackpkg"},
+};
+
+// Installable on any distro, so always worth a probe.
+static bool is_universal_manager(const char *label) {
+    return strcmp(label, "snap") == 0 || strcmp(label, "flatpak") == 0;
 }
 
-static bool distro_matches_any(const char *distro, const char *const *names, size_t names_count) {
-    if (!distro || !distro[0]) return false;
-    for (size_t i = 0; i < names_count; i++) {
-        if (cf_contains_icase(distro, names[i])) return true;
-    }
-    return false;
+// Without os-release the distro table entry of the displayed name stands
+// in for it.
+static bool family_matches(const char *family, const struct cf_os_release *os, const struct cf_distro_def *named) {
+    if (os) return cf_os_release_is_like(os, family);
+    return named && strcmp(named->id, family) == 0;
 }
 
-static bool distro_prefers_manager(const char *distro, const char *label) {
-    static const char *dpkg_distros[] = {
-        "Ubuntu", "Debian", "Linux Mint", "Pop!_OS", "Zorin", "Kali", "MX", "elementary", "Peppermint"
-    };
-    static const char *pacman_distros[] = {
-        "Arch", "Manjaro", "EndeavourOS", "Artix", "Antergos"
-    };
-    static const char *rpm_distros[] = {
-        "Fedora", "CentOS", "openSUSE", "Mageia", "AlmaLinux", "Rocky", "Red Hat", "RHEL", "Amazon Linux"
-    };
-    static const char *apk_distros[] = {"Alpine"};
-    static const char *xbps_distros[] = {"Void"};
-    static const char *portage_distros[] = {"Gentoo"};
-    static const char *eopkg_distros[] = {"Solus"};
-    static const char *nix_distros[] = {"NixOS"};
-    static const char *slack_distros[] = {"Slackware"};
-
-    if (strcmp(label, "dpkg") == 0) {
-        return distro_matches_any(distro, dpkg_distros, sizeof(dpkg_distros) / sizeof(dpkg_distros[0]));
-    }
-    if (strcmp(label, "pacman") == 0) {
-        return distro_matches_any(distro, pacman_distros, sizeof(pacman_distros) / sizeof(pacman_distros[0]));
-    }
-    if (strcmp(label, "rpm") == 0) {
-        return distro_matches_any(distro, rpm_distros, sizeof(rpm_distros) / sizeof(rpm_distros[0]));
-    }
-    if (strcmp(label, "apk") == 0) {
-        return distro_matches_any(distro, apk_distros, sizeof(apk_distros) / sizeof(apk_distros[0]));
-    }
-    if (strcmp(label, "xbps") == 0) {
-        return distro_matches_any(distro, xbps_distros, sizeof(xbps_distros) / sizeof(xbps_distros[0]));
-    }
-    if (strcmp(label, "portage") == 0) {
-        return distro_matches_any(distro, portage_distros, sizeof(portage_distros) / sizeof(portage_distros[0]));
-    }
-    if (strcmp(label, "eopkg") == 0) {
-        return distro_matches_any(distro, eopkg_distros, sizeof(eopkg_distros) / sizeof(eopkg_distros[0]));
-    }
-    if (strcmp(label, "nix") == 0) {
-        return distro_matches_any(distro, nix_distros, sizeof(nix_distros) / sizeof(nix_distros[0]));
-    }
-    if (strcmp(label, "slackpkg") == 0) {
-        return distro_matches_any(distro, slack_distros, sizeof(slack_distros) / sizeof(slack_distros[0]));
+// Marks the managers native to this system's families. Returns false when
+// none is known (no os-release, or an ID with no known family), in which
+// case every manager is probed.
+static bool plan_native_managers(
+    const struct cf_os_release *os,
+    const struct cf_distro_def *named,
+    const package_manager_probe *managers,
+    size_t manager_count,
+    bool *native_out
+) {
+    bool any = false;
+    for (size_t i = 0; i < manager_count; i++) {
+        native_out[i] = false;
+        for (size_t f = 0; f < sizeof(native_managers) / sizeof(native_managers[0]); f++) {
+            if (strcmp(native_managers[f].label, managers[i].label) != 0) continue;
+            if (!family_matches(native_managers[f].family, os, named)) continue;
+            native_out[i] = true;
+            any = true;
+            break;
+        }
     }
-
-    return false;
+    return any;
 }
 
 static const char *manager_label_from_command(const char *command) {
@@ -257,7 +241,7 @@ static bool append_labeled_count(char *out, size_t out_size, unsigned long count
     return true;
 }
 
-void get_package_count() {
+void get_package_count(struct cf_context *ctx, struct cf_sink *sink) {
 #ifdef _WIN32
     static const package_manager_probe win_pkg_managers[] = {
         {"winget", "winget", NULL, "winget list 2>nul"},
@@ -278,18 +262,16 @@ void get_package_count() {
     }
 
     if (appended_any) {
-        print_info("Package Count", "%s", 20, 30, output);
+        print_info(sink, "Package Count", "%s", 20, 30, output);
     }
     return;
 #else
-    const char* package_command = NULL;
-    const char* distro = detect_linux_distro();
-
-    #define DISTRO(shortname, longname, pkgcmd) else if(strcmp(distro, longname) == 0) {\
-        package_command = pkgcmd;}
-
-    if (0) {}
-    #include "../../../data/distros.def"
+    const char* distro = detect_linux_distro(ctx);
+    const struct cf_distro_def *distro_def = cf_distro_by_name(distro);
+    const char* package_command = distro_def ? distro_def->pkgcmd : NULL;
+    // The host's own os-release even under --force-distro: the packages
+    // are counted on this machine, whatever name the panel shows.
+    const struct cf_os_release *os = get_os_release();
 
     static const package_manager_probe pkg_managers[] = {
         {"pacman", "pacman", count_pacman_local, "pacman -Qq 2>/dev/null"},
@@ -307,14 +289,17 @@ void get_package_count() {
         {"paru", "paru", NULL, "paru -Qm 2>/dev/null"},
     };
 
+    enum { NUM_MANAGERS = sizeof(pkg_managers) / sizeof(pkg_managers[0]) };
     char output[256] = "";
     char cmd_output[128] = "";
     char used_labels[16][24] = {{0}};
     size_t used_label_count = 0;
     bool appended_any = false;
+    bool native[NUM_MANAGERS];
+    bool planned = plan_native_managers(os, distro_def, pkg_managers, NUM_MANAGERS, native);
 
-    for (size_t i = 0; i < sizeof(pkg_managers) / sizeof(pkg_managers[0]); i++) {
-        if (!distro_prefers_manager(distro, pkg_managers[i].label)) continue;
+    for (size_t i = 0; i < NUM_MANAGERS; i++) {
+        if (!native[i]) continue;
         if (label_already_used(pkg_managers[i].label, used_labels, used_label_count)) continue;
         if (!cf_executable_in_path(pkg_managers[i].binary) && pkg_managers[i].count_fn == NULL) continue;
 
@@ -327,7 +312,7 @@ void get_package_count() {
         }
     }
 
-    if (!appended_any && package_command != NULL && package_command[0] != '\0' && !is_shell_heavy_command(package_command)) {
+    if (!appended_any && package_command != NULL && package_command[0] != '\0' && !cf_command_needs_shell(package_command)) {
         if (cf_run_command_first_line(package_command, cmd_output, sizeof(cmd_output))) {
             unsigned long count = 0;
             if (parse_count(cmd_output, &count) && count > 0) {
@@ -340,12 +325,38 @@ void get_package_count() {
         }
     }
 
-    for (size_t i = 0; i < sizeof(pkg_managers) / sizeof(pkg_managers[0]); i++) {
+    // The remaining managers are counted together: in-process counters
+    // first, then every fallback command still needed, run in parallel.
+    // With a known family that is only its own managers plus snap/flatpak,
+    // unless none of those had a count: then the plan was wrong and every
+    // manager gets a probe.
+    if (!appended_any) planned = false;
+    unsigned long counts[NUM_MANAGERS] = {0};
+    struct cf_command runs[NUM_MANAGERS];
+    size_t run_owners[NUM_MANAGERS];
+    size_t run_count = 0;
+
+    for (size_t i = 0; i < NUM_MANAGERS; i++) {
+        if (planned && !native[i] && !is_universal_manager(pkg_managers[i].label)) continue;
         if (label_already_used(pkg_managers[i].label, used_labels, used_label_count)) continue;
-        if (!cf_executable_in_path(pkg_managers[i].binary) && pkg_managers[i].count_fn == NULL) continue;
+        bool installed = cf_executable_in_path(pkg_managers[i].binary);
+        if (!installed && pkg_managers[i].count_fn == NULL) continue;
+        if (pkg_managers[i].count_fn && pkg_managers[i].count_fn(&counts[i])) continue;
 
-        unsigned long count = 0;
-        if (!run_manager_probe(&pkg_managers[i], &count) || count == 0) continue;
+        if (installed && pkg_managers[i].fallback_command && pkg_managers[i].fallback_command[0]) {
+            init_line_count_command(&runs[run_count], pkg_managers[i].fallback_command);
+            run_owners[run_count++] = i;
+        }
+    }
+
+    cf_run_commands(runs, run_count);
+    for (size_t r = 0; r < run_count; r++) {
+        if (runs[r].exit_status >= 0) counts[run_owners[r]] = runs[r].lines;
+    }
+
+    for (size_t i = 0; i < NUM_MANAGERS; i++) {
+        unsigned long count = counts[i];
+        if (count == 0) continue;
 
         if (append_labeled_count(output, sizeof(output), count, pkg_managers[i].label)) {
             remember_label(pkg_managers[i].label, used_labels, &used_label_count, sizeof(used_labels) / sizeof(used_labels[0]));
@@ -354,7 +365,7 @@ void get_package_count() {
     }
 
     if (appended_any) {
-        print_info("Package Count", "%s", 20, 30, output);
+        print_info(sink, "Package Count", "%s", 20, 30, output);
     }
 #endif
 }
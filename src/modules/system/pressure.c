@@ -0,0 +1,97 @@
+#include "../../cupidfetch.h"
+#include "../common/module_helpers.h"
+
+#ifndef _WIN32
+struct psi_pair {
+    bool valid;
+    double avg10;
+    double avg60;
+};
+
+static struct psi_pair read_psi_file(const char *path) {
+    struct psi_pair psi = {false, 0.0, 0.0};
+    char text[256];
+
+    if (cf_read_file(path, text, sizeof(text)) <= 0) return psi;
+    psi.valid = cf_parse_psi_line(text, "some", &psi.avg10, &psi.avg60);
+    return psi;
+}
+
+static void append_psi_item(char *dest, size_t dest_size, const char *label, struct psi_pair psi) {
+    if (!psi.valid) return;
+
+    char item[64];
+    snprintf(item, sizeof(item), "%s %.2f/%.2f%%", label, psi.avg10, psi.avg60);
+
+    size_t len = strlen(dest);
+    if (len > 0 && len + 1 < dest_size) {
+        dest[len++] = ' ';
+        dest[len] = '\0';
+    }
+    strncat(dest, item, dest_size - len - 1);
+}
+
+static bool build_pressure_summary(
+    const char *cpu_path,
+    const char *memory_path,
+    const char *io_path,
+    char *out,
+    size_t out_size
+) {
+    out[0] = '\0';
+    append_psi_item(out, out_size, "cpu", read_psi_file(cpu_path));
+    append_psi_item(out, out_size, "mem", read_psi_file(memory_path));
+    append_psi_item(out, out_size, "io", read_psi_file(io_path));
+    return out[0] != '\0';
+}
+#endif
+
+void get_pressure(struct cf_context *ctx, struct cf_sink *sink) {
+#ifdef _WIN32
+    return;
+#else
+    char loadavg_text[128];
+    double load1 = 0.0, load5 = 0.0, load15 = 0.0;
+    bool have_load = cf_read_file("/proc/loadavg", loadavg_text, sizeof(loadavg_text)) > 0 &&
+                     sscanf(loadavg_text, "%lf %lf %lf", &load1, &load5, &load15) == 3;
+
+    // PSI "some" lines: share of wall time at least one task was stalled,
+    // reported here as avg10/avg60.
+    char system_psi[192];
+    bool have_psi = build_pressure_summary(
+        "/proc/pressure/cpu",
+        "/proc/pressure/memory",
+        "/proc/pressure/io",
+        system_psi,
+        sizeof(system_psi)
+    );
+
+    if (have_load && have_psi) {
+        print_info(sink, "Pressure", "load %.2f %.2f %.2f | %s", 20, 30, load1, load5, load15, system_psi);
+    } else if (have_load) {
+        print_info(sink, "Pressure", "load %.2f %.2f %.2f", 20, 30, load1, load5, load15);
+    } else if (have_psi) {
+        print_info(sink, "Pressure", "%s", 20, 30, system_psi);
+    } else {
+        return;
+    }
+
+    char cgroup_dir[512];
+    bool cgroup_is_root = true;
+    if (!cf_resolve_cgroup_v2_dir(cgroup_dir, sizeof(cgroup_dir), &cgroup_is_root) || cgroup_is_root) {
+        return;
+    }
+
+    char cpu_path[640];
+    char memory_path[640];
+    char io_path[640];
+    snprintf(cpu_path, sizeof(cpu_path), "%s/cpu.pressure", cgroup_dir);
+    snprintf(memory_path, sizeof(memory_path), "%s/memory.pressure", cgroup_dir);
+    snprintf(io_path, sizeof(io_path), "%s/io.pressure", cgroup_dir);
+
+    char cgroup_psi[192];
+    if (build_pressure_summary(cpu_path, memory_path, io_path, cgroup_psi, sizeof(cgroup_psi))) {
+        print_info(sink, "", "cgroup %s", 20, 30, cgroup_psi);
+    }
+#endif
+}
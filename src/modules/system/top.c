@@ -0,0 +1,139 @@
+#include "../../cupidfetch.h"
+#include "../common/module_helpers.h"
+
+#ifndef _WIN32
+#define TOP_BATCH_PIDS 64
+
+struct top_scan {
+    struct cf_top_heap by_rss;
+    struct cf_top_heap by_cpu;
+    unsigned long long page_size;
+    struct cf_read_ring *ring;
+    int proc_fd;
+    size_t pending;
+    long pids[TOP_BATCH_PIDS];
+    char paths[TOP_BATCH_PIDS][2][32];
+    char stat[TOP_BATCH_PIDS][1024];
+    char statm[TOP_BATCH_PIDS][128];
+    struct cf_read_request requests[TOP_BATCH_PIDS * 2];
+};
+
+// stat and statm of every queued pid go out as one batch read.
+static void flush_top_batch(struct top_scan *scan) {
+    if (scan->pending == 0) return;
+    cf_read_batch(scan->ring, scan->requests, scan->pending * 2);
+
+    for (size_t i = 0; i < scan->pending; i++) {
+        if (scan->requests[i * 2].result <= 0) continue;
+
+        struct cf_top_entry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.pid = scan->pids[i];
+
+        unsigned long long cpu_ticks = 0;
+        if (!cf_parse_proc_stat_line(scan->stat[i], entry.comm, sizeof(entry.comm), NULL, &cpu_ticks)) continue;
+
+        entry.value = cpu_ticks;
+        if (entry.value > 0) cf_top_heap_offer(&scan->by_cpu, &entry);
+
+        // statm: size resident shared ... (pages)
+        unsigned long long resident_pages = 0;
+        if (scan->requests[i * 2 + 1].result > 0 &&
+            sscanf(scan->statm[i], "%*s %llu", &resident_pages) == 1 && resident_pages > 0) {
+            entry.value = resident_pages * scan->page_size;
+            cf_top_heap_offer(&scan->by_rss, &entry);
+        }
+    }
+    scan->pending = 0;
+}
+
+static bool visit_top_pid(const char *pid, void *ctx) {
+    struct top_scan *scan = ctx;
+    size_t slot = scan->pending;
+
+    snprintf(scan->paths[slot][0], sizeof(scan->paths[slot][0]), "%s/stat", pid);
+    snprintf(scan->paths[slot][1], sizeof(scan->paths[slot][1]), "%s/statm", pid);
+    scan->pids[slot] = strtol(pid, NULL, 10);
+
+    struct cf_read_request *stat_req = &scan->requests[slot * 2];
+    stat_req->dirfd = scan->proc_fd;
+    stat_req->path = scan->paths[slot][0];
+    stat_req->buffer = scan->stat[slot];
+    stat_req->size = sizeof(scan->stat[slot]);
+
+    struct cf_read_request *statm_req = &scan->requests[slot * 2 + 1];
+    statm_req->dirfd = scan->proc_fd;
+    statm_req->path = scan->paths[slot][1];
+    statm_req->buffer = scan->statm[slot];
+    statm_req->size = sizeof(scan->statm[slot]);
+
+    if (++scan->pending == TOP_BATCH_PIDS) flush_top_batch(scan);
+    return false;
+}
+#endif
+
+void get_top(struct cf_context *ctx, struct cf_sink *sink) {
+#ifdef _WIN32
+    return;
+#else
+    struct cf_top_entry rss_storage[MAX_TOP_COUNT];
+    struct cf_top_entry cpu_storage[MAX_TOP_COUNT];
+    size_t count = ctx->config->top_count;
+    if (count == 0) return;
+    if (count > MAX_TOP_COUNT) count = MAX_TOP_COUNT;
+
+    // Around 80KB of batch buffers, so off the stack.
+    struct top_scan *scan = malloc(sizeof(*scan));
+    if (!scan) return;
+    scan->proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (scan->proc_fd < 0) {
+        free(scan);
+        return;
+    }
+    scan->ring = cf_ctx_read_ring(ctx);
+    scan->pending = 0;
+    cf_top_heap_init(&scan->by_rss, rss_storage, count);
+    cf_top_heap_init(&scan->by_cpu, cpu_storage, count);
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    scan->page_size = page_size > 0 ? (unsigned long long)page_size : 4096ULL;
+
+    // One pass over /proc; each heap holds at most `count` entries however
+    // many pids there are.
+    cf_for_each_pid(visit_top_pid, scan);
+    flush_top_batch(scan);
+    close(scan->proc_fd);
+
+    cf_top_heap_sort_desc(&scan->by_rss);
+    cf_top_heap_sort_desc(&scan->by_cpu);
+
+    for (size_t i = 0; i < scan->by_rss.count; i++) {
+        const struct cf_top_entry *entry = &scan->by_rss.entries[i];
+        cf_emit_line(sink, i == 0 ? "Top RSS" : "");
+        cf_emit_str(sink, "command", entry->comm);
+        cf_emit_str(sink, NULL, " ");
+        cf_emit_bytes(sink, "rss_bytes", entry->value, CF_BYTES_MEMORY);
+        cf_emit_str(sink, NULL, " (pid ");
+        cf_emit_u64(sink, "pid", (unsigned long long)entry->pid, NULL);
+        cf_emit_str(sink, NULL, ")");
+    }
+
+    long ticks_per_second = sysconf(_SC_CLK_TCK);
+    if (ticks_per_second <= 0) ticks_per_second = 100;
+
+    for (size_t i = 0; i < scan->by_cpu.count; i++) {
+        const struct cf_top_entry *entry = &scan->by_cpu.entries[i];
+        char duration[32];
+        cf_format_duration_compact((unsigned long)(entry->value / (unsigned long long)ticks_per_second),
+                                   duration, sizeof(duration));
+        cf_emit_line(sink, i == 0 ? "Top CPU" : "");
+        cf_emit_str(sink, "command", entry->comm);
+        cf_emit_str(sink, NULL, " ");
+        cf_emit_str(sink, "cpu_time", duration);
+        cf_emit_str(sink, NULL, " (pid ");
+        cf_emit_u64(sink, "pid", (unsigned long long)entry->pid, NULL);
+        cf_emit_str(sink, NULL, ")");
+    }
+    free(scan);
+#endif
+}
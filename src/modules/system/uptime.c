@@ -3,7 +3,7 @@
 #include <sys/sysinfo.h>
 #endif
 
-void get_uptime() {
+void get_uptime(struct cf_context *ctx, struct cf_sink *sink) {
 #ifdef _WIN32
     unsigned long long uptime_ms = GetTickCount64();
     unsigned long long uptime = uptime_ms / 1000ULL;
@@ -21,5 +21,5 @@ void get_uptime() {
     int hours = ((int)uptime % (60 * 60 * 24)) / (60 * 60);
     int minutes = ((int)uptime % (60 * 60)) / 60;
 
-    print_info("Uptime", "%d days, %02d:%02d", 20, 30, days, hours, minutes);
+    print_info(sink, "Uptime", "%d days, %02d:%02d", 20, 30, days, hours, minutes);
 }
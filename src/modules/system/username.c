@@ -1,30 +1,10 @@
 #include "../../cupidfetch.h"
 
-void get_username() {
-    const char *username = getenv("USER");
+void get_username(struct cf_context *ctx, struct cf_sink *sink) {
+    const char *username = cf_ctx_username(ctx);
 
-#ifdef _WIN32
-    if (username == NULL || username[0] == '\0') {
-        username = getenv("USERNAME");
-    }
-#else
-    if (username == NULL || username[0] == '\0') {
-        char *login_name = getlogin();
-        if (login_name != NULL && login_name[0] != '\0') {
-            username = login_name;
-        }
-    }
-
-    if (username == NULL || username[0] == '\0') {
-        struct passwd *pw = getpwuid(geteuid());
-        if (pw != NULL) {
-            username = pw->pw_name;
-        }
-    }
-#endif
-
-    if (username != NULL && username[0] != '\0')
-        print_info("Username", username, 20, 30);
+    if (username != NULL)
+        print_info(sink, "Username", username, 20, 30);
     else
         cupid_log(LogType_ERROR, "couldn't get username");
 }
@@ -1,64 +1,43 @@
 // File: print.c
 // -----------------------
 #include "cupidfetch.h"
-#include <locale.h>
-#include <wchar.h>
-
-#ifdef _WIN32
-static int wcwidth(wchar_t wc) {
-    if (wc == L'\0') return 0;
-    if (wc < 32 || (wc >= 0x7f && wc < 0xa0)) return 0;
-    return 1;
-}
-#else
-extern int wcwidth(wchar_t wc);
-#endif
-
-#define MAX_CAPTURE_LINES 256
-#define MAX_CAPTURE_LINE_LEN 512
-#define MAX_RENDER_LINES 1024
-
-static bool g_capture_info = false;
-static char g_info_lines[MAX_CAPTURE_LINES][MAX_CAPTURE_LINE_LEN];
-static size_t g_info_line_count = 0;
-static char g_info_keys[MAX_CAPTURE_LINES][64];
-static char g_info_values[MAX_CAPTURE_LINES][384];
-static size_t g_info_kv_count = 0;
-
-static void ensure_utf8_locale(void) {
-    static bool initialized = false;
-    if (!initialized) {
-        setlocale(LC_CTYPE, "");
-        initialized = true;
-    }
-}
-
-static int utf8_codepoint_width(const char *s, size_t max_len, size_t *consumed) {
-    if (!s || max_len == 0) {
-        if (consumed) *consumed = 0;
-        return 0;
-    }
-
-    mbstate_t state;
-    memset(&state, 0, sizeof(state));
-
-    wchar_t wc;
-    size_t read = mbrtowc(&wc, s, max_len, &state);
-    if (read == (size_t)-1 || read == (size_t)-2) {
-        if (consumed) *consumed = 1;
-        return 1;
-    }
-    if (read == 0) {
-        if (consumed) *consumed = 1;
-        return 0;
-    }
+#include "modules/common/module_helpers.h"
+#include <math.h>
+
+struct cf_entry {
+    const char *base;
+    const char *key;
+    const char *label;
+    int align_key;
+    char *text;
+    size_t text_len;
+    size_t text_cap;
+    size_t first_value;
+    size_t value_count;
+};
 
-    int width = wcwidth(wc);
-    if (width < 0) width = 0;
+// What the modules of one fetch reported, in order. Each fetch owns its
+// sink, so concurrent fetches never share capture buffers. Entries, values
+// and their strings all live in `arena`, rewound by cf_sink_reset(); named
+// values of every entry sit contiguously in `values`.
+struct cf_sink {
+    const struct CupidConfig *config;
+    struct cf_arena arena;
+    struct cf_entry *entries;
+    size_t count;
+    size_t entries_cap;
+    bool line_open;
+    struct cf_value *values;
+    size_t value_count;
+    size_t values_cap;
+};
 
-    if (consumed) *consumed = read;
-    return width;
-}
+// Lines built for one redraw, in that redraw's arena.
+struct line_list {
+    const char **lines;
+    size_t count;
+    size_t cap;
+};
 
 static size_t utf8_display_width(const char *s) {
     if (!s) return 0;
@@ -76,14 +55,12 @@ static size_t utf8_display_width(const char *s) {
         return len;
     }
 
-    ensure_utf8_locale();
-
     size_t width = 0;
     size_t pos = 0;
 
     while (pos < len) {
         size_t consumed = 0;
-        int cp_width = utf8_codepoint_width(s + pos, len - pos, &consumed);
+        int cp_width = cf_utf8_char_width(s + pos, len - pos, &consumed);
         if (consumed == 0) break;
         width += (size_t)cp_width;
         pos += consumed;
@@ -108,14 +85,12 @@ static size_t utf8_nbytes_for_columns(const char *s, size_t max_columns) {
         return len < max_columns ? len : max_columns;
     }
 
-    ensure_utf8_locale();
-
     size_t pos = 0;
     size_t used_columns = 0;
 
     while (pos < len) {
         size_t consumed = 0;
-        int cp_width = utf8_codepoint_width(s + pos, len - pos, &consumed);
+        int cp_width = cf_utf8_char_width(s + pos, len - pos, &consumed);
         if (consumed == 0) break;
 
         size_t cpw = (size_t)cp_width;
@@ -216,8 +191,6 @@ static size_t utf8_nbytes_for_column_range(const char *s, size_t start_col, size
         return bytes;
     }
 
-    ensure_utf8_locale();
-
     size_t pos = 0;
     size_t col = 0;
     bool started = false;
@@ -227,7 +200,7 @@ static size_t utf8_nbytes_for_column_range(const char *s, size_t start_col, size
 
     while (pos < len) {
         size_t consumed = 0;
-        int cp_width = utf8_codepoint_width(s + pos, len - pos, &consumed);
+        int cp_width = cf_utf8_char_width(s + pos, len - pos, &consumed);
         if (consumed == 0) break;
 
         size_t cpw = (size_t)cp_width;
@@ -332,7 +305,7 @@ static bool env_falsey(const char *value) {
            strcasecmp(value, "off") == 0;
 }
 
-static bool should_use_color(void) {
+static bool should_use_color(FILE *out) {
     const char *force_color = getenv("FORCE_COLOR");
     if (force_color && !env_falsey(force_color)) {
         return true;
@@ -353,7 +326,7 @@ static bool should_use_color(void) {
         return false;
     }
 
-    if (!isatty(STDOUT_FILENO)) {
+    if (!isatty(fileno(out))) {
         return false;
     }
 
@@ -402,46 +375,46 @@ static void make_json_key(const char *label, char *out, size_t out_size) {
     out[j] = '\0';
 }
 
-static void print_json_escaped(const char *value) {
+static void print_json_escaped(FILE *out, const char *value) {
     if (!value) {
-        printf("\"\"");
+        fprintf(out, "\"\"");
         return;
     }
 
-    putchar('"');
+    fputc('"', out);
     for (const unsigned char *p = (const unsigned char *)value; *p; p++) {
         switch (*p) {
             case '"':
-                printf("\\\"");
+                fprintf(out, "\\\"");
                 break;
             case '\\':
-                printf("\\\\");
+                fprintf(out, "\\\\");
                 break;
             case '\b':
-                printf("\\b");
+                fprintf(out, "\\b");
                 break;
             case '\f':
-                printf("\\f");
+                fprintf(out, "\\f");
                 break;
             case '\n':
-                printf("\\n");
+                fprintf(out, "\\n");
                 break;
             case '\r':
-                printf("\\r");
+                fprintf(out, "\\r");
                 break;
             case '\t':
-                printf("\\t");
+                fprintf(out, "\\t");
                 break;
             default:
                 if (*p < 0x20) {
-                    printf("\\u%04x", *p);
+                    fprintf(out, "\\u%04x", *p);
                 } else {
-                    putchar(*p);
+                    fputc(*p, out);
                 }
                 break;
         }
     }
-    putchar('"');
+    fputc('"', out);
 }
 
 struct DistroLogo {
@@ -555,8 +528,8 @@ static const char *resolve_distro_logo_alias(const char *name) {
     return name;
 }
 
-static bool terminal_supports_truecolor(void) {
-    if (!should_use_color()) return false;
+static bool terminal_supports_truecolor(FILE *out) {
+    if (!should_use_color(out)) return false;
 
     const char *ct = getenv("COLORTERM");
     if (!ct) return false;
@@ -572,6 +545,7 @@ static int rgb_to_ansi256(unsigned char r, unsigned char g, unsigned char b) {
 }
 
 static void print_logo_lines(
+    FILE *out,
     const char *const *lines,
     size_t line_count,
     bool color_enabled,
@@ -584,20 +558,21 @@ static void print_logo_lines(
 
     for (size_t i = 0; i < line_count; i++) {
         if (!color_enabled) {
-            printf("%s\n", lines[i]);
+            fprintf(out, "%s\n", lines[i]);
             continue;
         }
 
         if (use_truecolor) {
-            printf("\033[38;2;%u;%u;%um%s\033[0m\n", (unsigned)r, (unsigned)g, (unsigned)b, lines[i]);
+            fprintf(out, "\033[38;2;%u;%u;%um%s\033[0m\n", (unsigned)r, (unsigned)g, (unsigned)b, lines[i]);
         } else {
             int color_256 = rgb_to_ansi256(r, g, b);
-            printf("\033[38;5;%dm%s\033[0m\n", color_256, lines[i]);
+            fprintf(out, "\033[38;5;%dm%s\033[0m\n", color_256, lines[i]);
         }
     }
 }
 
 static void print_logo_line_inline(
+    FILE *out,
     const char *line,
     bool color_enabled,
     bool use_truecolor,
@@ -608,19 +583,20 @@ static void print_logo_line_inline(
     if (!line) return;
 
     if (!color_enabled) {
-        printf("%s", line);
+        fprintf(out, "%s", line);
         return;
     }
 
     if (use_truecolor) {
-        printf("\033[38;2;%u;%u;%um%s\033[0m", (unsigned)r, (unsigned)g, (unsigned)b, line);
+        fprintf(out, "\033[38;2;%u;%u;%um%s\033[0m", (unsigned)r, (unsigned)g, (unsigned)b, line);
     } else {
         int color_256 = rgb_to_ansi256(r, g, b);
-        printf("\033[38;5;%dm%s\033[0m", color_256, line);
+        fprintf(out, "\033[38;5;%dm%s\033[0m", color_256, line);
     }
 }
 
 static void print_info_line_inline(
+    FILE *out,
     const char *line,
     bool color_enabled,
     bool use_truecolor,
@@ -631,13 +607,13 @@ static void print_info_line_inline(
     if (!line) return;
 
     if (!color_enabled) {
-        printf("%s", line);
+        fprintf(out, "%s", line);
         return;
     }
 
     const char *sep = strstr(line, ": ");
     if (!sep) {
-        printf("%s", line);
+        fprintf(out, "%s", line);
         return;
     }
 
@@ -645,9 +621,9 @@ static void print_info_line_inline(
     const char *rest = sep;
 
     if (use_truecolor) {
-        printf("\033[38;2;%u;%u;%um%.*s\033[0m%s", (unsigned)r, (unsigned)g, (unsigned)b, (int)key_len, line, rest);
+        fprintf(out, "\033[38;2;%u;%u;%um%.*s\033[0m%s", (unsigned)r, (unsigned)g, (unsigned)b, (int)key_len, line, rest);
     } else {
-        printf("\033[1;36m%.*s\033[0m%s", (int)key_len, line, rest);
+        fprintf(out, "\033[1;36m%.*s\033[0m%s", (int)key_len, line, rest);
     }
 }
 
@@ -672,6 +648,19 @@ static void make_palette_row(int base, char *out, size_t out_size) {
     }
 }
 
+static bool line_list_push(struct cf_arena *arena, struct line_list *list, const char *line) {
+    if (!line) return false;
+    if (list->count == list->cap) {
+        size_t cap = list->cap ? list->cap * 2 : 64;
+        const char **grown = cf_arena_grow(arena, list->lines, list->cap * sizeof(*grown), cap * sizeof(*grown));
+        if (!grown) return false;
+        list->lines = grown;
+        list->cap = cap;
+    }
+    list->lines[list->count++] = line;
+    return true;
+}
+
 static void scale_ascii_line(
     const char *line,
     size_t keep_num,
@@ -698,7 +687,7 @@ static void scale_ascii_line(
     size_t cp_index = 0;
     while (pos < len && j + 1 < out_size) {
         size_t consumed = 0;
-        (void)utf8_codepoint_width(line + pos, len - pos, &consumed);
+        (void)cf_utf8_char_width(line + pos, len - pos, &consumed);
         if (consumed == 0) break;
 
         size_t repeat = scale_repeat_for_index(cp_index, keep_num, keep_den);
@@ -722,17 +711,14 @@ static void scale_ascii_line(
     }
 }
 
-static size_t build_scaled_logo_lines(
+static void build_scaled_logo_lines(
+    struct cf_arena *arena,
     const struct DistroLogo *logo,
     size_t scale_num,
     size_t scale_den,
-    char out_storage[][MAX_CAPTURE_LINE_LEN],
-    const char *out_lines[],
-    size_t out_cap
+    struct line_list *out
 ) {
-    if (!logo || !logo->lines || logo->line_count == 0 || !out_storage || !out_lines || out_cap == 0) {
-        return 0;
-    }
+    if (!logo || !logo->lines || logo->line_count == 0 || !out) return;
 
     size_t keep_num = scale_num;
     size_t keep_den = scale_den;
@@ -740,30 +726,27 @@ static size_t build_scaled_logo_lines(
         keep_num = 1;
         keep_den = 1;
     }
+    // No code point is repeated more often than this across a line.
+    size_t max_repeat = (keep_num + keep_den - 1) / keep_den;
 
-    size_t count = 0;
-    for (size_t i = 0; i < logo->line_count && count < out_cap; i++) {
+    for (size_t i = 0; i < logo->line_count; i++) {
         size_t copies = scale_repeat_for_index(i, keep_num, keep_den);
-        for (size_t copy = 0; copy < copies && count < out_cap; copy++) {
-            scale_ascii_line(
-                logo->lines[i],
-                keep_num,
-                keep_den,
-                out_storage[count],
-                MAX_CAPTURE_LINE_LEN
-            );
-            out_lines[count] = out_storage[count];
-            count++;
+        size_t size = strlen(logo->lines[i]) * max_repeat + 1;
+        for (size_t copy = 0; copy < copies; copy++) {
+            char *line = cf_arena_alloc(arena, size);
+            if (!line) return;
+            scale_ascii_line(logo->lines[i], keep_num, keep_den, line, size);
+            if (!line_list_push(arena, out, line)) return;
         }
     }
 
-    if (count == 0 && logo->line_count > 0) {
-        scale_ascii_line(logo->lines[0], keep_num, keep_den, out_storage[0], MAX_CAPTURE_LINE_LEN);
-        out_lines[0] = out_storage[0];
-        count = 1;
+    if (out->count == 0) {
+        size_t size = strlen(logo->lines[0]) * max_repeat + 1;
+        char *line = cf_arena_alloc(arena, size);
+        if (!line) return;
+        scale_ascii_line(logo->lines[0], keep_num, keep_den, line, size);
+        line_list_push(arena, out, line);
     }
-
-    return count;
 }
 
 static size_t line_array_max_width(const char *const *lines, size_t line_count);
@@ -844,28 +827,22 @@ static size_t line_array_max_width(const char *const *lines, size_t line_count)
 }
 
 static void append_wrapped_line(
+    struct cf_arena *arena,
     const char *text,
     size_t width,
-    char out_lines[][MAX_CAPTURE_LINE_LEN],
-    size_t *out_count,
-    size_t out_cap
+    struct line_list *out
 ) {
-    if (!text || !out_count || width == 0) return;
-
-    ensure_utf8_locale();
+    if (!text || !out || width == 0) return;
 
     size_t len = strlen(text);
     size_t pos = 0;
 
     if (len == 0) {
-        if (*out_count < out_cap) {
-            out_lines[*out_count][0] = '\0';
-            (*out_count)++;
-        }
+        line_list_push(arena, out, "");
         return;
     }
 
-    while (pos < len && *out_count < out_cap) {
+    while (pos < len) {
         size_t remaining = len - pos;
         size_t chunk = utf8_nbytes_for_columns(text + pos, width);
         if (chunk == 0 && remaining > 0) {
@@ -886,16 +863,10 @@ static void append_wrapped_line(
             }
         }
 
-        size_t copy_len = split < (MAX_CAPTURE_LINE_LEN - 1) ? split : (MAX_CAPTURE_LINE_LEN - 1);
-        memcpy(out_lines[*out_count], text + pos, copy_len);
-        out_lines[*out_count][copy_len] = '\0';
-
-        while (copy_len > 0 && out_lines[*out_count][copy_len - 1] == ' ') {
-            out_lines[*out_count][copy_len - 1] = '\0';
-            copy_len--;
-        }
+        size_t copy_len = split;
+        while (copy_len > 0 && text[pos + copy_len - 1] == ' ') copy_len--;
+        if (!line_list_push(arena, out, cf_arena_strndup(arena, text + pos, copy_len))) return;
 
-        (*out_count)++;
         pos += split;
         while (pos < len) {
             unsigned char c = (unsigned char)text[pos];
@@ -908,7 +879,7 @@ static void append_wrapped_line(
     }
 }
 
-static const struct DistroLogo *find_logo_for_distro(const char *distro);
+static const struct DistroLogo *find_logo_for_distro(struct cf_context *ctx, const char *distro);
 
 static const char *const logo_ubuntu[] = {
     "            .-/+oossssoo+\\-.",
@@ -1569,13 +1540,36 @@ static const struct DistroLogo logos[] = {
     {"Windows", logo_windows, sizeof(logo_windows) / sizeof(logo_windows[0]), 0, 120, 212},
 };
 
-static const struct DistroLogo *find_logo_for_distro(const char *distro) {
-    if (distro && distro[0]) {
-        const char *lookup = resolve_distro_logo_alias(distro);
-        for (size_t i = 0; i < sizeof(logos) / sizeof(logos[0]); i++) {
-            if (eq_icase(lookup, logos[i].name)) {
-                return &logos[i];
+static const struct DistroLogo *find_named_logo(const char *name) {
+    if (!name || !name[0]) return NULL;
+
+    const char *lookup = resolve_distro_logo_alias(name);
+    for (size_t i = 0; i < sizeof(logos) / sizeof(logos[0]); i++) {
+        if (eq_icase(lookup, logos[i].name)) {
+            return &logos[i];
+        }
+    }
+    return NULL;
+}
+
+static const struct DistroLogo *find_logo_for_distro(struct cf_context *ctx, const char *distro) {
+    const struct DistroLogo *logo = find_named_logo(distro);
+    if (logo) return logo;
+
+    // A derivative without its own logo borrows its parent's, in ID_LIKE
+    // order.
+    const struct cf_os_release *os = ctx ? cf_ctx_os_release(ctx) : get_os_release();
+    if (os) {
+        for (const char *word = os->id_like; *word; ) {
+            while (*word == ' ') word++;
+            size_t len = strcspn(word, " ");
+            char family[64];
+            if (len > 0 && len < sizeof(family)) {
+                memcpy(family, word, len);
+                family[len] = '\0';
+                if ((logo = find_named_logo(family)) != NULL) return logo;
             }
+            word += len;
         }
     }
 
@@ -1591,90 +1585,157 @@ static const struct DistroLogo *find_logo_for_distro(const char *distro) {
     return &fallback_logo;
 }
 
-int get_terminal_width() {
+// Columns and rows of the terminal on stdout, 0 when it reports none.
+void get_terminal_size(int *cols_out, int *rows_out) {
+    int cols = 0;
+    int rows = 0;
 #ifdef _WIN32
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
     if (h != INVALID_HANDLE_VALUE && GetConsoleScreenBufferInfo(h, &csbi)) {
-        return (int)(csbi.srWindow.Right - csbi.srWindow.Left + 1);
+        cols = (int)(csbi.srWindow.Right - csbi.srWindow.Left + 1);
+        rows = (int)(csbi.srWindow.Bottom - csbi.srWindow.Top + 1);
     }
-    return 80;
 #else
     struct winsize w;
-    // FIXME: no error handling
-    ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
-    return w.ws_col;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == 0) {
+        cols = w.ws_col;
+        rows = w.ws_row;
+    }
 #endif
+    if (cols_out) *cols_out = cols;
+    if (rows_out) *rows_out = rows;
 }
 
-static int get_terminal_height() {
-#ifdef _WIN32
-    CONSOLE_SCREEN_BUFFER_INFO csbi;
-    HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
-    if (h != INVALID_HANDLE_VALUE && GetConsoleScreenBufferInfo(h, &csbi)) {
-        return (int)(csbi.srWindow.Bottom - csbi.srWindow.Top + 1);
-    }
-    return 24;
-#else
-    struct winsize w;
-    // FIXME: no error handling
-    ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
-    return w.ws_row;
-#endif
+int get_terminal_width() {
+    int cols = 0;
+    get_terminal_size(&cols, NULL);
+    return cols;
 }
 
-void print_info(const char *key, const char *format, int align_key, int align_value, ...) {
-    (void)align_value;
+// JSON keys repeat when a module reports several lines under one label
+// ("gpu", "gpu_2", ...); the suffix is the occurrence count so far.
+static void make_unique_key(const struct cf_sink *sink, const char *base, char *out, size_t out_size) {
+    size_t occurrence = 1;
+    for (size_t i = 0; i < sink->count; i++) {
+        if (strcmp(sink->entries[i].base, base) == 0) occurrence++;
+    }
 
-    va_list args;
-    va_start(args, align_value);
+    if (occurrence == 1) {
+        snprintf(out, out_size, "%s", base);
+        return;
+    }
 
-    if (g_capture_info) {
-        char value_buffer[384];
-        char line_buffer[MAX_CAPTURE_LINE_LEN];
-        char key_buffer[64];
-        char aligned_key[128];
+    char suffix_num[32];
+    snprintf(suffix_num, sizeof(suffix_num), "%zu", occurrence);
+    size_t suffix_len = strlen(suffix_num);
+    size_t max_key_len = 0;
+    if (suffix_len + 1 < out_size) {
+        max_key_len = out_size - suffix_len - 2;
+    }
+    snprintf(out, out_size, "%.*s_%s", (int)max_key_len, base, suffix_num);
+}
 
-        vsnprintf(value_buffer, sizeof(value_buffer), format, args);
-        format_aligned_key(key, align_key, aligned_key, sizeof(aligned_key));
-        size_t line_cap = sizeof(line_buffer);
-        size_t prefix_len = strlen(aligned_key);
+static void start_line(struct cf_sink *sink, const char *label, int align_key) {
+    sink->line_open = false;
+    if (sink->count == sink->entries_cap) {
+        size_t cap = sink->entries_cap ? sink->entries_cap * 2 : 32;
+        struct cf_entry *grown = cf_arena_grow(&sink->arena, sink->entries, sink->entries_cap * sizeof(*grown),
+                                               cap * sizeof(*grown));
+        if (!grown) return;
+        sink->entries = grown;
+        sink->entries_cap = cap;
+    }
+
+    // A continuation line ("" label) stays under the previous line's key.
+    char base[64];
+    char key[64];
+    make_json_key(label, base, sizeof(base));
+    if (strcmp(base, "unknown") == 0 && sink->count > 0) {
+        snprintf(base, sizeof(base), "%s", sink->entries[sink->count - 1].base);
+    }
+    make_unique_key(sink, base, key, sizeof(key));
+
+    struct cf_entry *entry = &sink->entries[sink->count];
+    memset(entry, 0, sizeof(*entry));
+    entry->base = cf_arena_strdup(&sink->arena, base);
+    entry->key = cf_arena_strdup(&sink->arena, key);
+    entry->label = cf_arena_strdup(&sink->arena, label);
+    entry->text = cf_arena_alloc(&sink->arena, 64);
+    if (!entry->base || !entry->key || !entry->label || !entry->text) return;
+    entry->text[0] = '\0';
+    entry->text_cap = 64;
+    entry->align_key = align_key;
+    entry->first_value = sink->value_count;
+    sink->count++;
+    sink->line_open = true;
+}
 
-        if (prefix_len + 2 >= line_cap) {
-            prefix_len = line_cap - 3;
-        }
+static struct cf_entry *open_entry(struct cf_sink *sink) {
+    if (!sink || !sink->line_open || sink->count == 0) return NULL;
+    return &sink->entries[sink->count - 1];
+}
 
-        memcpy(line_buffer, aligned_key, prefix_len);
-        line_buffer[prefix_len] = ':';
-        line_buffer[prefix_len + 1] = ' ';
+static void append_text(struct cf_sink *sink, const char *text) {
+    struct cf_entry *entry = open_entry(sink);
+    if (!entry || !text) return;
 
-        size_t available = line_cap - (prefix_len + 2);
-        size_t value_len = strnlen(value_buffer, available > 0 ? (available - 1) : 0);
-        if (available > 0 && value_len > 0) {
-            memcpy(line_buffer + prefix_len + 2, value_buffer, value_len);
-        }
-        line_buffer[prefix_len + 2 + value_len] = '\0';
-        make_json_key(key, key_buffer, sizeof(key_buffer));
-        if (key_buffer[0] == '\0' || strcmp(key_buffer, "unknown") == 0) {
-            if (g_info_kv_count > 0 && g_info_keys[g_info_kv_count - 1][0] != '\0') {
-                strncpy(key_buffer, g_info_keys[g_info_kv_count - 1], sizeof(key_buffer) - 1);
-                key_buffer[sizeof(key_buffer) - 1] = '\0';
-            }
-        }
+    size_t len = strlen(text);
+    if (entry->text_len + len + 1 > entry->text_cap) {
+        size_t cap = entry->text_cap * 2;
+        while (cap < entry->text_len + len + 1) cap *= 2;
+        char *grown = cf_arena_grow(&sink->arena, entry->text, entry->text_cap, cap);
+        if (!grown) return;
+        entry->text = grown;
+        entry->text_cap = cap;
+    }
+    memcpy(entry->text + entry->text_len, text, len + 1);
+    entry->text_len += len;
+}
 
-        if (g_info_line_count < MAX_CAPTURE_LINES) {
-            strncpy(g_info_lines[g_info_line_count], line_buffer, MAX_CAPTURE_LINE_LEN - 1);
-            g_info_lines[g_info_line_count][MAX_CAPTURE_LINE_LEN - 1] = '\0';
-            g_info_line_count++;
-        }
+// NULL for a text-only value (no name) or when the arena is exhausted.
+static struct cf_value *add_value(struct cf_sink *sink, enum cf_value_type type, const char *name) {
+    struct cf_entry *entry = open_entry(sink);
+    if (!entry || !name || !name[0]) return NULL;
+
+    if (sink->value_count == sink->values_cap) {
+        size_t cap = sink->values_cap ? sink->values_cap * 2 : 64;
+        struct cf_value *grown = cf_arena_grow(&sink->arena, sink->values, sink->values_cap * sizeof(*grown),
+                                               cap * sizeof(*grown));
+        if (!grown) return NULL;
+        sink->values = grown;
+        sink->values_cap = cap;
+    }
+
+    const char *stored_name = cf_arena_strdup(&sink->arena, name);
+    if (!stored_name) return NULL;
+    struct cf_value *value = &sink->values[sink->value_count++];
+    memset(value, 0, sizeof(*value));
+    value->type = type;
+    value->name = stored_name;
+    value->unit = "";
+    value->text = "";
+    entry->value_count++;
+    return value;
+}
+
+void print_info(struct cf_sink *sink, const char *key, const char *format, int align_key, int align_value, ...) {
+    (void)align_value;
 
-        if (g_info_kv_count < MAX_CAPTURE_LINES) {
-            strncpy(g_info_keys[g_info_kv_count], key_buffer, sizeof(g_info_keys[g_info_kv_count]) - 1);
-            g_info_keys[g_info_kv_count][sizeof(g_info_keys[g_info_kv_count]) - 1] = '\0';
+    va_list args;
+    va_start(args, align_value);
 
-            strncpy(g_info_values[g_info_kv_count], value_buffer, sizeof(g_info_values[g_info_kv_count]) - 1);
-            g_info_values[g_info_kv_count][sizeof(g_info_values[g_info_kv_count]) - 1] = '\0';
-            g_info_kv_count++;
+    if (sink) {
+        va_list measure;
+        va_copy(measure, args);
+        int len = vsnprintf(NULL, 0, format, measure);
+        va_end(measure);
+
+        start_line(sink, key, align_key);
+        char *value = len >= 0 ? cf_arena_alloc(&sink->arena, (size_t)len + 1) : NULL;
+        if (value) {
+            vsnprintf(value, (size_t)len + 1, format, args);
+            append_text(sink, value);
         }
     } else {
         char aligned_key[128];
@@ -1687,97 +1748,180 @@ void print_info(const char *key, const char *format, int align_key, int align_va
     va_end(args);
 }
 
-void begin_info_capture(void) {
-    g_capture_info = true;
-    g_info_line_count = 0;
-    g_info_kv_count = 0;
+void cf_emit_line(struct cf_sink *sink, const char *label) {
+    if (sink) start_line(sink, label, 20);
 }
 
-void end_info_capture(void) {
-    g_capture_info = false;
+void cf_emit_str(struct cf_sink *sink, const char *name, const char *text) {
+    if (!text) text = "";
+    struct cf_value *value = add_value(sink, CF_VALUE_STR, name);
+    if (value) {
+        const char *stored = cf_arena_strdup(&sink->arena, text);
+        if (stored) value->text = stored;
+    }
+    append_text(sink, text);
 }
 
-void render_json_output(const char *user_host) {
-    char base_keys[MAX_CAPTURE_LINES][64];
-    size_t base_counts[MAX_CAPTURE_LINES] = {0};
-    size_t base_key_count = 0;
+void cf_emit_u64(struct cf_sink *sink, const char *name, unsigned long long number, const char *unit) {
+    struct cf_value *value = add_value(sink, CF_VALUE_U64, name);
+    if (value) {
+        value->u64 = number;
+        if (unit && unit[0]) {
+            const char *stored = cf_arena_strdup(&sink->arena, unit);
+            if (stored) value->unit = stored;
+        }
+    }
 
-    printf("{\n");
+    char text[96];
+    snprintf(text, sizeof(text), "%llu%s%.32s", number, unit && unit[0] ? " " : "", unit ? unit : "");
+    append_text(sink, text);
+}
 
-    printf("  \"user_host\": ");
-    print_json_escaped(user_host ? user_host : "");
+void cf_emit_percent(struct cf_sink *sink, const char *name, double percent, int decimals) {
+    struct cf_value *value = add_value(sink, CF_VALUE_PERCENT, name);
+    if (value) {
+        value->percent = percent;
+        value->decimals = decimals;
+    }
 
-    for (size_t i = 0; i < g_info_kv_count; i++) {
-        char base_key[64];
-        strncpy(base_key, g_info_keys[i], sizeof(base_key) - 1);
-        base_key[sizeof(base_key) - 1] = '\0';
-        if (base_key[0] == '\0') {
-            snprintf(base_key, sizeof(base_key), "unknown");
-        }
+    char text[64];
+    snprintf(text, sizeof(text), "%.*f%%", decimals, percent);
+    append_text(sink, text);
+}
 
-        size_t idx = base_key_count;
-        for (size_t j = 0; j < base_key_count; j++) {
-            if (strcmp(base_key, base_keys[j]) == 0) {
-                idx = j;
-                break;
-            }
-        }
+// The panel shows bytes in the configured memory or storage unit; JSON
+// always carries the byte count.
+void cf_emit_bytes(struct cf_sink *sink, const char *name, unsigned long long bytes, enum cf_byte_unit unit) {
+    struct cf_value *value = add_value(sink, CF_VALUE_BYTES, name);
+    if (value) value->u64 = bytes;
+    if (!open_entry(sink)) return;
+
+    char text[32 + MEMORY_UNIT_LEN];
+    const struct CupidConfig *config = sink->config;
+    if (!config) {
+        snprintf(text, sizeof(text), "%llu B", bytes);
+    } else if (unit == CF_BYTES_STORAGE) {
+        snprintf(text, sizeof(text), "%lu %s", cf_convert_bytes_to_unit(bytes, config->storage_unit_size), config->storage_unit);
+    } else {
+        snprintf(text, sizeof(text), "%lu %s", cf_convert_bytes_to_unit(bytes, config->memory_unit_size), config->memory_unit);
+    }
+    append_text(sink, text);
+}
 
-        if (idx == base_key_count && base_key_count < MAX_CAPTURE_LINES) {
-            strncpy(base_keys[base_key_count], base_key, sizeof(base_keys[base_key_count]) - 1);
-            base_keys[base_key_count][sizeof(base_keys[base_key_count]) - 1] = '\0';
-            base_counts[base_key_count] = 0;
-            base_key_count++;
-        }
+struct cf_sink *cf_sink_new(const struct CupidConfig *config) {
+    struct cf_sink *sink = calloc(1, sizeof(struct cf_sink));
+    if (!sink) return NULL;
+    sink->config = config;
+    cf_arena_init(&sink->arena, 0);
+    return sink;
+}
 
-        size_t occurrence = 1;
-        if (idx < MAX_CAPTURE_LINES) {
-            base_counts[idx]++;
-            occurrence = base_counts[idx];
-        }
+// Keeps the arena's blocks, so a watch-mode redraw allocates nothing new
+// unless it reports more than the previous one.
+void cf_sink_reset(struct cf_sink *sink) {
+    if (!sink) return;
+    cf_arena_reset(&sink->arena);
+    sink->entries = NULL;
+    sink->count = 0;
+    sink->entries_cap = 0;
+    sink->line_open = false;
+    sink->values = NULL;
+    sink->value_count = 0;
+    sink->values_cap = 0;
+}
 
-        char unique_key[64];
-        strncpy(unique_key, base_key, sizeof(unique_key) - 1);
-        unique_key[sizeof(unique_key) - 1] = '\0';
+void cf_sink_free(struct cf_sink *sink) {
+    if (!sink) return;
+    cf_arena_free(&sink->arena);
+    free(sink);
+}
 
-        if (occurrence > 1) {
-            char suffixed[64];
-            char suffix_num[32];
-            snprintf(suffix_num, sizeof(suffix_num), "%zu", occurrence);
+size_t cf_sink_count(const struct cf_sink *sink) {
+    return sink ? sink->count : 0;
+}
 
-            size_t suffix_len = strlen(suffix_num);
-            size_t max_key_len = 0;
-            if (suffix_len + 1 < sizeof(suffixed)) {
-                max_key_len = sizeof(suffixed) - suffix_len - 2;
-            }
+void cf_sink_entry(const struct cf_sink *sink, size_t index, const char **key, const char **label, const char **text) {
+    const struct cf_entry *entry = &sink->entries[index];
+    if (key) *key = entry->key;
+    if (label) *label = entry->label;
+    if (text) *text = entry->text;
+}
+
+const struct cf_value *cf_sink_values(const struct cf_sink *sink, size_t index, size_t *count_out) {
+    const struct cf_entry *entry = &sink->entries[index];
+    *count_out = entry->value_count;
+    return entry->value_count > 0 ? &sink->values[entry->first_value] : NULL;
+}
+
+static const char *entry_line(struct cf_arena *arena, const struct cf_entry *entry) {
+    char aligned_key[128];
+    format_aligned_key(entry->label, entry->align_key, aligned_key, sizeof(aligned_key));
+    size_t key_len = strlen(aligned_key);
+    char *line = cf_arena_alloc(arena, key_len + 2 + entry->text_len + 1);
+    if (!line) return NULL;
+    memcpy(line, aligned_key, key_len);
+    memcpy(line + key_len, ": ", 2);
+    memcpy(line + key_len + 2, entry->text, entry->text_len + 1);
+    return line;
+}
+
+static void print_json_value(FILE *out, const struct cf_value *value) {
+    switch (value->type) {
+    case CF_VALUE_STR:
+        print_json_escaped(out, value->text);
+        break;
+    case CF_VALUE_U64:
+    case CF_VALUE_BYTES:
+        fprintf(out, "%llu", value->u64);
+        break;
+    case CF_VALUE_PERCENT:
+        if (isfinite(value->percent)) {
+            fprintf(out, "%.*f", value->decimals, value->percent);
+        } else {
+            fprintf(out, "null");
+        }
+        break;
+    }
+}
+
+// Entries without named values stay plain strings; the rest become objects
+// holding the panel text and each value in its native JSON type.
+void render_json_output(FILE *out, const struct cf_sink *sink, const char *user_host) {
+    fprintf(out, "{\n");
 
-            snprintf(
-                suffixed,
-                sizeof(suffixed),
-                "%.*s_%s",
-                (int)max_key_len,
-                base_key,
-                suffix_num
-            );
-            strncpy(unique_key, suffixed, sizeof(unique_key) - 1);
-            unique_key[sizeof(unique_key) - 1] = '\0';
+    fprintf(out, "  \"user_host\": ");
+    print_json_escaped(out, user_host ? user_host : "");
+
+    for (size_t i = 0; i < sink->count; i++) {
+        const struct cf_entry *entry = &sink->entries[i];
+        fprintf(out, ",\n  \"%s\": ", entry->key);
+        if (entry->value_count == 0) {
+            print_json_escaped(out, entry->text);
+            continue;
         }
 
-        printf(",\n  \"");
-        printf("%s", unique_key);
-        printf("\": ");
-        print_json_escaped(g_info_values[i]);
+        fprintf(out, "{\"text\": ");
+        print_json_escaped(out, entry->text);
+        for (size_t j = 0; j < entry->value_count; j++) {
+            const struct cf_value *value = &sink->values[entry->first_value + j];
+            fprintf(out, ", ");
+            print_json_escaped(out, value->name);
+            fprintf(out, ": ");
+            print_json_value(out, value);
+        }
+        fprintf(out, "}");
     }
 
-    printf("\n}\n");
+    fprintf(out, "\n}\n");
 }
 
-void render_fetch_panel(const char *distro, const char *user_host) {
-    bool color_enabled = should_use_color();
-    bool use_truecolor = terminal_supports_truecolor();
-    const struct DistroLogo *logo = find_logo_for_distro(distro);
-    int terminal_width = get_terminal_width();
-    int terminal_height = get_terminal_height();
+void render_fetch_panel(FILE *out, struct cf_context *ctx, const struct cf_sink *sink, const char *distro, const char *user_host) {
+    bool color_enabled = should_use_color(out);
+    bool use_truecolor = terminal_supports_truecolor(out);
+    const struct DistroLogo *logo = find_logo_for_distro(ctx, distro);
+    int terminal_width = 0;
+    int terminal_height = 0;
+    cf_ctx_terminal_size(ctx, &terminal_width, &terminal_height);
     size_t scale_num = 1;
     size_t scale_den = 1;
 
@@ -1786,35 +1930,39 @@ void render_fetch_panel(const char *distro, const char *user_host) {
 
     choose_logo_scale(logo, terminal_width, terminal_height, true, false, &scale_num, &scale_den);
 
-    char scaled_logo_storage[MAX_CAPTURE_LINES][MAX_CAPTURE_LINE_LEN];
-    const char *scaled_logo_lines[MAX_CAPTURE_LINES];
-    size_t scaled_logo_count = build_scaled_logo_lines(
-        logo,
-        scale_num,
-        scale_den,
-        scaled_logo_storage,
-        scaled_logo_lines,
-        MAX_CAPTURE_LINES
-    );
-    size_t left_width = line_array_max_width(scaled_logo_lines, scaled_logo_count);
+    // Everything this redraw lays out; released in one go at the end.
+    struct cf_arena arena;
+    cf_arena_init(&arena, 0);
 
-    if ((size_t)terminal_width <= left_width + 8) {
-        char clipped_line[MAX_CAPTURE_LINE_LEN];
+    struct line_list logo_lines = {NULL, 0, 0};
+    build_scaled_logo_lines(&arena, logo, scale_num, scale_den, &logo_lines);
+    size_t left_width = line_array_max_width(logo_lines.lines, logo_lines.count);
 
-        for (size_t i = 0; i < scaled_logo_count; i++) {
-            center_fit_for_width(scaled_logo_lines[i], (size_t)terminal_width, clipped_line, sizeof(clipped_line));
-            print_logo_line_inline(clipped_line, color_enabled, use_truecolor, logo->r, logo->g, logo->b);
-            printf("\n");
+    if ((size_t)terminal_width <= left_width + 8) {
+        for (size_t i = 0; i < logo_lines.count; i++) {
+            size_t size = strlen(logo_lines.lines[i]) + (size_t)terminal_width + 1;
+            char *clipped_line = cf_arena_alloc(&arena, size);
+            if (!clipped_line) break;
+            center_fit_for_width(logo_lines.lines[i], (size_t)terminal_width, clipped_line, size);
+            print_logo_line_inline(out, clipped_line, color_enabled, use_truecolor, logo->r, logo->g, logo->b);
+            fprintf(out, "\n");
         }
 
         if (user_host && user_host[0]) {
-            truncate_for_width(user_host, (size_t)terminal_width, clipped_line, sizeof(clipped_line));
-            printf("%s\n", clipped_line);
+            size_t size = strlen(user_host) + sizeof("…");
+            char *clipped_line = cf_arena_alloc(&arena, size);
+            if (clipped_line) {
+                truncate_for_width(user_host, (size_t)terminal_width, clipped_line, size);
+                fprintf(out, "%s\n", clipped_line);
+            }
         }
-        for (size_t i = 0; i < g_info_line_count; i++) {
-            truncate_for_width(g_info_lines[i], (size_t)terminal_width, clipped_line, sizeof(clipped_line));
-            print_info_line_inline(clipped_line, color_enabled, use_truecolor, logo->r, logo->g, logo->b);
-            printf("\n");
+        for (size_t i = 0; i < sink->count; i++) {
+            const char *line = entry_line(&arena, &sink->entries[i]);
+            char *clipped_line = line ? cf_arena_alloc(&arena, strlen(line) + sizeof("…")) : NULL;
+            if (!clipped_line) break;
+            truncate_for_width(line, (size_t)terminal_width, clipped_line, strlen(line) + sizeof("…"));
+            print_info_line_inline(out, clipped_line, color_enabled, use_truecolor, logo->r, logo->g, logo->b);
+            fprintf(out, "\n");
         }
 
         if (color_enabled && terminal_width >= 16) {
@@ -1822,30 +1970,31 @@ void render_fetch_panel(const char *distro, const char *user_host) {
             char palette_row_2[256];
             make_palette_row(0, palette_row_1, sizeof(palette_row_1));
             make_palette_row(8, palette_row_2, sizeof(palette_row_2));
-            printf("\n%s\n%s\n", palette_row_1, palette_row_2);
+            fprintf(out, "\n%s\n%s\n", palette_row_1, palette_row_2);
         }
+        cf_arena_free(&arena);
         return;
     }
 
     size_t right_width = (size_t)terminal_width - left_width - 3;
 
-    char separator[128];
     size_t host_len = user_host ? strlen(user_host) : 0;
     size_t sep_len = host_len < right_width ? host_len : right_width;
-    if (sep_len > (sizeof(separator) - 1)) sep_len = sizeof(separator) - 1;
-    for (size_t i = 0; i < sep_len; i++) separator[i] = '-';
-    separator[sep_len] = '\0';
+    char *separator = cf_arena_alloc(&arena, sep_len + 1);
+    if (separator) {
+        memset(separator, '-', sep_len);
+        separator[sep_len] = '\0';
+    }
 
-    char right_lines[MAX_RENDER_LINES][MAX_CAPTURE_LINE_LEN];
-    size_t right_count = 0;
+    struct line_list right_lines = {NULL, 0, 0};
 
     if (user_host && user_host[0]) {
-        append_wrapped_line(user_host, right_width, right_lines, &right_count, MAX_RENDER_LINES);
+        append_wrapped_line(&arena, user_host, right_width, &right_lines);
     }
-    append_wrapped_line(separator, right_width, right_lines, &right_count, MAX_RENDER_LINES);
+    append_wrapped_line(&arena, separator, right_width, &right_lines);
 
-    for (size_t i = 0; i < g_info_line_count; i++) {
-        append_wrapped_line(g_info_lines[i], right_width, right_lines, &right_count, MAX_RENDER_LINES);
+    for (size_t i = 0; i < sink->count; i++) {
+        append_wrapped_line(&arena, entry_line(&arena, &sink->entries[i]), right_width, &right_lines);
     }
 
     if (color_enabled && right_width >= 16) {
@@ -1854,52 +2003,42 @@ void render_fetch_panel(const char *distro, const char *user_host) {
         make_palette_row(0, palette_row_1, sizeof(palette_row_1));
         make_palette_row(8, palette_row_2, sizeof(palette_row_2));
 
-        if (right_count < MAX_RENDER_LINES) {
-            right_lines[right_count][0] = '\0';
-            right_count++;
-        }
-        if (right_count < MAX_RENDER_LINES) {
-            strncpy(right_lines[right_count], palette_row_1, MAX_CAPTURE_LINE_LEN - 1);
-            right_lines[right_count][MAX_CAPTURE_LINE_LEN - 1] = '\0';
-            right_count++;
-        }
-        if (right_count < MAX_RENDER_LINES) {
-            strncpy(right_lines[right_count], palette_row_2, MAX_CAPTURE_LINE_LEN - 1);
-            right_lines[right_count][MAX_CAPTURE_LINE_LEN - 1] = '\0';
-            right_count++;
-        }
+        line_list_push(&arena, &right_lines, "");
+        line_list_push(&arena, &right_lines, cf_arena_strdup(&arena, palette_row_1));
+        line_list_push(&arena, &right_lines, cf_arena_strdup(&arena, palette_row_2));
     }
 
-    size_t right_rows = right_count;
-    size_t total_rows = scaled_logo_count > right_rows ? scaled_logo_count : right_rows;
+    size_t total_rows = logo_lines.count > right_lines.count ? logo_lines.count : right_lines.count;
 
     for (size_t row = 0; row < total_rows; row++) {
         size_t printed_left = 0;
-        if (row < scaled_logo_count) {
-            const char *logo_line = scaled_logo_lines[row];
+        if (row < logo_lines.count) {
+            const char *logo_line = logo_lines.lines[row];
             printed_left = utf8_display_width(logo_line);
-            print_logo_line_inline(logo_line, color_enabled, use_truecolor, logo->r, logo->g, logo->b);
+            print_logo_line_inline(out, logo_line, color_enabled, use_truecolor, logo->r, logo->g, logo->b);
         }
 
         if (left_width > printed_left) {
-            printf("%*s", (int)(left_width - printed_left), "");
+            fprintf(out, "%*s", (int)(left_width - printed_left), "");
         }
-        printf("   ");
+        fprintf(out, "   ");
 
-        if (row < right_count) {
-            print_info_line_inline(right_lines[row], color_enabled, use_truecolor, logo->r, logo->g, logo->b);
+        if (row < right_lines.count) {
+            print_info_line_inline(out, right_lines.lines[row], color_enabled, use_truecolor, logo->r, logo->g, logo->b);
         }
 
-        printf("\n");
+        fprintf(out, "\n");
     }
+    cf_arena_free(&arena);
 }
 
 void print_cat(const char* distro) {
-    const struct DistroLogo *logo = find_logo_for_distro(distro);
-    bool color_enabled = should_use_color();
-    bool use_truecolor = terminal_supports_truecolor();
-    int terminal_width = get_terminal_width();
-    int terminal_height = get_terminal_height();
+    const struct DistroLogo *logo = find_logo_for_distro(NULL, distro);
+    bool color_enabled = should_use_color(stdout);
+    bool use_truecolor = terminal_supports_truecolor(stdout);
+    int terminal_width = 0;
+    int terminal_height = 0;
+    get_terminal_size(&terminal_width, &terminal_height);
     size_t scale_num = 1;
     size_t scale_den = 1;
 
@@ -1908,22 +2047,19 @@ void print_cat(const char* distro) {
 
     choose_logo_scale(logo, terminal_width, terminal_height, false, true, &scale_num, &scale_den);
 
-    char scaled_logo_storage[MAX_CAPTURE_LINES][MAX_CAPTURE_LINE_LEN];
-    const char *scaled_logo_lines[MAX_CAPTURE_LINES];
-    size_t scaled_logo_count = build_scaled_logo_lines(
-        logo,
-        scale_num,
-        scale_den,
-        scaled_logo_storage,
-        scaled_logo_lines,
-        MAX_CAPTURE_LINES
-    );
-
-    char fitted_line[MAX_CAPTURE_LINE_LEN];
-    size_t width = (terminal_width > 0) ? (size_t)terminal_width : 80;
-    for (size_t i = 0; i < scaled_logo_count; i++) {
-        center_fit_for_width(scaled_logo_lines[i], width, fitted_line, sizeof(fitted_line));
-        print_logo_line_inline(fitted_line, color_enabled, use_truecolor, logo->r, logo->g, logo->b);
+    struct cf_arena arena;
+    cf_arena_init(&arena, 0);
+    struct line_list logo_lines = {NULL, 0, 0};
+    build_scaled_logo_lines(&arena, logo, scale_num, scale_den, &logo_lines);
+
+    size_t width = (size_t)terminal_width;
+    for (size_t i = 0; i < logo_lines.count; i++) {
+        size_t size = strlen(logo_lines.lines[i]) + width + 1;
+        char *fitted_line = cf_arena_alloc(&arena, size);
+        if (!fitted_line) break;
+        center_fit_for_width(logo_lines.lines[i], width, fitted_line, size);
+        print_logo_line_inline(stdout, fitted_line, color_enabled, use_truecolor, logo->r, logo->g, logo->b);
         printf("\n");
     }
+    cf_arena_free(&arena);
 }
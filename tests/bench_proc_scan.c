@@ -0,0 +1,180 @@
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/modules/common/module_helpers.h"
+
+#define BENCH_DEFAULT_ENTRIES 100000
+#define BENCH_MAX_ENTRIES 1000000
+#define BENCH_DEFAULT_RUNS 5
+#define BENCH_MAX_RUNS 100
+
+// Same shape as the window-manager list: a miss makes every scanner visit
+// every pid, which is the case the sharded scanner is for.
+static const struct process_match bench_candidates[] = {
+    {"hyprland", "Hyprland"}, {"sway", "Sway"}, {"river", "River"}, {"labwc", "labwc"},
+    {"wayfire", "Wayfire"}, {"weston", "Weston"}, {"niri", "Niri"}, {"i3", "i3"},
+    {"bspwm", "bspwm"}, {"herbstluftwm", "herbstluftwm"}, {"xmonad", "XMonad"},
+    {"qtile", "Qtile"}, {"icewm", "IceWM"}, {"openbox", "Openbox"}, {"fluxbox", "Fluxbox"},
+    {"kwin_wayland", "KWin (Wayland)"}, {"mutter", "Mutter"}, {"xfwm4", "Xfwm4"},
+    {"marco", "Marco"}, {"enlightenment", "Enlightenment"},
+};
+#define BENCH_NUM_CANDIDATES (sizeof(bench_candidates) / sizeof(bench_candidates[0]))
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static int env_int(const char *name, int default_value, int max_value) {
+    const char *raw = getenv(name);
+    if (!raw || !raw[0]) return default_value;
+
+    char *endptr = NULL;
+    long parsed = strtol(raw, &endptr, 10);
+    if (endptr == raw || *endptr != '\0' || parsed <= 0 || parsed > max_value) return -1;
+    return (int)parsed;
+}
+
+static bool write_small_file(const char *path, const char *data, size_t len) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) return false;
+    bool ok = fwrite(data, 1, len, fp) == len;
+    return fclose(fp) == 0 && ok;
+}
+
+static bool build_fake_proc(const char *root, int entries) {
+    char path[512];
+    char cmdline[128];
+
+    for (int pid = 1; pid <= entries; pid++) {
+        snprintf(path, sizeof(path), "%s/%d", root, pid);
+        if (mkdir(path, 0755) != 0) return false;
+
+        snprintf(path, sizeof(path), "%s/%d/comm", root, pid);
+        if (!write_small_file(path, "kworker/u8:2\n", 13)) return false;
+
+        int len = snprintf(cmdline, sizeof(cmdline), "/usr/libexec/worker-%d%c--flag%c", pid, '\0', '\0');
+        snprintf(path, sizeof(path), "%s/%d/cmdline", root, pid);
+        if (!write_small_file(path, cmdline, (size_t)len)) return false;
+    }
+    return true;
+}
+
+static void remove_fake_proc(const char *root, int entries) {
+    char path[512];
+    for (int pid = 1; pid <= entries; pid++) {
+        snprintf(path, sizeof(path), "%s/%d/comm", root, pid);
+        unlink(path);
+        snprintf(path, sizeof(path), "%s/%d/cmdline", root, pid);
+        unlink(path);
+        snprintf(path, sizeof(path), "%s/%d", root, pid);
+        rmdir(path);
+    }
+    rmdir(root);
+}
+
+// The scan cf_detect_process_label() used before: readdir() plus an
+// fopen() of comm and cmdline for every candidate of every pid.
+static bool legacy_matches(const char *root, const char *pid, const char *needle) {
+    char path[512];
+    char comm[128];
+
+    snprintf(path, sizeof(path), "%s/%s/comm", root, pid);
+    FILE *comm_file = fopen(path, "r");
+    if (comm_file) {
+        if (fgets(comm, sizeof(comm), comm_file)) {
+            cf_trim_newline(comm);
+            fclose(comm_file);
+            if (cf_contains_icase(comm, needle)) return true;
+        } else {
+            fclose(comm_file);
+        }
+    }
+
+    snprintf(path, sizeof(path), "%s/%s/cmdline", root, pid);
+    FILE *cmdline_file = fopen(path, "r");
+    if (!cmdline_file) return false;
+
+    char cmdline[512];
+    size_t nread = fread(cmdline, 1, sizeof(cmdline) - 1, cmdline_file);
+    fclose(cmdline_file);
+    cmdline[nread] = '\0';
+    return cf_contains_icase(cmdline, needle);
+}
+
+static const char *legacy_scan(const char *root) {
+    DIR *dir = opendir(root);
+    if (!dir) return NULL;
+
+    const char *label = NULL;
+    struct dirent *entry;
+    while (!label && (entry = readdir(dir)) != NULL) {
+        if (entry->d_type != DT_DIR || entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        for (size_t i = 0; i < BENCH_NUM_CANDIDATES; i++) {
+            if (legacy_matches(root, entry->d_name, bench_candidates[i].proc_name)) {
+                label = bench_candidates[i].label;
+                break;
+            }
+        }
+    }
+    closedir(dir);
+    return label;
+}
+
+static double best_of(int runs, const char *root, unsigned int threads, bool legacy) {
+    double best = -1.0;
+    for (int r = 0; r < runs; r++) {
+        double t0 = now_ms();
+        const char *label = legacy ? legacy_scan(root)
+                                   : cf_scan_process_label(root, bench_candidates, BENCH_NUM_CANDIDATES, threads);
+        double elapsed = now_ms() - t0;
+        if (label) fprintf(stderr, "unexpected match '%s'\n", label);
+        if (best < 0.0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+int main(void) {
+    int entries = env_int("CUPIDFETCH_BENCH_PROC_ENTRIES", BENCH_DEFAULT_ENTRIES, BENCH_MAX_ENTRIES);
+    int runs = env_int("CUPIDFETCH_BENCH_RUNS", BENCH_DEFAULT_RUNS, BENCH_MAX_RUNS);
+    if (entries < 0 || runs < 0) {
+        fprintf(stderr, "Invalid CUPIDFETCH_BENCH_PROC_ENTRIES or CUPIDFETCH_BENCH_RUNS\n");
+        return 1;
+    }
+
+    const char *tmp_base = access("/dev/shm", W_OK) == 0 ? "/dev/shm" : "/tmp";
+    char root[256];
+    snprintf(root, sizeof(root), "%s/cupidfetch-proc-XXXXXX", tmp_base);
+    if (!mkdtemp(root)) {
+        fprintf(stderr, "mkdtemp failed: %s\n", strerror(errno));
+        return 1;
+    }
+
+    printf("building fake proc tree: %d entries under %s\n", entries, root);
+    if (!build_fake_proc(root, entries)) {
+        fprintf(stderr, "failed to build fake proc tree: %s\n", strerror(errno));
+        remove_fake_proc(root, entries);
+        return 1;
+    }
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int threads = online > 1 ? (unsigned int)(online > 4 ? 4 : online) : 2;
+
+    double legacy = best_of(runs, root, 0, true);
+    double single = best_of(runs, root, 1, false);
+    double sharded = best_of(runs, root, threads, false);
+
+    printf("legacy readdir+fopen per candidate: %9.2f ms\n", legacy);
+    printf("getdents64+openat, 1 thread:        %9.2f ms (%.1fx)\n", single, legacy / single);
+    printf("getdents64+openat, %u threads:       %9.2f ms (%.1fx)\n", threads, sharded, legacy / sharded);
+
+    remove_fake_proc(root, entries);
+    return 0;
+}
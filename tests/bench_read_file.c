@@ -0,0 +1,251 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/modules/common/module_helpers.h"
+
+#define BENCH_DEFAULT_CALLS 200000
+#define BENCH_MAX_CALLS 10000000
+#define BENCH_BATCH_FILES 48
+
+// glibc routes its own allocations (including fopen's FILE and stdio
+// buffer) through an interposed malloc, so counting here sees them too.
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+static unsigned long g_malloc_calls;
+
+void *malloc(size_t size) {
+    g_malloc_calls++;
+    return __libc_malloc(size);
+}
+#define BENCH_HAVE_MALLOC_COUNT 1
+#endif
+
+struct bench_counts {
+    double ms;
+    unsigned long long read_syscalls;
+    unsigned long allocations;
+};
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static int env_int(const char *name, int default_value, int max_value) {
+    const char *raw = getenv(name);
+    if (!raw || !raw[0]) return default_value;
+
+    char *endptr = NULL;
+    long parsed = strtol(raw, &endptr, 10);
+    if (endptr == raw || *endptr != '\0' || parsed <= 0 || parsed > max_value) return -1;
+    return (int)parsed;
+}
+
+// syscr in /proc/self/io counts read-family syscalls; 0 when unavailable.
+static unsigned long long read_syscall_count(void) {
+    char text[512];
+    if (cf_read_file("/proc/self/io", text, sizeof(text)) <= 0) return 0;
+
+    const char *syscr = strstr(text, "syscr:");
+    return syscr ? strtoull(syscr + 6, NULL, 10) : 0;
+}
+
+static unsigned long malloc_count(void) {
+#ifdef BENCH_HAVE_MALLOC_COUNT
+    return g_malloc_calls;
+#else
+    return 0;
+#endif
+}
+
+// What cf_read_first_line() and the uevent readers did before.
+static bool legacy_first_line(const char *path, char *buffer, size_t size) {
+    FILE *file = fopen(path, "r");
+    if (!file) return false;
+
+    if (!fgets(buffer, (int)size, file)) {
+        fclose(file);
+        return false;
+    }
+    fclose(file);
+    cf_trim_newline(buffer);
+    return true;
+}
+
+static bool legacy_uevent_value(const char *path, const char *key, char *out, size_t out_size) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return false;
+
+    size_t key_len = strlen(key);
+    char line[256];
+    bool found = false;
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, key, key_len) != 0 || line[key_len] != '=') continue;
+        char *value = line + key_len + 1;
+        cf_trim_newline(value);
+        size_t len = strlen(value);
+        if (len >= out_size) len = out_size - 1;
+        memcpy(out, value, len);
+        out[len] = '\0';
+        found = out[0] != '\0';
+        break;
+    }
+    fclose(fp);
+    return found;
+}
+
+static bool current_uevent_value(const char *path, const char *key, char *out, size_t out_size) {
+    char text[4096];
+    if (cf_read_file(path, text, sizeof(text)) <= 0) return false;
+    return cf_find_key_value(text, key, out, out_size);
+}
+
+static struct bench_counts run_first_line(int calls, const char *path, bool legacy) {
+    char line[64];
+    unsigned long long reads0 = read_syscall_count();
+    unsigned long allocs0 = malloc_count();
+    double t0 = now_ms();
+
+    for (int i = 0; i < calls; i++) {
+        bool ok = legacy ? legacy_first_line(path, line, sizeof(line))
+                         : cf_read_first_line(path, line, sizeof(line));
+        if (!ok) fprintf(stderr, "read failed: %s\n", path);
+    }
+
+    struct bench_counts counts;
+    counts.ms = now_ms() - t0;
+    counts.allocations = malloc_count() - allocs0;
+    counts.read_syscalls = read_syscall_count() - reads0;
+    return counts;
+}
+
+static struct bench_counts run_uevent(int calls, const char *path, bool legacy) {
+    char value[64];
+    unsigned long long reads0 = read_syscall_count();
+    unsigned long allocs0 = malloc_count();
+    double t0 = now_ms();
+
+    for (int i = 0; i < calls; i++) {
+        bool ok = legacy ? legacy_uevent_value(path, "PCI_SLOT_NAME", value, sizeof(value))
+                         : current_uevent_value(path, "PCI_SLOT_NAME", value, sizeof(value));
+        if (!ok) fprintf(stderr, "lookup failed: %s\n", path);
+    }
+
+    struct bench_counts counts;
+    counts.ms = now_ms() - t0;
+    counts.allocations = malloc_count() - allocs0;
+    counts.read_syscalls = read_syscall_count() - reads0;
+    return counts;
+}
+
+// A battery-sized batch: every file read on its own, then through
+// cf_read_batch() with and without io_uring. syscr does not count reads
+// io_uring issues, so its column shows the read syscalls avoided.
+static struct bench_counts run_batch(struct cf_read_ring *ring, int calls, char paths[][320], bool batched) {
+    static char buffers[BENCH_BATCH_FILES][64];
+    struct cf_read_request requests[BENCH_BATCH_FILES];
+    int rounds = calls / BENCH_BATCH_FILES > 0 ? calls / BENCH_BATCH_FILES : 1;
+
+    unsigned long long reads0 = read_syscall_count();
+    unsigned long allocs0 = malloc_count();
+    double t0 = now_ms();
+
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < BENCH_BATCH_FILES; i++) {
+            requests[i].dirfd = AT_FDCWD;
+            requests[i].path = paths[i];
+            requests[i].buffer = buffers[i];
+            requests[i].size = sizeof(buffers[i]);
+            if (!batched) requests[i].result = cf_read_file(paths[i], buffers[i], sizeof(buffers[i]));
+        }
+        size_t ok = batched ? cf_read_batch(ring, requests, BENCH_BATCH_FILES) : BENCH_BATCH_FILES;
+        if (ok != BENCH_BATCH_FILES) fprintf(stderr, "batch read %zu of %d files\n", ok, BENCH_BATCH_FILES);
+    }
+
+    struct bench_counts counts;
+    counts.ms = now_ms() - t0;
+    counts.allocations = malloc_count() - allocs0;
+    counts.read_syscalls = read_syscall_count() - reads0;
+    return counts;
+}
+
+static void report(const char *label, const struct bench_counts *counts, int calls) {
+    printf("%-34s %9.2f ms  %5.2f reads/call  %5.2f allocs/call\n", label, counts->ms,
+           (double)counts->read_syscalls / calls, (double)counts->allocations / calls);
+}
+
+int main(void) {
+    int calls = env_int("CUPIDFETCH_BENCH_CALLS", BENCH_DEFAULT_CALLS, BENCH_MAX_CALLS);
+    if (calls < 0) {
+        fprintf(stderr, "Invalid CUPIDFETCH_BENCH_CALLS\n");
+        return 1;
+    }
+
+    const char *tmp_base = access("/dev/shm", W_OK) == 0 ? "/dev/shm" : "/tmp";
+    char dir[256];
+    snprintf(dir, sizeof(dir), "%s/cupidfetch-read-XXXXXX", tmp_base);
+    if (!mkdtemp(dir)) {
+        fprintf(stderr, "mkdtemp failed: %s\n", strerror(errno));
+        return 1;
+    }
+
+    // A sysfs attribute and a uevent file, the two shapes the helpers read.
+    char value_path[320];
+    char uevent_path[320];
+    snprintf(value_path, sizeof(value_path), "%s/energy_now", dir);
+    snprintf(uevent_path, sizeof(uevent_path), "%s/uevent", dir);
+    const char *uevent =
+        "DRIVER=amdgpu\nPCI_CLASS=30000\nPCI_ID=1002:73BF\nPCI_SUBSYS_ID=1DA2:E439\n"
+        "PCI_SLOT_NAME=0000:03:00.0\nMODALIAS=pci:v00001002d000073BFsv00001DA2sd0000E439bc03sc00i00\n";
+
+    if (!cf_write_file_atomic(value_path, "48210000\n", 9) ||
+        !cf_write_file_atomic(uevent_path, uevent, strlen(uevent))) {
+        fprintf(stderr, "failed to write bench files: %s\n", strerror(errno));
+        rmdir(dir);
+        return 1;
+    }
+
+    printf("%d calls per case\n", calls);
+    struct bench_counts counts = run_first_line(calls, value_path, true);
+    report("fopen+fgets first line:", &counts, calls);
+    counts = run_first_line(calls, value_path, false);
+    report("cf_read_first_line:", &counts, calls);
+    counts = run_uevent(calls, uevent_path, true);
+    report("fopen+fgets uevent lookup:", &counts, calls);
+    counts = run_uevent(calls, uevent_path, false);
+    report("cf_read_file+cf_find_key_value:", &counts, calls);
+
+    char batch_paths[BENCH_BATCH_FILES][320];
+    int batch_written = 0;
+    for (; batch_written < BENCH_BATCH_FILES; batch_written++) {
+        snprintf(batch_paths[batch_written], sizeof(batch_paths[batch_written]), "%s/attr%d", dir, batch_written);
+        if (!cf_write_file_atomic(batch_paths[batch_written], "48210000\n", 9)) break;
+    }
+    if (batch_written == BENCH_BATCH_FILES) {
+        int batch_calls = (calls / BENCH_BATCH_FILES > 0 ? calls / BENCH_BATCH_FILES : 1) * BENCH_BATCH_FILES;
+        counts = run_batch(NULL, calls, batch_paths, false);
+        report("48 files, cf_read_file each:", &counts, batch_calls);
+        counts = run_batch(NULL, calls, batch_paths, true);
+        report("48 files, cf_read_batch:", &counts, batch_calls);
+        // One ring for every round, as a cf_state keeps it across fetches.
+        struct cf_read_ring *ring = cf_read_ring_new();
+        counts = run_batch(ring, calls, batch_paths, true);
+        report("48 files, cf_read_batch, io_uring:", &counts, batch_calls);
+        cf_read_ring_free(ring);
+    }
+#ifndef BENCH_HAVE_MALLOC_COUNT
+    printf("(allocation counts need glibc)\n");
+#endif
+
+    for (int i = 0; i < batch_written; i++) unlink(batch_paths[i]);
+    unlink(value_path);
+    unlink(uevent_path);
+    rmdir(dir);
+    return 0;
+}
@@ -46,14 +46,16 @@ int main(void) {
         "memory.unit-size = 1024\n"
         "storage.unit-str = MiB\n"
         "storage.unit-size = 1048576\n"
-        "network.show-full-public-ip = true\n";
+        "network.show-full-public-ip = true\n"
+        "cgroup.aware = off\n"
+        "top.count = 3\n"
+        "io.uring = yes\n";
 
     char cfg_path[256];
     if (write_temp_config(cfg_path, sizeof(cfg_path), cfg_text) != 0) return 1;
 
     struct CupidConfig cfg;
-    init_g_config();
-    cfg = g_userConfig;
+    init_config(&cfg);
 
     load_config_file(cfg_path, &cfg);
 
@@ -75,6 +77,24 @@ int main(void) {
         return 1;
     }
 
+    if (cfg.cgroup_aware) {
+        fprintf(stderr, "cgroup.aware config parse failed\n");
+        unlink(cfg_path);
+        return 1;
+    }
+
+    if (cfg.top_count != 3) {
+        fprintf(stderr, "top.count config parse failed\n");
+        unlink(cfg_path);
+        return 1;
+    }
+
+    if (!cfg.io_uring) {
+        fprintf(stderr, "io.uring config parse failed\n");
+        unlink(cfg_path);
+        return 1;
+    }
+
     if (cfg.modules[0] != get_hostname || cfg.modules[1] != get_available_memory || cfg.modules[2] != get_cpu || cfg.modules[3] != NULL) {
         fprintf(stderr, "modules list parse failed\n");
         unlink(cfg_path);
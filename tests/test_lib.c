@@ -0,0 +1,236 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/libcupidfetch.h"
+
+static const struct cupidfetch_item *find_item(const struct cupidfetch_result *result, const char *key) {
+    for (size_t i = 0; i < result->count; i++) {
+        if (strcmp(result->items[i].key, key) == 0) return &result->items[i];
+    }
+    return NULL;
+}
+
+static int test_collect(cupidfetch *cf) {
+    if (!cupidfetch_select_modules(cf, "hostname username")) {
+        fprintf(stderr, "hostname and username should be known modules\n");
+        return 1;
+    }
+
+    const struct cupidfetch_result *result = cupidfetch_collect(cf);
+    if (!result || result->count != 2 || !result->user_host) {
+        fprintf(stderr, "collect should return one item per selected module\n");
+        return 1;
+    }
+
+    const struct cupidfetch_item *hostname = find_item(result, "hostname");
+    const struct cupidfetch_item *username = find_item(result, "username");
+    if (!hostname || !username || strcmp(hostname->label, "Hostname") != 0) {
+        fprintf(stderr, "collect should key items by module\n");
+        return 1;
+    }
+
+    const char *at = strchr(result->user_host, '@');
+    if (!at || strcmp(at + 1, hostname->text) != 0) {
+        fprintf(stderr, "user_host should end with the collected hostname\n");
+        return 1;
+    }
+
+    // A second collect replaces the first rather than appending to it.
+    result = cupidfetch_collect(cf);
+    if (result->count != 2) {
+        fprintf(stderr, "collect should start from an empty result\n");
+        return 1;
+    }
+    return 0;
+}
+
+static int test_render_json(cupidfetch *cf) {
+    FILE *out = tmpfile();
+    if (!out) {
+        fprintf(stderr, "tmpfile failed\n");
+        return 1;
+    }
+
+    if (!cupidfetch_render_json(cf, out)) {
+        fprintf(stderr, "render_json should report a successful write\n");
+        fclose(out);
+        return 1;
+    }
+    char text[4096];
+    rewind(out);
+    size_t len = fread(text, 1, sizeof(text) - 1, out);
+    text[len] = '\0';
+    fclose(out);
+
+    if (text[0] != '{' || !strstr(text, "\"user_host\"") || !strstr(text, "\"hostname\"") ||
+        !strstr(text, "\"username\"")) {
+        fprintf(stderr, "render_json should write the collected items, got: %s\n", text);
+        return 1;
+    }
+    return 0;
+}
+
+// Memory reports its numbers as byte counts, whatever unit the panel uses.
+static int test_typed_values(cupidfetch *cf) {
+    cupidfetch_select_modules(cf, "memory");
+    const struct cupidfetch_result *result = cupidfetch_collect(cf);
+    const struct cupidfetch_item *memory = find_item(result, "memory");
+    if (!memory) return 0;  // no /proc/meminfo here
+
+    const struct cupidfetch_value *used = NULL;
+    const struct cupidfetch_value *total = NULL;
+    for (size_t i = 0; i < memory->value_count; i++) {
+        if (strcmp(memory->values[i].name, "used_bytes") == 0) used = &memory->values[i];
+        if (strcmp(memory->values[i].name, "total_bytes") == 0) total = &memory->values[i];
+    }
+    if (!used || !total || used->type != CUPIDFETCH_VALUE_BYTES || total->type != CUPIDFETCH_VALUE_BYTES ||
+        total->u64 == 0 || used->u64 > total->u64) {
+        fprintf(stderr, "memory should carry used and total byte counts\n");
+        return 1;
+    }
+
+    FILE *out = tmpfile();
+    if (!out) {
+        fprintf(stderr, "tmpfile failed\n");
+        return 1;
+    }
+    cupidfetch_render_json(cf, out);
+    char text[4096];
+    char expected[64];
+    rewind(out);
+    size_t len = fread(text, 1, sizeof(text) - 1, out);
+    text[len] = '\0';
+    fclose(out);
+
+    snprintf(expected, sizeof(expected), "\"total_bytes\": %llu", total->u64);
+    if (!strstr(text, expected)) {
+        fprintf(stderr, "JSON should carry byte counts as numbers, got: %s\n", text);
+        return 1;
+    }
+    return 0;
+}
+
+// Packages are counted on the host whatever distro the panel is told to
+// show: forcing Arch on a Debian box must not hide the dpkg count.
+static int test_forced_distro_packages(void) {
+    cupidfetch *cf = cupidfetch_new();
+    if (!cf) {
+        fprintf(stderr, "cupidfetch_new failed\n");
+        return 1;
+    }
+    cupidfetch_select_modules(cf, "pkg");
+    const struct cupidfetch_result *result = cupidfetch_collect(cf);
+    bool host_counted = result && find_item(result, "package_count") != NULL;
+
+    int rc = 0;
+    static const char *const forced[] = {"Arch", "Alpine", "NixOS"};
+    for (size_t i = 0; i < sizeof(forced) / sizeof(forced[0]); i++) {
+        cupidfetch_force_distro(cf, forced[i]);
+        result = cupidfetch_collect(cf);
+        if (!result || (find_item(result, "package_count") != NULL) != host_counted) {
+            fprintf(stderr, "--force-distro %s should not change whether packages are counted\n", forced[i]);
+            rc = 1;
+            break;
+        }
+    }
+    cupidfetch_free(cf);
+    return rc;
+}
+
+#define THREAD_MODULES "hostname username distro kernel uptime pkg shell memory storage cpu battery top sensors gpu_usage"
+
+struct collect_job {
+    cupidfetch *cf;
+    bool ok;
+};
+
+static void *collect_repeatedly(void *arg) {
+    struct collect_job *job = arg;
+    for (int i = 0; i < 5 && job->ok; i++) {
+        const struct cupidfetch_result *result = cupidfetch_collect(job->cf);
+        FILE *out = tmpfile();
+        if (!result || !find_item(result, "hostname") || !out || !cupidfetch_render_json(job->cf, out)) job->ok = false;
+        if (out) fclose(out);
+    }
+    return NULL;
+}
+
+// Two handles collecting at once, one with io.uring on, must not share any
+// state (make test-lib-tsan runs this under ThreadSanitizer).
+static int test_concurrent_handles(void) {
+    char cfg_path[] = "/tmp/cupidfetch-lib-XXXXXX";
+    int fd = mkstemp(cfg_path);
+    if (fd < 0) {
+        fprintf(stderr, "mkstemp failed\n");
+        return 1;
+    }
+    static const char cfg_text[] = "io.uring = true\n";
+    bool written = write(fd, cfg_text, sizeof(cfg_text) - 1) == (ssize_t)(sizeof(cfg_text) - 1);
+    close(fd);
+
+    struct collect_job jobs[2] = {{cupidfetch_new(), true}, {cupidfetch_new(), true}};
+    int rc = 1;
+    if (!written || !jobs[0].cf || !jobs[1].cf || !cupidfetch_load_config(jobs[1].cf, cfg_path)) {
+        fprintf(stderr, "could not set up two handles\n");
+        goto out;
+    }
+    for (size_t i = 0; i < 2; i++) cupidfetch_select_modules(jobs[i].cf, THREAD_MODULES);
+
+    pthread_t threads[2];
+    size_t started = 0;
+    for (; started < 2; started++) {
+        if (pthread_create(&threads[started], NULL, collect_repeatedly, &jobs[started]) != 0) break;
+    }
+    bool all_ok = started == 2;
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        all_ok = all_ok && jobs[i].ok;
+    }
+    if (!all_ok) {
+        fprintf(stderr, "handles collecting on separate threads should each succeed\n");
+        goto out;
+    }
+    rc = 0;
+out:
+    for (size_t i = 0; i < 2; i++) cupidfetch_free(jobs[i].cf);
+    unlink(cfg_path);
+    return rc;
+}
+
+int main(void) {
+    cupidfetch *cf = cupidfetch_new();
+    if (!cf) {
+        fprintf(stderr, "cupidfetch_new failed\n");
+        return 1;
+    }
+
+    if (test_collect(cf) != 0) return 1;
+    if (test_render_json(cf) != 0) return 1;
+    if (test_typed_values(cf) != 0) return 1;
+    if (test_forced_distro_packages() != 0) return 1;
+    if (test_concurrent_handles() != 0) return 1;
+
+    if (cupidfetch_select_modules(cf, "hostname no-such-module")) {
+        fprintf(stderr, "unknown module names should be reported\n");
+        return 1;
+    }
+    if (cupidfetch_collect(cf)->count != 1) {
+        fprintf(stderr, "known modules should still run next to unknown ones\n");
+        return 1;
+    }
+
+    cupidfetch_force_distro(cf, "Arch");
+    cupidfetch_select_modules(cf, "distro");
+    const struct cupidfetch_result *result = cupidfetch_collect(cf);
+    if (result->count != 1 || !strstr(result->items[0].text, "Arch")) {
+        fprintf(stderr, "a forced distro should be reported as is\n");
+        return 1;
+    }
+
+    cupidfetch_free(cf);
+    printf("test_lib: OK\n");
+    return 0;
+}
@@ -1,7 +1,10 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "../src/distro_table.h"
 #include "../src/modules/common/module_helpers.h"
+#include "../src/modules/common/gvdb.h"
+#include "../src/modules/common/keyfile.h"
 
 static int test_parse_distro_def_line(void) {
     char shortname[64];
@@ -62,9 +65,488 @@ static int test_parse_os_release_id_line(void) {
     return 0;
 }
 
+static int test_parse_os_release(void) {
+    const char *text =
+        "# Derivative of a derivative\n"
+        "NAME=\"Pop!_OS\"\n"
+        "PRETTY_NAME=\"Pop!_OS 22.04 \\\"Jammy\\\"\"\r\n"
+        "ID=Pop\n"
+        "ID_LIKE='ubuntu Debian'\n"
+        "VERSION_ID=\"22.04\"\n"
+        "IDX=ignored";
+    struct cf_os_release os;
+
+    if (!cf_parse_os_release(text, &os) || strcmp(os.id, "pop") != 0 || strcmp(os.id_like, "ubuntu debian") != 0 ||
+        strcmp(os.version_id, "22.04") != 0 || strcmp(os.pretty_name, "Pop!_OS 22.04 \"Jammy\"") != 0) {
+        fprintf(stderr, "parse_os_release should unquote and lowercase the fields it keeps\n");
+        return 1;
+    }
+    if (!cf_os_release_is_like(&os, "pop") || !cf_os_release_is_like(&os, "debian") ||
+        cf_os_release_is_like(&os, "deb") || cf_os_release_is_like(&os, "arch")) {
+        fprintf(stderr, "os_release_is_like should match the ID and whole ID_LIKE words\n");
+        return 1;
+    }
+
+    if (!cf_parse_os_release("NAME=Minimal\n", &os) || strcmp(os.id, "linux") != 0 || os.id_like[0]) {
+        fprintf(stderr, "parse_os_release should default ID to linux\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_parse_psi_line(void) {
+    const char *psi =
+        "some avg10=1.25 avg60=0.50 avg300=0.10 total=12345\n"
+        "full avg10=0.75 avg60=0.25 avg300=0.05 total=6789\n";
+    double avg10 = 0.0;
+    double avg60 = 0.0;
+
+    if (!cf_parse_psi_line(psi, "some", &avg10, &avg60) || avg10 != 1.25 || avg60 != 0.50) {
+        fprintf(stderr, "parse_psi_line should parse the some line\n");
+        return 1;
+    }
+
+    if (!cf_parse_psi_line(psi, "full", &avg10, &avg60) || avg10 != 0.75 || avg60 != 0.25) {
+        fprintf(stderr, "parse_psi_line should parse the full line\n");
+        return 1;
+    }
+
+    if (cf_parse_psi_line("some garbage\n", "some", &avg10, &avg60)) {
+        fprintf(stderr, "parse_psi_line should reject malformed lines\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_parse_cgroup_v2_path(void) {
+    char path[256];
+
+    if (!cf_parse_cgroup_v2_path("4:memory:/legacy\n0::/user.slice/user-1000.slice/session-2.scope\n", path, sizeof(path))) {
+        fprintf(stderr, "parse_cgroup_v2_path should find the unified hierarchy line\n");
+        return 1;
+    }
+    if (strcmp(path, "/user.slice/user-1000.slice/session-2.scope") != 0) {
+        fprintf(stderr, "parse_cgroup_v2_path parsed unexpected path\n");
+        return 1;
+    }
+
+    if (cf_parse_cgroup_v2_path("4:memory:/legacy\n", path, sizeof(path))) {
+        fprintf(stderr, "parse_cgroup_v2_path should reject v1-only files\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_parse_cgroup_limits(void) {
+    unsigned long long value = 0;
+    unsigned long long quota = 0;
+    unsigned long long period = 0;
+
+    if (!cf_parse_cgroup_limit_value("536870912\n", &value) || value != 536870912ULL) {
+        fprintf(stderr, "parse_cgroup_limit_value should parse byte limits\n");
+        return 1;
+    }
+    if (cf_parse_cgroup_limit_value("max\n", &value)) {
+        fprintf(stderr, "parse_cgroup_limit_value should treat max as unlimited\n");
+        return 1;
+    }
+
+    if (!cf_parse_cgroup_cpu_max("200000 100000\n", &quota, &period) || quota != 200000ULL || period != 100000ULL) {
+        fprintf(stderr, "parse_cgroup_cpu_max should parse quota and period\n");
+        return 1;
+    }
+    if (cf_parse_cgroup_cpu_max("max 100000\n", &quota, &period)) {
+        fprintf(stderr, "parse_cgroup_cpu_max should treat max quota as unlimited\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_parse_meminfo(void) {
+    const char *meminfo =
+        "MemTotal:       16283284 kB\n"
+        "MemFree:         1234567 kB\n"
+        "MemAvailable:    8000000 kB\n"
+        "Active(anon):     111111 kB\n"
+        "SwapTotal:       2097148 kB\n"
+        "SwapFree:        2000000 kB\n"
+        "HugePages_Total:       4\n"
+        "Hugepagesize:       2048 kB\n";
+    struct cf_meminfo info;
+
+    if (!cf_parse_meminfo(meminfo, &info)) {
+        fprintf(stderr, "parse_meminfo should parse known keys\n");
+        return 1;
+    }
+    if (info.values[CF_MEMINFO_MEM_TOTAL] != 16283284ULL ||
+        info.values[CF_MEMINFO_MEM_AVAILABLE] != 8000000ULL ||
+        info.values[CF_MEMINFO_SWAP_FREE] != 2000000ULL ||
+        info.values[CF_MEMINFO_HUGE_PAGES_TOTAL] != 4ULL ||
+        info.values[CF_MEMINFO_HUGE_PAGE_SIZE] != 2048ULL) {
+        fprintf(stderr, "parse_meminfo parsed unexpected values\n");
+        return 1;
+    }
+    if (cf_meminfo_has(&info, CF_MEMINFO_DIRTY)) {
+        fprintf(stderr, "parse_meminfo should not mark absent keys present\n");
+        return 1;
+    }
+
+    if (!cf_parse_meminfo("Node 1 MemTotal:  4096 kB\nNode 1 MemFree:  1024 kB\n", &info) ||
+        info.values[CF_MEMINFO_MEM_TOTAL] != 4096ULL || info.values[CF_MEMINFO_MEM_FREE] != 1024ULL) {
+        fprintf(stderr, "parse_meminfo should accept per-node meminfo lines\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_cgroup_user_slice_prefix(void) {
+    char slice[128];
+
+    if (!cf_cgroup_user_slice_prefix("/user.slice/user-1000.slice/session-3.scope", slice, sizeof(slice)) ||
+        strcmp(slice, "/user.slice/user-1000.slice") != 0) {
+        fprintf(stderr, "cgroup_user_slice_prefix should stop at the user slice\n");
+        return 1;
+    }
+    if (!cf_cgroup_user_slice_prefix(
+            "/user.slice/user-42.slice/user@42.service/app.slice/app-foot.scope", slice, sizeof(slice)) ||
+        strcmp(slice, "/user.slice/user-42.slice") != 0) {
+        fprintf(stderr, "cgroup_user_slice_prefix should handle the user manager subtree\n");
+        return 1;
+    }
+    if (cf_cgroup_user_slice_prefix("/system.slice/sshd.service", slice, sizeof(slice)) ||
+        cf_cgroup_user_slice_prefix("/user.slice/user-runtime-dir.slice", slice, sizeof(slice))) {
+        fprintf(stderr, "cgroup_user_slice_prefix should reject non-session cgroups\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_parse_proc_stat_line(void) {
+    char comm[32];
+    long ppid = 0;
+    unsigned long long ticks = 0;
+
+    if (!cf_parse_proc_stat_line(
+            "1234 (tmux: server) S 1 1234 1234 0 -1 4194560 100 0 0 0 250 50 0 0 20 0 1 0 99 0 0\n",
+            comm, sizeof(comm), &ppid, &ticks)) {
+        fprintf(stderr, "parse_proc_stat_line should parse a stat line\n");
+        return 1;
+    }
+    if (strcmp(comm, "tmux: server") != 0 || ppid != 1 || ticks != 300ULL) {
+        fprintf(stderr, "parse_proc_stat_line parsed unexpected values\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_find_key_value(void) {
+    const char *uevent =
+        "DRIVER=amdgpu\n"
+        "PCI_SLOT=wrong\n"
+        "PCI_SLOT_NAME=0000:03:00.0\r\n"
+        "MODALIAS=pci:v00001002";
+    char value[16];
+
+    if (!cf_find_key_value(uevent, "PCI_SLOT_NAME", value, sizeof(value)) || strcmp(value, "0000:03:00.0") != 0) {
+        fprintf(stderr, "find_key_value should match whole keys and strip line endings\n");
+        return 1;
+    }
+    if (!cf_find_key_value(uevent, "MODALIAS", value, 8) || strcmp(value, "pci:v00") != 0) {
+        fprintf(stderr, "find_key_value should read an unterminated last line and truncate\n");
+        return 1;
+    }
+    if (cf_find_key_value(uevent, "PCI", value, sizeof(value))) {
+        fprintf(stderr, "find_key_value should not match a key prefix\n");
+        return 1;
+    }
+    return 0;
+}
+
+static int test_parse_power_supply_uevent(void) {
+    const char *uevent =
+        "DEVTYPE=power_supply\n"
+        "POWER_SUPPLY_NAME=BAT0\n"
+        "POWER_SUPPLY_TYPE=Battery\n"
+        "POWER_SUPPLY_STATUS=Discharging\n"
+        "POWER_SUPPLY_PRESENT=1\n"
+        "POWER_SUPPLY_VOLTAGE_NOW=11400000\n"
+        "POWER_SUPPLY_CURRENT_NOW=-1500000\n"
+        "POWER_SUPPLY_CHARGE_FULL=4000000\n"
+        "POWER_SUPPLY_CHARGE_NOW=2000000\n"
+        "POWER_SUPPLY_CAPACITY=50\n"
+        "POWER_SUPPLY_CAPACITY_LEVEL=Normal\n";
+    struct cf_power_supply psu;
+
+    if (!cf_parse_power_supply_uevent(uevent, &psu)) {
+        fprintf(stderr, "parse_power_supply_uevent should parse a battery uevent\n");
+        return 1;
+    }
+    if (strcmp(psu.type, "Battery") != 0 || strcmp(psu.status, "Discharging") != 0 || psu.scope[0] != '\0') {
+        fprintf(stderr, "parse_power_supply_uevent parsed unexpected strings\n");
+        return 1;
+    }
+    if (!cf_power_supply_has(&psu, CF_PSU_CAPACITY) || psu.values[CF_PSU_CAPACITY] != 50ULL ||
+        psu.values[CF_PSU_CURRENT_NOW] != 1500000ULL || psu.values[CF_PSU_VOLTAGE_NOW] != 11400000ULL ||
+        psu.values[CF_PSU_CHARGE_NOW] != 2000000ULL) {
+        fprintf(stderr, "parse_power_supply_uevent parsed unexpected values\n");
+        return 1;
+    }
+    if (cf_power_supply_has(&psu, CF_PSU_ENERGY_NOW) || cf_power_supply_has(&psu, CF_PSU_POWER_NOW)) {
+        fprintf(stderr, "parse_power_supply_uevent should not report absent keys\n");
+        return 1;
+    }
+    if (cf_parse_power_supply_uevent("DEVTYPE=power_supply\n", &psu)) {
+        fprintf(stderr, "parse_power_supply_uevent should reject a uevent without POWER_SUPPLY keys\n");
+        return 1;
+    }
+    return 0;
+}
+
+static int test_parse_drm_fdinfo(void) {
+    struct cf_drm_fdinfo info;
+    const char *text =
+        "pos:\t0\n"
+        "flags:\t02100002\n"
+        "drm-driver:\tamdgpu\n"
+        "drm-pdev:\t0000:03:00.0\n"
+        "drm-client-id:\t42\n"
+        "drm-engine-gfx:\t1500000 ns\n"
+        "drm-engine-capacity-gfx:\t2\n"
+        "drm-engine-compute:\t250 ns\n"
+        "drm-memory-vram:\t1024 KiB\n";
+
+    if (!cf_parse_drm_fdinfo(text, &info)) {
+        fprintf(stderr, "parse_drm_fdinfo should parse a drm fdinfo block\n");
+        return 1;
+    }
+    if (strcmp(info.pdev, "0000:03:00.0") != 0 || info.client_id != 42ULL || info.engine_count != 2) {
+        fprintf(stderr, "parse_drm_fdinfo parsed unexpected header values\n");
+        return 1;
+    }
+    if (strcmp(info.engines[0].name, "gfx") != 0 || info.engines[0].busy_ns != 1500000ULL ||
+        strcmp(info.engines[1].name, "compute") != 0 || info.engines[1].busy_ns != 250ULL) {
+        fprintf(stderr, "parse_drm_fdinfo parsed unexpected engine values\n");
+        return 1;
+    }
+
+    if (cf_parse_drm_fdinfo("pos:\t0\nflags:\t02\n", &info)) {
+        fprintf(stderr, "parse_drm_fdinfo should reject non-drm fdinfo\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static bool write_text_file(const char *path, const char *text) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) return false;
+    fputs(text, fp);
+    fclose(fp);
+    return true;
+}
+
+static int test_keyfile_cache(void) {
+    char path[] = "/tmp/cupidfetch-keyfile-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        fprintf(stderr, "keyfile test could not create a temp file\n");
+        return 1;
+    }
+    close(fd);
+
+    int rc = 1;
+    char value[64];
+    if (!write_text_file(path,
+            "; comment\n"
+            "[Settings]\n"
+            "gtk-theme-name = \"Adwaita-dark\"\n"
+            "gtk-theme-name = Ignored\n"
+            "[ Icons ]\r\n"
+            "Theme=breeze\r\n")) {
+        goto out;
+    }
+
+    if (!cf_keyfile_get(path, "settings", "GTK-THEME-NAME", value, sizeof(value)) ||
+        strcmp(value, "Adwaita-dark") != 0) {
+        fprintf(stderr, "keyfile should return the first unquoted value case-insensitively\n");
+        goto out;
+    }
+    if (!cf_keyfile_get(path, "Icons", "Theme", value, sizeof(value)) || strcmp(value, "breeze") != 0) {
+        fprintf(stderr, "keyfile should trim section names and CRLF values\n");
+        goto out;
+    }
+    if (!cf_keyfile_get(path, NULL, "theme", value, sizeof(value)) || strcmp(value, "breeze") != 0) {
+        fprintf(stderr, "keyfile sectionless lookup should match any section\n");
+        goto out;
+    }
+    if (cf_keyfile_get(path, "Settings", "Theme", value, sizeof(value))) {
+        fprintf(stderr, "keyfile should not match keys from other sections\n");
+        goto out;
+    }
+
+    // A rewrite with a different size must invalidate the cached parse.
+    if (!write_text_file(path, "[Settings]\ngtk-theme-name=Arc\n")) goto out;
+    if (!cf_keyfile_get(path, "Settings", "gtk-theme-name", value, sizeof(value)) || strcmp(value, "Arc") != 0) {
+        fprintf(stderr, "keyfile should reload a changed file\n");
+        goto out;
+    }
+
+    rc = 0;
+out:
+    unlink(path);
+    if (rc == 0 && cf_keyfile_get(path, "Settings", "gtk-theme-name", value, sizeof(value))) {
+        fprintf(stderr, "keyfile should drop a removed file\n");
+        rc = 1;
+    }
+    cf_keyfile_cache_clear();
+    return rc;
+}
+
+static void put_u32_le(unsigned char *p, unsigned int v) {
+    p[0] = (unsigned char)(v & 0xff);
+    p[1] = (unsigned char)((v >> 8) & 0xff);
+    p[2] = (unsigned char)((v >> 16) & 0xff);
+    p[3] = (unsigned char)((v >> 24) & 0xff);
+}
+
+static int test_gvdb_lookup_string(void) {
+    // One-item table: header, hash header (0 bloom words, 1 bucket), bucket,
+    // item, then key and "Adwaita-dark\0\0s" variant bytes.
+    const char *key = "/org/gnome/desktop/interface/gtk-theme";
+    const char variant[] = "Adwaita-dark\0\0s";
+    unsigned char db[256];
+    memset(db, 0, sizeof(db));
+
+    size_t key_len = strlen(key);
+    size_t key_start = 24 + 8 + 4 + 24;
+    size_t value_start = key_start + key_len;
+    size_t value_end = value_start + sizeof(variant) - 1;
+
+    unsigned int hash = 5381;
+    for (const char *p = key; *p; p++) hash = hash * 33 + (unsigned int)(signed char)*p;
+
+    memcpy(db, "GVariant", 8);
+    put_u32_le(db + 16, 24);
+    put_u32_le(db + 20, 24 + 8 + 4 + 24);
+    put_u32_le(db + 24, 0);
+    put_u32_le(db + 28, 1);
+    put_u32_le(db + 32, 0);
+    unsigned char *item = db + 36;
+    put_u32_le(item, hash);
+    put_u32_le(item + 4, 0xffffffffu);
+    put_u32_le(item + 8, (unsigned int)key_start);
+    item[12] = (unsigned char)key_len;
+    item[14] = 'v';
+    put_u32_le(item + 16, (unsigned int)value_start);
+    put_u32_le(item + 20, (unsigned int)value_end);
+    memcpy(db + key_start, key, key_len);
+    memcpy(db + value_start, variant, sizeof(variant) - 1);
+
+    char value[64];
+    if (!cf_gvdb_lookup_string(db, value_end, key, value, sizeof(value)) || strcmp(value, "Adwaita-dark") != 0) {
+        fprintf(stderr, "gvdb_lookup_string should find the string value\n");
+        return 1;
+    }
+    if (cf_gvdb_lookup_string(db, value_end, "/org/gnome/desktop/interface/icon-theme", value, sizeof(value))) {
+        fprintf(stderr, "gvdb_lookup_string should miss an absent key\n");
+        return 1;
+    }
+
+    db[0] = 'X';
+    if (cf_gvdb_lookup_string(db, value_end, key, value, sizeof(value))) {
+        fprintf(stderr, "gvdb_lookup_string should reject a bad signature\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_distro_table(void) {
+    const struct cf_distro_def *def = cf_distro_by_id("fedora");
+    if (!def || strcmp(def->name, "Fedora") != 0 || strcmp(def->pkgcmd, "rpm -qa | wc -l") != 0) {
+        fprintf(stderr, "distro table should map the fedora ID to its entry\n");
+        return 1;
+    }
+    if (cf_distro_by_name("Linux Mint") != cf_distro_by_id("mint") || !cf_distro_by_name("Windows 11")) {
+        fprintf(stderr, "distro table name lookup should find the same entries\n");
+        return 1;
+    }
+    if (cf_distro_by_id("cupidos") || cf_distro_by_id("") || cf_distro_by_name("fedora")) {
+        fprintf(stderr, "distro table should miss unknown keys\n");
+        return 1;
+    }
+
+    char path[] = "/tmp/cupidfetch-distros-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        fprintf(stderr, "distro table test could not create a temp file\n");
+        return 1;
+    }
+    close(fd);
+
+    // Overlay entries win over the built-in ones and add new IDs.
+    int rc = 1;
+    if (!write_text_file(path,
+            "// DISTRO(\"hidden\", \"Hidden\", \"\")\n"
+            "DISTRO(\"fedora\", \"Fedora Linux\", \"\")\n"
+            "/* auto added */\n"
+            "DISTRO(\"cupidos\", \"CupidOS\", \"dpkg -l | wc -l\")\n") ||
+        !cf_distro_overlay_load(path)) {
+        goto out;
+    }
+    def = cf_distro_by_id("cupidos");
+    if (cf_distro_overlay_count() != 2 || !def || strcmp(def->name, "CupidOS") != 0 ||
+        cf_distro_by_name("CupidOS") != def || strcmp(cf_distro_by_id("fedora")->name, "Fedora Linux") != 0 ||
+        !cf_distro_by_id("ubuntu") || cf_distro_by_id("hidden")) {
+        fprintf(stderr, "distro overlay should be consulted before the built-in table\n");
+        goto out;
+    }
+
+    // Auto-added IDs are appended once; a torn last line is not an entry
+    // and is terminated before the next append.
+    if (!write_text_file(path, "DISTRO(\"bluefin\", \"Bluefin\", \"\")\nDISTRO(\"torn\", \"Torn\"") ||
+        !cf_distro_overlay_append(path) || !cf_distro_by_id("bluefin") || cf_distro_by_id("torn") ||
+        !cf_distro_auto_add(path, "aurora", "Aurora") || cf_distro_auto_add(path, "aurora", "Aurora") ||
+        cf_distro_auto_add(path, "bad\"id", "Bad") || !cf_distro_by_id("aurora")) {
+        fprintf(stderr, "distro auto-add should append each new ID once\n");
+        goto out;
+    }
+    cf_distro_overlay_load(NULL);
+    if (!cf_distro_overlay_append(path) || cf_distro_overlay_count() != 2 ||
+        strcmp(cf_distro_by_id("aurora")->name, "Aurora") != 0 || cf_distro_by_id("torn")) {
+        fprintf(stderr, "auto-added distros should be read back from the list\n");
+        goto out;
+    }
+    rc = 0;
+out:
+    cf_distro_overlay_load(NULL);
+    unlink(path);
+    return rc;
+}
+
 int main(void) {
     if (test_parse_distro_def_line() != 0) return 1;
     if (test_parse_os_release_id_line() != 0) return 1;
+    if (test_parse_os_release() != 0) return 1;
+    if (test_parse_psi_line() != 0) return 1;
+    if (test_parse_cgroup_v2_path() != 0) return 1;
+    if (test_parse_cgroup_limits() != 0) return 1;
+    if (test_parse_meminfo() != 0) return 1;
+    if (test_cgroup_user_slice_prefix() != 0) return 1;
+    if (test_parse_proc_stat_line() != 0) return 1;
+    if (test_find_key_value() != 0) return 1;
+    if (test_parse_drm_fdinfo() != 0) return 1;
+    if (test_parse_power_supply_uevent() != 0) return 1;
+    if (test_keyfile_cache() != 0) return 1;
+    if (test_gvdb_lookup_string() != 0) return 1;
+    if (test_distro_table() != 0) return 1;
 
     printf("test_parsers: OK\n");
     return 0;
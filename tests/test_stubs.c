@@ -1,26 +1,42 @@
 #include <stdarg.h>
 #include "../src/cupidfetch.h"
 
-void get_hostname(void) {}
-void get_username(void) {}
-void get_linux_kernel(void) {}
-void get_uptime(void) {}
-void get_distro(void) {}
-void get_package_count(void) {}
-void get_shell(void) {}
-void get_terminal(void) {}
-void get_desktop_environment(void) {}
-void get_window_manager(void) {}
-void get_theme(void) {}
-void get_icons(void) {}
-void get_display_server(void) {}
-void get_net(void) {}
-void get_local_ip(void) {}
-void get_battery(void) {}
-void get_gpu(void) {}
-void get_available_memory(void) {}
-void get_cpu(void) {}
-void get_available_storage(void) {}
+void get_hostname(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_username(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_linux_kernel(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_uptime(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_distro(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_package_count(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_shell(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_terminal(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_desktop_environment(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_window_manager(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_theme(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_icons(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_display_server(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_net(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_local_ip(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_battery(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_gpu(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_available_memory(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_cpu(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_available_storage(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_pressure(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_cgroup(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_top(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_sensors(struct cf_context *ctx, struct cf_sink *sink) {}
+void get_gpu_usage(struct cf_context *ctx, struct cf_sink *sink) {}
+
+void cf_context_init(struct cf_context *ctx, const struct CupidConfig *config, struct cf_state *state) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->config = config;
+    ctx->state = state;
+}
+
+const char *cf_ctx_home(struct cf_context *ctx) {
+    (void)ctx;
+    return "/tmp";
+}
 
 void cupid_log(LogType ltp, const char *format, ...) {
     (void)ltp;
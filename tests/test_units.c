@@ -1,7 +1,576 @@
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "../src/modules/common/module_helpers.h"
 
+static int test_top_heap(void) {
+    struct cf_top_entry storage[3];
+    struct cf_top_heap heap;
+    cf_top_heap_init(&heap, storage, 3);
+
+    const unsigned long long values[] = {5, 1, 9, 3, 7, 2, 8};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        struct cf_top_entry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.pid = (long)i;
+        entry.value = values[i];
+        cf_top_heap_offer(&heap, &entry);
+    }
+
+    if (heap.count != 3) {
+        fprintf(stderr, "top heap should keep exactly its capacity\n");
+        return 1;
+    }
+
+    cf_top_heap_sort_desc(&heap);
+    if (storage[0].value != 9 || storage[1].value != 8 || storage[2].value != 7) {
+        fprintf(stderr, "top heap should keep the largest values in descending order\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_display_socket_peer(void) {
+    char dir[] = "/tmp/cupidfetch-sock-XXXXXX";
+    if (!mkdtemp(dir)) {
+        fprintf(stderr, "display socket test could not create a temp dir\n");
+        return 1;
+    }
+
+    // Stand-in compositor: this process listens on $XDG_RUNTIME_DIR/$WAYLAND_DISPLAY.
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/wayland-test", dir);
+
+    int rc = 1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+        fprintf(stderr, "display socket test could not listen\n");
+        goto out;
+    }
+
+    setenv("XDG_RUNTIME_DIR", dir, 1);
+    setenv("WAYLAND_DISPLAY", "wayland-test", 1);
+    unsetenv("DISPLAY");
+
+    long pid = 0;
+    bool is_wayland = false;
+    if (!cf_display_server_pid(&pid, &is_wayland) || pid != (long)getpid() || !is_wayland) {
+        fprintf(stderr, "display_server_pid should resolve the listening process\n");
+        goto out;
+    }
+
+    static const struct process_match candidates[] = {
+        {"no-such-compositor", "Nope"},
+        {"test_units", "Test Compositor"},
+    };
+    const char *label = cf_detect_display_server_label(candidates, 2);
+    if (!label || strcmp(label, "Test Compositor") != 0) {
+        fprintf(stderr, "detect_display_server_label should match the peer's comm\n");
+        goto out;
+    }
+
+    close(fd);
+    fd = -1;
+    if (cf_unix_socket_peer_pid(addr.sun_path, &pid)) {
+        fprintf(stderr, "unix_socket_peer_pid should fail once the listener is gone\n");
+        goto out;
+    }
+
+    rc = 0;
+out:
+    if (fd >= 0) close(fd);
+    unlink(addr.sun_path);
+    rmdir(dir);
+    return rc;
+}
+
+static bool write_fake_proc_file(const char *root, int pid, const char *name, const char *data, size_t len) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%d", root, pid);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/%d/%s", root, pid, name);
+
+    FILE *fp = fopen(path, "w");
+    if (!fp) return false;
+    fwrite(data, 1, len, fp);
+    fclose(fp);
+    return true;
+}
+
+static void remove_fake_proc_pid(const char *root, int pid) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%d/comm", root, pid);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%d/cmdline", root, pid);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%d", root, pid);
+    rmdir(path);
+}
+
+static int test_scan_process_label(void) {
+    char root[] = "/tmp/cupidfetch-proc-XXXXXX";
+    if (!mkdtemp(root)) {
+        fprintf(stderr, "scan test could not create a temp dir\n");
+        return 1;
+    }
+
+    // 40 idle pids and one whose cmdline (not comm) names the compositor.
+    int rc = 1;
+    for (int pid = 100; pid < 140; pid++) {
+        if (!write_fake_proc_file(root, pid, "comm", "bash\n", 5) ||
+            !write_fake_proc_file(root, pid, "cmdline", "/bin/bash\0-l\0", 13)) {
+            goto out;
+        }
+    }
+    if (!write_fake_proc_file(root, 777, "comm", ".sway-wrapped\n", 14) ||
+        !write_fake_proc_file(root, 777, "cmdline", "/usr/bin/sway\0--unsupported-gpu\0", 33)) {
+        goto out;
+    }
+
+    static const struct process_match candidates[] = {
+        {"hyprland", "Hyprland"},
+        {"/usr/bin/sway", "Sway"},
+    };
+
+    for (unsigned int threads = 1; threads <= 3; threads++) {
+        const char *label = cf_scan_process_label(root, candidates, 2, threads);
+        if (!label || strcmp(label, "Sway") != 0) {
+            fprintf(stderr, "scan_process_label with %u threads should find the cmdline match\n", threads);
+            goto out;
+        }
+    }
+
+    if (cf_scan_process_label(root, candidates, 1, 2) != NULL) {
+        fprintf(stderr, "scan_process_label should miss when no candidate matches\n");
+        goto out;
+    }
+
+    rc = 0;
+out:
+    for (int pid = 100; pid < 140; pid++) remove_fake_proc_pid(root, pid);
+    remove_fake_proc_pid(root, 777);
+    rmdir(root);
+    return rc;
+}
+
+static int check_read_batch(struct cf_read_ring *ring, int root_fd, const char *mode) {
+    char paths[11][32];
+    char buffers[11][32];
+    struct cf_read_request requests[11];
+
+    for (int i = 0; i < 11; i++) {
+        // The last path does not exist; the first buffer is too small.
+        snprintf(paths[i], sizeof(paths[i]), "%d/comm", i == 10 ? 999 : 200 + i);
+        requests[i].dirfd = root_fd;
+        requests[i].path = paths[i];
+        requests[i].buffer = buffers[i];
+        requests[i].size = i == 0 ? 4 : sizeof(buffers[i]);
+    }
+
+    if (cf_read_batch(ring, requests, 11) != 10) {
+        fprintf(stderr, "read_batch (%s) should read the 10 existing files\n", mode);
+        return 1;
+    }
+    if (requests[10].result != -1 || requests[0].result != 3 || strcmp(buffers[0], "tas") != 0) {
+        fprintf(stderr, "read_batch (%s) mishandled a missing file or a short buffer\n", mode);
+        return 1;
+    }
+    for (int i = 1; i < 10; i++) {
+        char expected[32];
+        snprintf(expected, sizeof(expected), "task%d\n", i);
+        if (requests[i].result != (ssize_t)strlen(expected) || strcmp(buffers[i], expected) != 0) {
+            fprintf(stderr, "read_batch (%s) returned the wrong contents for %s\n", mode, paths[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int test_arena(void) {
+    struct cf_arena arena;
+    cf_arena_init(&arena, 64);
+
+    char *a = cf_arena_strdup(&arena, "alpha");
+    char *big = cf_arena_alloc(&arena, 1000);
+    char *b = cf_arena_strdup(&arena, "beta");
+    if (!a || !big || !b || strcmp(a, "alpha") != 0 || strcmp(b, "beta") != 0) {
+        fprintf(stderr, "arena should hand out separate allocations, larger ones in their own block\n");
+        cf_arena_free(&arena);
+        return 1;
+    }
+    memset(big, 'x', 1000);
+    if (strcmp(a, "alpha") != 0 || strcmp(b, "beta") != 0) {
+        fprintf(stderr, "arena allocations should not overlap\n");
+        cf_arena_free(&arena);
+        return 1;
+    }
+
+    char *grown = cf_arena_grow(&arena, b, 5, 40);
+    if (grown != b || strcmp(grown, "beta") != 0) {
+        fprintf(stderr, "arena should grow its latest allocation in place\n");
+        cf_arena_free(&arena);
+        return 1;
+    }
+    grown = cf_arena_grow(&arena, a, 6, 200);
+    if (!grown || grown == a || strcmp(grown, "alpha") != 0) {
+        fprintf(stderr, "arena should copy an older allocation it can't grow\n");
+        cf_arena_free(&arena);
+        return 1;
+    }
+
+    cf_arena_reset(&arena);
+    char *again = cf_arena_strdup(&arena, "gamma");
+    if (again != a) {
+        fprintf(stderr, "arena should reuse its first block after a reset\n");
+        cf_arena_free(&arena);
+        return 1;
+    }
+
+    cf_arena_free(&arena);
+    return 0;
+}
+
+static int test_read_batch(void) {
+    char root[] = "/tmp/cupidfetch-batch-XXXXXX";
+    if (!mkdtemp(root)) {
+        fprintf(stderr, "batch test could not create a temp dir\n");
+        return 1;
+    }
+
+    int rc = 1;
+    int root_fd = -1;
+    struct cf_read_ring *ring = NULL;
+    for (int i = 0; i < 10; i++) {
+        char comm[16];
+        int len = snprintf(comm, sizeof(comm), "task%d\n", i);
+        if (!write_fake_proc_file(root, 200 + i, "comm", comm, (size_t)len)) goto out;
+    }
+
+    root_fd = open(root, O_RDONLY | O_DIRECTORY);
+    if (root_fd < 0) goto out;
+
+    // The plain reader, then io_uring where the kernel allows it (the
+    // results must be the same either way).
+    if (check_read_batch(NULL, root_fd, "sync") != 0) goto out;
+    ring = cf_read_ring_new();
+    if (!ring) goto out;
+    // Twice, so the second batch runs on the ring the first one opened.
+    if (check_read_batch(ring, root_fd, "io_uring") != 0) goto out;
+    if (check_read_batch(ring, root_fd, "io_uring, reused ring") != 0) goto out;
+
+    rc = 0;
+out:
+    cf_read_ring_free(ring);
+    if (root_fd >= 0) close(root_fd);
+    for (int i = 0; i < 10; i++) remove_fake_proc_pid(root, 200 + i);
+    rmdir(root);
+    return rc;
+}
+
+static bool touch_file(const char *dir, const char *name, mode_t mode) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    return cf_write_file_atomic(path, "#!/bin/sh\n", 10) && chmod(path, mode) == 0;
+}
+
+static bool set_mtime(const char *path, time_t sec) {
+    struct timespec times[2];
+    times[0].tv_sec = sec;
+    times[0].tv_nsec = 0;
+    times[1] = times[0];
+    return utimensat(AT_FDCWD, path, times, 0) == 0;
+}
+
+static int check_path_index(const char *path_env, const char *name, bool expected) {
+    bool found = !expected;
+    if (!cf_path_index_lookup(path_env, name, &found) || found != expected) {
+        fprintf(stderr, "path index should report %s as %s\n", name, expected ? "present" : "missing");
+        return 1;
+    }
+    return 0;
+}
+
+static int test_path_index(void) {
+    char root[] = "/tmp/cupidfetch-path-XXXXXX";
+    if (!mkdtemp(root)) {
+        fprintf(stderr, "path index test could not create a temp dir\n");
+        return 1;
+    }
+
+    char cache[128], bin_a[128], bin_b[128], index_file[192], path_env[512];
+    snprintf(cache, sizeof(cache), "%s/cache", root);
+    snprintf(bin_a, sizeof(bin_a), "%s/a", root);
+    snprintf(bin_b, sizeof(bin_b), "%s/b", root);
+    snprintf(index_file, sizeof(index_file), "%s/cupidfetch/path-index", cache);
+    snprintf(path_env, sizeof(path_env), "%s::%s:%s/missing", bin_a, bin_b, root);
+
+    int rc = 1;
+    setenv("XDG_CACHE_HOME", cache, 1);
+    if (mkdir(bin_a, 0755) != 0 || mkdir(bin_b, 0755) != 0) goto out;
+    if (!touch_file(bin_a, "pacman", 0755) || !touch_file(bin_b, "lspci", 0755) ||
+        !touch_file(bin_b, "stale", 0755)) {
+        goto out;
+    }
+    // Neither a plain file nor a dangling symlink is something PATH would run.
+    char path[256];
+    snprintf(path, sizeof(path), "%s/dangling", bin_a);
+    if (!touch_file(bin_a, "notes", 0644) || symlink("missing-target", path) != 0) goto out;
+    if (!set_mtime(bin_a, 1000000000) || !set_mtime(bin_b, 1000000000)) goto out;
+
+    cf_path_index_reset();
+    if (check_path_index(path_env, "pacman", true) != 0) goto out;
+    if (check_path_index(path_env, "lspci", true) != 0) goto out;
+    if (check_path_index(path_env, "rpm", false) != 0) goto out;
+    if (check_path_index(path_env, "notes", false) != 0) goto out;
+    if (check_path_index(path_env, "dangling", false) != 0) goto out;
+    if (access(index_file, R_OK) != 0) {
+        fprintf(stderr, "path index should be written to %s\n", index_file);
+        goto out;
+    }
+
+    // A directory whose mtime still matches is answered from the file alone,
+    // so a removal hidden behind a restored mtime goes unnoticed; one whose
+    // mtime moved is listed again.
+    snprintf(path, sizeof(path), "%s/stale", bin_b);
+    if (unlink(path) != 0 || !set_mtime(bin_b, 1000000000)) goto out;
+    if (!touch_file(bin_a, "gsettings", 0755) || !set_mtime(bin_a, 1000000100)) goto out;
+
+    cf_path_index_reset();
+    if (check_path_index(path_env, "stale", true) != 0) goto out;
+    if (check_path_index(path_env, "gsettings", true) != 0) goto out;
+    if (check_path_index(path_env, "pacman", true) != 0) goto out;
+    if (check_path_index(path_env, "notes", false) != 0) goto out;
+
+    rc = 0;
+out:
+    cf_path_index_reset();
+    unsetenv("XDG_CACHE_HOME");
+    const char *files[] = {"a/pacman", "a/gsettings", "a/notes", "a/dangling", "b/lspci", "b/stale",
+                           "cache/cupidfetch/path-index"};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        snprintf(path, sizeof(path), "%s/%s", root, files[i]);
+        unlink(path);
+    }
+    const char *dirs[] = {"a", "b", "cache/cupidfetch", "cache"};
+    for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+        snprintf(path, sizeof(path), "%s/%s", root, dirs[i]);
+        rmdir(path);
+    }
+    rmdir(root);
+    return rc;
+}
+
+static char g_sensor_cpu_file[128];
+static int g_sensor_discoveries;
+
+static void fake_discover_sensors(struct cf_sensor_paths *paths) {
+    g_sensor_discoveries++;
+    snprintf(paths->cpu, sizeof(paths->cpu), "%s", g_sensor_cpu_file);
+    paths->gpu[0] = '\0';
+}
+
+static int check_sensor_temps(const char *boot_id, int discoveries, double cpu, const char *what) {
+    struct cf_sensor_temps temps;
+    cf_read_sensor_temps(boot_id, fake_discover_sensors, &temps);
+    if (g_sensor_discoveries != discoveries || !temps.have_cpu || temps.cpu != cpu || temps.have_gpu) {
+        fprintf(stderr, "sensor cache: %s\n", what);
+        return 1;
+    }
+    return 0;
+}
+
+static int test_sensor_cache(void) {
+    char root[] = "/tmp/cupidfetch-sensors-XXXXXX";
+    if (!mkdtemp(root)) {
+        fprintf(stderr, "sensor cache test could not create a temp dir\n");
+        return 1;
+    }
+
+    char cache[128], hwmon1[128], hwmon2[128], path[192];
+    snprintf(cache, sizeof(cache), "%s/cache", root);
+    snprintf(hwmon1, sizeof(hwmon1), "%s/hwmon1_temp", root);
+    snprintf(hwmon2, sizeof(hwmon2), "%s/hwmon2_temp", root);
+
+    int rc = 1;
+    setenv("XDG_CACHE_HOME", cache, 1);
+    if (!cf_write_file_atomic(hwmon1, "45000\n", 6) || !cf_write_file_atomic(hwmon2, "52500\n", 6)) goto out;
+    g_sensor_discoveries = 0;
+    snprintf(g_sensor_cpu_file, sizeof(g_sensor_cpu_file), "%s", hwmon1);
+
+    if (check_sensor_temps("boot-a", 1, 45.0, "an empty cache should run discovery") != 0) goto out;
+    // Discovery now points elsewhere, so only a cache hit still reads hwmon1.
+    snprintf(g_sensor_cpu_file, sizeof(g_sensor_cpu_file), "%s", hwmon2);
+    if (check_sensor_temps("boot-a", 1, 45.0, "the same boot should be answered from the cache") != 0) goto out;
+    if (check_sensor_temps("boot-b", 2, 52.5, "a new boot_id should invalidate the cache") != 0) goto out;
+    if (check_sensor_temps("boot-b", 2, 52.5, "the rediscovered paths should be cached") != 0) goto out;
+
+    // hwmon2 going away (driver reload) sends the same boot back to discovery.
+    snprintf(g_sensor_cpu_file, sizeof(g_sensor_cpu_file), "%s", hwmon1);
+    if (unlink(hwmon2) != 0) goto out;
+    if (check_sensor_temps("boot-b", 3, 45.0, "a vanished cached path should be rediscovered") != 0) goto out;
+    if (check_sensor_temps("boot-b", 3, 45.0, "the refreshed paths should be cached") != 0) goto out;
+
+    rc = 0;
+out:
+    unsetenv("XDG_CACHE_HOME");
+    unlink(hwmon1);
+    unlink(hwmon2);
+    snprintf(path, sizeof(path), "%s/cupidfetch/sensors.cache", cache);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/cupidfetch", cache);
+    rmdir(path);
+    rmdir(cache);
+    rmdir(root);
+    return rc;
+}
+
+static int test_command_runner(void) {
+    if (cf_command_needs_shell("lspci -s 0000:03:00.0 2>/dev/null") || cf_command_needs_shell("dpkg-query -W -f=x") ||
+        !cf_command_needs_shell("dpkg -l | wc -l") || !cf_command_needs_shell("equery -q list '*'") ||
+        !cf_command_needs_shell("LC_ALL=C rpm -qa") || !cf_command_needs_shell("echo hi > /tmp/x")) {
+        fprintf(stderr, "command runner misjudged which commands need a shell\n");
+        return 1;
+    }
+
+    char direct_out[64];
+    char shell_out[64];
+    char first_out[64];
+    struct cf_command runs[5];
+    memset(runs, 0, sizeof(runs));
+    runs[0].command = "echo one two 2>/dev/null";
+    runs[0].output = direct_out;
+    runs[0].output_size = sizeof(direct_out);
+    runs[1].command = "echo a; echo b; printf c";
+    runs[1].output = shell_out;
+    runs[1].output_size = sizeof(shell_out);
+    runs[2].command = "yes";
+    runs[2].first_line = true;
+    runs[2].output = first_out;
+    runs[2].output_size = sizeof(first_out);
+    runs[3].command = "sleep 5";
+    runs[3].timeout_ms = 200;
+    runs[4].command = "cupidfetch-no-such-command --flag";
+
+    // Launched together, so the whole set takes as long as the sleep's
+    // deadline rather than the sleep.
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    size_t ok = cf_run_commands(runs, 5);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double elapsed = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    if (ok != 3 || strcmp(direct_out, "one two\n") != 0 || runs[0].lines != 1 || runs[0].exit_status != 0) {
+        fprintf(stderr, "command runner should run a plain command directly\n");
+        return 1;
+    }
+    if (strcmp(shell_out, "a\nb\nc") != 0 || runs[1].lines != 3) {
+        fprintf(stderr, "command runner should hand shell syntax to /bin/sh\n");
+        return 1;
+    }
+    if (strncmp(first_out, "y\n", 2) != 0 || runs[2].exit_status != 0) {
+        fprintf(stderr, "command runner should stop a first_line command after its line\n");
+        return 1;
+    }
+    if (!runs[3].timed_out || runs[3].exit_status != -1 || elapsed > 2.0) {
+        fprintf(stderr, "command runner should kill a command at its deadline (%.2fs)\n", elapsed);
+        return 1;
+    }
+    if (runs[4].exit_status == 0 || runs[4].timed_out) {
+        fprintf(stderr, "command runner should report a missing command as failed\n");
+        return 1;
+    }
+
+    // Well past one read chunk and the old 16 KB lspci buffer.
+    struct cf_command grown;
+    memset(&grown, 0, sizeof(grown));
+    grown.command = "seq 1 20000";
+    grown.grow_output = true;
+    bool grown_ok = cf_run_command(&grown) && grown.lines == 20000 && grown.output_len == strlen(grown.output) &&
+                    grown.output_len > 16384 && strcmp(grown.output + grown.output_len - 6, "20000\n") == 0;
+    free(grown.output);
+    if (!grown_ok) {
+        fprintf(stderr, "command runner should grow the output buffer until EOF\n");
+        return 1;
+    }
+    return 0;
+}
+
+static int test_utf8_char_width(void) {
+    static const struct {
+        const char *text;
+        int width;
+        size_t consumed;
+    } cases[] = {
+        {"a", 1, 1},
+        {"\xc3\xa9", 1, 2},          // e acute
+        {"\xcc\x81", 0, 2},          // combining acute accent
+        {"\xe4\xb8\xad", 2, 3},      // CJK
+        {"\xf0\x9f\x90\xb1", 2, 4},  // cat face emoji
+        {"\xe2\x94\x80", 1, 3},      // box drawing
+        {"\xc0\xaf", 1, 1},          // overlong
+        {"\xed\xa0\x80", 1, 1},      // surrogate
+        {"\xe4\xb8", 1, 1},          // truncated
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        size_t consumed = 0;
+        int width = cf_utf8_char_width(cases[i].text, strlen(cases[i].text), &consumed);
+        if (width != cases[i].width || consumed != cases[i].consumed) {
+            fprintf(stderr, "utf8_char_width case %zu gave width %d over %zu bytes\n", i, width, consumed);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void *lookup_executables(void *arg) {
+    bool *ok = arg;
+    for (int i = 0; i < 500 && *ok; i++) {
+        if (!cf_executable_in_path("sh") || cf_executable_in_path("cupidfetch-no-such-command")) *ok = false;
+    }
+    return NULL;
+}
+
+static int test_concurrent_helpers(void) {
+    pthread_t threads[4];
+    bool ok[4];
+    size_t started = 0;
+    for (; started < 4; started++) {
+        ok[started] = true;
+        if (pthread_create(&threads[started], NULL, lookup_executables, &ok[started]) != 0) break;
+    }
+    bool all_ok = started == 4;
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        all_ok = all_ok && ok[i];
+    }
+    if (!all_ok) {
+        fprintf(stderr, "executable lookups should agree across threads\n");
+        return 1;
+    }
+
+    // Each caller's sample is its own: one fetch can't skew another's rate.
+    struct cf_cpu_sample first = {false, 0, 0};
+    struct cf_cpu_sample second = {false, 0, 0};
+    double usage = -1.0;
+    if (!cf_detect_cpu_usage_percent(&first, &usage) || usage < 0.0 || usage > 100.0 || !first.valid ||
+        second.valid || !cf_detect_cpu_usage_percent(NULL, &usage)) {
+        fprintf(stderr, "cpu usage should fill only the caller's sample\n");
+        return 1;
+    }
+    return 0;
+}
+
 int main(void) {
     if (cf_convert_bytes_to_unit(2048ULL, 1024UL) != 2UL) {
         fprintf(stderr, "convert 2048/1024 should be 2\n");
@@ -18,6 +587,17 @@ int main(void) {
         return 1;
     }
 
+    if (test_top_heap() != 0) return 1;
+    if (test_display_socket_peer() != 0) return 1;
+    if (test_scan_process_label() != 0) return 1;
+    if (test_arena() != 0) return 1;
+    if (test_read_batch() != 0) return 1;
+    if (test_path_index() != 0) return 1;
+    if (test_sensor_cache() != 0) return 1;
+    if (test_command_runner() != 0) return 1;
+    if (test_utf8_char_width() != 0) return 1;
+    if (test_concurrent_helpers() != 0) return 1;
+
     printf("test_units: OK\n");
     return 0;
 }
@@ -0,0 +1,164 @@
+// Turns data/distros.def into src/distro_table_data.h: the entries as a
+// const array plus two perfect-hash slot tables (by os-release ID and by
+// display name), so distro lookups need neither the file nor a scan.
+//
+//   gen_distro_table data/distros.def src/distro_table_data.h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/distro_table.h"
+#include "../src/modules/common/module_helpers.h"
+
+#define GEN_MAX_ENTRIES 512
+#define GEN_MAX_SEED_TRIES 1000000u
+
+struct gen_entry {
+    char id[64];
+    char name[128];
+    char pkgcmd[128];
+};
+
+static struct gen_entry g_entries[GEN_MAX_ENTRIES];
+static size_t g_count;
+
+static bool id_seen(const char *id) {
+    for (size_t i = 0; i < g_count; i++) {
+        if (strcmp(g_entries[i].id, id) == 0) return true;
+    }
+    return false;
+}
+
+static bool read_def(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return false;
+    }
+
+    char line[512];
+    while (fgets(line, sizeof(line), fp)) {
+        struct gen_entry entry;
+        if (!cf_parse_distro_def_line(line, entry.id, sizeof(entry.id), entry.name, sizeof(entry.name),
+                                      entry.pkgcmd, sizeof(entry.pkgcmd))) {
+            continue;
+        }
+        // The runtime scan returned the first match; keep that one.
+        if (!entry.id[0] || id_seen(entry.id)) continue;
+        if (g_count == GEN_MAX_ENTRIES) {
+            fprintf(stderr, "%s: more than %d entries\n", path, GEN_MAX_ENTRIES);
+            fclose(fp);
+            return false;
+        }
+        g_entries[g_count++] = entry;
+    }
+    fclose(fp);
+    return true;
+}
+
+static const char *entry_key(const struct gen_entry *entry, bool by_name) {
+    return by_name ? entry->name : entry->id;
+}
+
+// Finds a seed under which every distinct key lands in its own slot.
+// Repeated names map to their first entry, as the old lookups did.
+static bool build_slots(bool by_name, int *slots, size_t *slot_count_out, uint32_t *seed_out) {
+    for (size_t slot_count = 16; slot_count <= 65536; slot_count *= 2) {
+        if (slot_count < g_count * 2) continue;
+        for (uint32_t seed = 1; seed < GEN_MAX_SEED_TRIES; seed++) {
+            bool collided = false;
+            for (size_t s = 0; s < slot_count; s++) slots[s] = -1;
+            for (size_t i = 0; i < g_count && !collided; i++) {
+                const char *key = entry_key(&g_entries[i], by_name);
+                size_t slot = cf_distro_hash(key, seed) & (slot_count - 1);
+                if (slots[slot] < 0) {
+                    slots[slot] = (int)i;
+                } else if (strcmp(entry_key(&g_entries[slots[slot]], by_name), key) != 0) {
+                    collided = true;
+                }
+            }
+            if (!collided) {
+                *slot_count_out = slot_count;
+                *seed_out = seed;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void write_c_string(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const unsigned char *p = (const unsigned char *)text; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(out, "\\%c", *p);
+        } else if (*p == '?') {
+            fputs("\\?", out);
+        } else if (*p < 0x20 || *p >= 0x7f) {
+            fprintf(out, "\\%03o", *p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void write_slots(FILE *out, const char *name, const int *slots, size_t slot_count) {
+    fprintf(out, "static const short %s[%zu] = {", name, slot_count);
+    for (size_t s = 0; s < slot_count; s++) {
+        fprintf(out, "%s%d%s", s % 16 == 0 ? "\n    " : " ", slots[s], s + 1 < slot_count ? "," : "\n");
+    }
+    fputs("};\n", out);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <distros.def> <output.h>\n", argv[0]);
+        return 1;
+    }
+    if (!read_def(argv[1])) return 1;
+
+    static int id_slots[65536];
+    static int name_slots[65536];
+    size_t id_slot_count = 0;
+    size_t name_slot_count = 0;
+    uint32_t id_seed = 0;
+    uint32_t name_seed = 0;
+    if (!build_slots(false, id_slots, &id_slot_count, &id_seed) ||
+        !build_slots(true, name_slots, &name_slot_count, &name_seed)) {
+        fprintf(stderr, "%s: no perfect hash found\n", argv[1]);
+        return 1;
+    }
+
+    FILE *out = fopen(argv[2], "w");
+    if (!out) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    fprintf(out, "// Generated from data/distros.def by tools/gen_distro_table.c; do not edit.\n\n");
+    fprintf(out, "#define CF_DISTRO_ID_SEED %uu\n", id_seed);
+    fprintf(out, "#define CF_DISTRO_NAME_SEED %uu\n\n", name_seed);
+    fprintf(out, "static const struct cf_distro_def cf_builtin_distros[%zu] = {\n", g_count ? g_count : 1);
+    for (size_t i = 0; i < g_count; i++) {
+        fputs("    {", out);
+        write_c_string(out, g_entries[i].id);
+        fputs(", ", out);
+        write_c_string(out, g_entries[i].name);
+        fputs(", ", out);
+        write_c_string(out, g_entries[i].pkgcmd);
+        fputs("},\n", out);
+    }
+    if (g_count == 0) fputs("    {\"\", \"\", \"\"},\n", out);
+    fputs("};\n\n", out);
+    write_slots(out, "cf_distro_id_slots", id_slots, id_slot_count);
+    fputc('\n', out);
+    write_slots(out, "cf_distro_name_slots", name_slots, name_slot_count);
+
+    if (fclose(out) != 0) {
+        perror(argv[2]);
+        return 1;
+    }
+    return 0;
+}